@@ -28,14 +28,16 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <Open3D/Core/Integration/TSDFVolume.h>
+#include <Open3D/Core/Integration/VoxelBlockPool.h>
+#include <Open3D/Core/Integration/VoxelBlockStore.h>
 #include <Open3D/Core/Utility/Helper.h>
 
 namespace open3d {
 
-class UniformTSDFVolume;
-
 /// Class that implements a more memory efficient data structure for volumetric
 /// integration
 /// This implementation is based on the following repository:
@@ -53,19 +55,46 @@ class UniformTSDFVolume;
 /// normal and producing a smooth surface output. The carving is great in
 /// removing outlier structures like floating noise pixels and bumps along
 /// structure edges.
+///
+/// In streaming mode, volume units far from the camera are moved out of
+/// memory into a VoxelBlockStore on local disk, which bounds the resident
+/// memory for large scenes.
 
 class ScalableTSDFVolume : public TSDFVolume {
 public:
-    struct VolumeUnit {
-    public:
-        VolumeUnit() : volume_(NULL) {}
+    /// Storage format of the voxels. The compact formats store the tsdf as
+    /// 16-bit fixed point, a saturating integer weight and 8-bit RGB color,
+    /// at the cost of a quantized average.
+    enum class VoxelFormat {
+        /// float tsdf and weight, float RGB: 8 bytes, 20 bytes with color
+        Float = 0,
+        /// 16-bit tsdf and weight, 8-bit RGB: 4 bytes, 8 bytes with color
+        Compact16 = 1,
+        /// 16-bit tsdf, 8-bit weight and RGB: 4 bytes, 6 bytes with color
+        Compact8 = 2,
+    };
+
+    /// Struct that describes how the mesh of the volume changed since the
+    /// previous incremental extraction. A client that keeps one mesh per
+    /// volume unit drops the meshes of removed_units_ first, then adds
+    /// added_meshes_[i] for added_units_[i]. The mesh of a unit is self
+    /// contained: vertices on the unit boundary are repeated in the meshes of
+    /// the adjacent units.
+    struct MeshDelta {
     public:
-        std::shared_ptr<UniformTSDFVolume> volume_;
-        Eigen::Vector3i index_;
+        std::vector<Eigen::Vector3i> removed_units_;
+        std::vector<Eigen::Vector3i> added_units_;
+        std::vector<std::shared_ptr<TriangleMesh>> added_meshes_;
     };
+
 public:
     ScalableTSDFVolume(double voxel_length, double sdf_trunc, bool with_color,
-            int32_t volume_unit_resolution = 16, int32_t depth_sampling_stride = 4);
+            int32_t volume_unit_resolution = 16, int32_t depth_sampling_stride = 4,
+            VoxelFormat voxel_format = VoxelFormat::Float);
+    /// The copy holds all volume units in memory, including the ones in the
+    /// block store of volume, and does not stream.
+    ScalableTSDFVolume(const ScalableTSDFVolume &volume);
+    ScalableTSDFVolume &operator=(const ScalableTSDFVolume &) = delete;
     ~ScalableTSDFVolume() override;
 
 public:
@@ -75,32 +104,202 @@ public:
             const Eigen::Matrix4d &extrinsic) override;
     std::shared_ptr<PointCloud> ExtractPointCloud() override;
     std::shared_ptr<TriangleMesh> ExtractTriangleMesh() override;
+    std::shared_ptr<TSDFRaycastImage> Raycast(
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic, double depth_min = 0.1,
+            double depth_max = 3.0) override;
     std::shared_ptr<PointCloud> ExtractVoxelPointCloud();
 
+    /// Function to extract a triangle mesh from a per-unit mesh cache. Only
+    /// the units modified by Integrate() since the previous incremental
+    /// extraction, and their neighbors, are meshed again. The result is the
+    /// same as ExtractTriangleMesh().
+    std::shared_ptr<TriangleMesh> ExtractTriangleMeshIncremental();
+
+    /// Function to update the per-unit mesh cache like
+    /// ExtractTriangleMeshIncremental(), and to return only the units whose
+    /// mesh changed
+    MeshDelta ExtractTriangleMeshDelta();
+
+    /// Function to enable out-of-core streaming. After every Integrate(), the
+    /// volume units not touched by the frame and farther than 1.25 times
+    /// streaming_radius from the camera center are written to a block store
+    /// in the file block_store_path and released.
+    /// Units are loaded again when Integrate() touches them. The extraction
+    /// functions load the stored units chunk by chunk, while Raycast() only
+    /// sees the units in memory. Returns false if the file cannot be created.
+    bool EnableStreaming(const std::string &block_store_path,
+            double streaming_radius);
+
+    /// Function to load all stored volume units and stop streaming
+    void DisableStreaming();
+
+    bool IsStreaming() const { return block_store_ != NULL; }
+
+    /// Function to return the number of volume units in memory and in the
+    /// block store
+    size_t NumberOfVolumeUnits() const;
+
+    /// Function to return the indices of all volume units, in memory or in
+    /// the block store
+    std::vector<Eigen::Vector3i> GetVolumeUnitIndices() const;
+
+    /// Function to copy the voxels of the unit at index, in memory or in the
+    /// block store, into data of volume_units_.BlockBytes() bytes. It can be
+    /// called from multiple threads.
+    bool CopyVolumeUnit(const Eigen::Vector3i &index, uint8_t *data) const;
+
+    /// Function to activate the unit at index in memory, so that its voxels
+    /// can be written directly, e.g. when the volume is read from a file.
+    /// The unit is meshed again by the next incremental extraction. Returns
+    /// the block id of the unit in volume_units_.
+    int32_t ActivateVolumeUnit(const Eigen::Vector3i &index);
+
 public:
     int32_t volume_unit_resolution_;
     double volume_unit_length_;
     int32_t depth_sampling_stride_;
+    VoxelFormat voxel_format_;
+    double streaming_radius_;
 
     /// Assume the index of the volume unit is (x, y, z), then the unit spans
     /// from (x, y, z) * volume_unit_length_
     /// to (x + 1, y + 1, z + 1) * volume_unit_length_
-    std::unordered_map<Eigen::Vector3i, VolumeUnit,
-            hash_eigen::hash<Eigen::Vector3i>> volume_units_;
+    /// Each unit is a block of volume_unit_resolution_^3 voxels in x-major
+    /// order. A voxel stores tsdf and weight, followed by RGB color if
+    /// with_color_ is true, in the layout given by voxel_format_.
+    VoxelBlockPool volume_units_;
 
 private:
-    Eigen::Vector3i LocateVolumeUnit(const Eigen::Vector3d &point) {
+    /// Struct that holds the marching cubes output of a volume unit: the
+    /// vertices on the edges owned by the unit, sorted by edge key
+    /// ((x * resolution + y) * resolution + z) * 3 + axis, and triangles whose
+    /// corners are encoded as edge key * 8 + neighbor, where bit 0, 1 and 2 of
+    /// neighbor select the next unit in x, y and z.
+    struct VolumeUnitMesh {
+    public:
+        std::vector<int32_t> vertex_keys_;
+        std::vector<Eigen::Vector3d> vertices_;
+        std::vector<Eigen::Vector3d> vertex_colors_;
+        std::vector<Eigen::Vector3i> triangles_;
+    };
+
+private:
+    Eigen::Vector3i LocateVolumeUnit(const Eigen::Vector3d &point) const {
         return Eigen::Vector3i(static_cast<Eigen::Vector3i::Scalar>(std::floor(point(0) / volume_unit_length_)),
                 static_cast<Eigen::Vector3i::Scalar>(std::floor(point(1) / volume_unit_length_)),
                 static_cast<Eigen::Vector3i::Scalar>(std::floor(point(2) / volume_unit_length_)));
     }
 
-    std::shared_ptr<UniformTSDFVolume> OpenVolumeUnit(
-            const Eigen::Vector3i &index);
-
     Eigen::Vector3d GetNormalAt(const Eigen::Vector3d &p);
 
     double GetTSDFAt(const Eigen::Vector3d &p);
+
+    /// Function to find the volume units that Integrate() touches. The ray
+    /// segment within sdf_trunc_ of every sampled depth pixel is traversed
+    /// through the unit grid in parallel.
+    std::vector<Eigen::Vector3i> LocateTouchedVolumeUnits(const Image &depth,
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic,
+            const Image &depth_to_camera_distance_multiplier) const;
+
+    template <typename VoxelType>
+    void IntegrateVolumeUnits(const RGBDImage &image,
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic,
+            const Image &depth_to_camera_distance_multiplier,
+            const std::vector<int32_t> &block_ids);
+
+    template <typename VoxelType>
+    void ExtractPointCloudImpl(const std::vector<int32_t> &block_ids,
+            PointCloud &pointcloud);
+
+    template <typename VoxelType>
+    void ExtractVolumeUnitMesh(int32_t block_id, VolumeUnitMesh &unit_mesh);
+
+    /// Function to mesh the modified units and their neighbors again, and to
+    /// return their indices. had_triangles tells if the previous mesh of each
+    /// of them had triangles.
+    template <typename VoxelType>
+    std::vector<Eigen::Vector3i> UpdateVolumeUnitMeshes(
+            std::vector<uint8_t> &had_triangles);
+
+    std::shared_ptr<TriangleMesh> StitchVolumeUnitMeshes(
+            const std::vector<Eigen::Vector3i> &indices,
+            const std::vector<const VolumeUnitMesh *> &unit_meshes) const;
+
+    /// Function to return the cached mesh of the unit at index, in memory or
+    /// stored, or NULL
+    const VolumeUnitMesh *FindVolumeUnitMesh(const Eigen::Vector3i &index)
+            const;
+
+    /// Function to find the mesh owning an encoded triangle corner of the
+    /// unit at index, and the index of the vertex in it
+    bool FindVolumeUnitMeshVertex(const Eigen::Vector3i &index,
+            int32_t corner, const VolumeUnitMesh *&owner_mesh,
+            int32_t &vertex_index) const;
+
+    template <typename VoxelType>
+    void ExtractVoxelPointCloudImpl(const std::vector<int32_t> &block_ids,
+            PointCloud &pointcloud);
+
+    template <typename VoxelType>
+    double GetTSDFAtImpl(const Eigen::Vector3d &p);
+
+    template <typename VoxelType>
+    std::shared_ptr<TSDFRaycastImage> RaycastImpl(
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic, double depth_min,
+            double depth_max);
+
+    /// Function to load the units at indices from block_store into memory
+    void LoadVolumeUnits(const std::vector<Eigen::Vector3i> &indices,
+            const VoxelBlockStore &block_store);
+
+    /// Function to write a unit to the block store unless the store has an
+    /// up-to-date copy, and to release it
+    void EvictVolumeUnit(int32_t block_id);
+
+    /// Function to release a unit and to move the per-unit state of the last
+    /// unit into its block id
+    void EraseVolumeUnit(int32_t block_id);
+
+    /// Function to load the stored units among indices, and among their
+    /// neighbors if with_neighbors is true. Returns the loaded units.
+    std::vector<Eigen::Vector3i> LoadStoredVolumeUnits(
+            const std::vector<Eigen::Vector3i> &indices, bool with_neighbors);
+
+    void EvictVolumeUnits(const std::vector<Eigen::Vector3i> &indices);
+
+    /// Function to group all units, in memory or stored, into chunks of
+    /// nearby units
+    std::vector<std::vector<Eigen::Vector3i>> GetVolumeUnitChunks() const;
+
+    bool HasVolumeUnit(const Eigen::Vector3i &index) const {
+        return volume_units_.Find(index) >= 0 || (block_store_ != NULL &&
+                block_store_->Contains(index));
+    }
+
+private:
+    /// Per-unit mesh cache of the incremental extraction, indexed by block id
+    std::vector<VolumeUnitMesh> unit_meshes_;
+    /// Flags of the units modified since the previous incremental extraction
+    std::vector<uint8_t> unit_modified_;
+    /// Units whose cached mesh was dropped by Reset()
+    std::vector<Eigen::Vector3i> reset_units_;
+
+    /// Block store of the streaming mode, NULL if not streaming
+    std::shared_ptr<VoxelBlockStore> block_store_;
+    /// Flags of the units in memory that have an up-to-date copy in the block
+    /// store
+    std::vector<uint8_t> unit_stored_;
+    /// Cached meshes of the units that are only in the block store
+    std::unordered_map<Eigen::Vector3i, VolumeUnitMesh,
+            hash_eigen::hash<Eigen::Vector3i>> stored_unit_meshes_;
+    /// Units only in the block store that were modified since the previous
+    /// incremental extraction
+    std::unordered_set<Eigen::Vector3i, hash_eigen::hash<Eigen::Vector3i>>
+            stored_modified_units_;
 };
 
 }   // namespace open3d
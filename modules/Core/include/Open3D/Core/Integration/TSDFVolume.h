@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <Open3D/Core/Geometry/RGBDImage.h>
 #include <Open3D/Core/Geometry/PointCloud.h>
 #include <Open3D/Core/Geometry/TriangleMesh.h>
@@ -34,6 +36,20 @@
 
 namespace open3d {
 
+/// Class that holds the images rendered from a TSDFVolume by raycasting
+/// depth_ is a float image of the depth in meters, 0 where the ray does not
+/// hit a surface. vertex_ and normal_ are 3-channel float images of the
+/// surface points and normals in world coordinates. color_ is an 8-bit RGB
+/// image, left empty if the volume has no color.
+class TSDFRaycastImage
+{
+public:
+    Image depth_;
+    Image vertex_;
+    Image normal_;
+    Image color_;
+};
+
 /// Interface class of the Truncated Signed Distance Function (TSDF) volume
 /// This volume is usually used to integrate surface data (e.g., a series of
 /// RGB-D images) into a Mesh or PointCloud. The basic technique is presented in
@@ -66,10 +82,39 @@ public:
     /// (https://en.wikipedia.org/wiki/Marching_cubes)
     virtual std::shared_ptr<TriangleMesh> ExtractTriangleMesh() = 0;
 
+    /// Function to render the surface seen by a camera, by marching along the
+    /// ray of every pixel until the TSDF changes from positive to negative.
+    /// The zero crossing is refined with trilinear interpolation.
+    virtual std::shared_ptr<TSDFRaycastImage> Raycast(
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic, double depth_min = 0.1,
+            double depth_max = 3.0) = 0;
+
+    /// Function to integrate frame_num frames in order. load_frame(i, image,
+    /// extrinsic) reads frame i, and returns false to end the sequence early.
+    /// It runs on a separate thread up to prefetch_num frames ahead, so that
+    /// reading and decoding the images overlap with the integration. An
+    /// exception thrown by load_frame ends the sequence and is rethrown here
+    /// after the frames loaded before it are integrated.
+    /// Returns the number of integrated frames.
+    int32_t IntegrateSequence(const PinholeCameraIntrinsic &intrinsic,
+            int32_t frame_num, const std::function<bool(int32_t, RGBDImage &,
+            Eigen::Matrix4d &)> &load_frame, int32_t prefetch_num = 2);
+
+protected:
+    /// Function to return the depth to camera distance multiplier image of
+    /// intrinsic. The image is kept until a different intrinsic is used.
+    const Image &GetDepthToCameraDistanceMultiplier(
+            const PinholeCameraIntrinsic &intrinsic);
+
 public:
     double voxel_length_;
     double sdf_trunc_;
     bool with_color_;
+
+private:
+    PinholeCameraIntrinsic multiplier_intrinsic_;
+    std::shared_ptr<Image> depth_to_camera_distance_multiplier_;
 };
 
 }   // namespace open3d
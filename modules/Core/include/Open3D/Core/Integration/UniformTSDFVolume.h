@@ -44,6 +44,10 @@ public:
             const Eigen::Matrix4d &extrinsic) override;
     std::shared_ptr<PointCloud> ExtractPointCloud() override;
     std::shared_ptr<TriangleMesh> ExtractTriangleMesh() override;
+    std::shared_ptr<TSDFRaycastImage> Raycast(
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic, double depth_min = 0.1,
+            double depth_max = 3.0) override;
 
     /// Debug function to extract the voxel data into a point cloud
     std::shared_ptr<PointCloud> ExtractVoxelPointCloud();
@@ -0,0 +1,127 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+
+namespace open3d {
+
+/// Class that stores the voxel blocks of a sparse volume.
+/// Blocks have a fixed size in bytes and live in large contiguous arenas, so
+/// that allocating a block never moves the others and scans over many blocks
+/// stay cache friendly. Blocks are addressed by their integer 3D index
+/// through an open-addressing hash table with linear probing.
+/// Block ids are dense: they run from 0 to NumberOfBlocks() - 1 in allocation
+/// order, and Erase() keeps them dense by moving the last block into the
+/// erased one. Find() and the data accessors can be called concurrently;
+/// Activate(), Erase() and Clear() cannot.
+class VoxelBlockPool
+{
+public:
+    VoxelBlockPool(size_t block_bytes, size_t arena_block_num = 64);
+    ~VoxelBlockPool();
+
+public:
+    /// Function to release all blocks and arenas
+    void Clear();
+
+    /// Function to reserve hash table slots for block_num blocks in total
+    void Reserve(size_t block_num);
+
+    /// Function to find the id of the block at index, -1 if not allocated
+    int32_t Find(const Eigen::Vector3i &index) const {
+        size_t slot = Hash(index);
+        while (true) {
+            const HashEntry &entry = hash_table_[slot];
+            if (entry.block_id_ < 0) {
+                return -1;
+            }
+            if (entry.index_ == index) {
+                return entry.block_id_;
+            }
+            slot = (slot + 1) & hash_mask_;
+        }
+    }
+
+    /// Function to find or allocate the block at index. A new block is
+    /// zero-filled.
+    int32_t Activate(const Eigen::Vector3i &index);
+
+    /// Function to release the block block_id. The last block is moved into
+    /// its place and takes over its id.
+    void Erase(int32_t block_id);
+
+    size_t NumberOfBlocks() const { return block_indices_.size(); }
+    size_t BlockBytes() const { return block_bytes_; }
+
+    /// Function to return the memory held by the arenas and the hash table
+    size_t MemoryUsage() const;
+
+    const Eigen::Vector3i &GetBlockIndex(int32_t block_id) const {
+        return block_indices_[block_id];
+    }
+
+    uint8_t *GetBlockData(int32_t block_id) {
+        return arenas_[block_id / arena_block_num_].data() +
+                (block_id % arena_block_num_) * block_bytes_;
+    }
+
+    const uint8_t *GetBlockData(int32_t block_id) const {
+        return arenas_[block_id / arena_block_num_].data() +
+                (block_id % arena_block_num_) * block_bytes_;
+    }
+
+private:
+    struct HashEntry {
+        Eigen::Vector3i index_;
+        int32_t block_id_;
+    };
+
+    size_t Hash(const Eigen::Vector3i &index) const {
+        uint32_t h = static_cast<uint32_t>(index(0)) * 73856093u ^
+                static_cast<uint32_t>(index(1)) * 19349669u ^
+                static_cast<uint32_t>(index(2)) * 83492791u;
+        return static_cast<size_t>((h * 2654435769u) >> hash_shift_);
+    }
+
+    void Rehash(size_t slot_num);
+
+private:
+    size_t block_bytes_;
+    size_t arena_block_num_;
+    std::vector<std::vector<uint8_t>> arenas_;
+    std::vector<Eigen::Vector3i> block_indices_;
+    std::vector<HashEntry> hash_table_;
+    size_t hash_mask_;
+    uint32_t hash_shift_;
+};
+
+}   // namespace open3d
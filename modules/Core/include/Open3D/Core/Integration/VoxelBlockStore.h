@@ -0,0 +1,130 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+
+#include <Open3D/Core/Utility/Helper.h>
+
+namespace open3d {
+
+/// Class that keeps voxel blocks in a file on local disk, for volumes that
+/// stream blocks out of memory.
+/// Blocks have a fixed size in bytes and are addressed by their integer 3D
+/// index. Write() only queues a copy of the block; a background thread
+/// compresses it with LZF and writes it to the file. Read() returns queued
+/// blocks from memory, so a block can be read back at any time after it has
+/// been written. The space of erased or rewritten blocks is reused by later
+/// writes. The file is removed when the store is destroyed.
+/// Read(), Contains() and NumberOfBlocks() can be called concurrently;
+/// Write(), Erase() and Clear() cannot.
+class VoxelBlockStore
+{
+public:
+    VoxelBlockStore(const std::string &filename, size_t block_bytes);
+    ~VoxelBlockStore();
+    VoxelBlockStore(const VoxelBlockStore &) = delete;
+    VoxelBlockStore &operator=(const VoxelBlockStore &) = delete;
+
+public:
+    bool IsOpen() const { return file_ != NULL; }
+
+    /// Function to queue the block at index for writing, replacing the
+    /// stored one if any
+    void Write(const Eigen::Vector3i &index, const uint8_t *data);
+
+    /// Function to read the block at index into data, returns false if the
+    /// store does not have it
+    bool Read(const Eigen::Vector3i &index, uint8_t *data) const;
+
+    void Erase(const Eigen::Vector3i &index);
+    bool Contains(const Eigen::Vector3i &index) const;
+    size_t NumberOfBlocks() const;
+    std::vector<Eigen::Vector3i> GetBlockIndices() const;
+
+    /// Function to wait until all queued blocks are written
+    void Flush();
+
+    /// Function to erase all blocks
+    void Clear();
+
+    size_t BlockBytes() const { return block_bytes_; }
+
+    /// Function to return the size of the file, including reusable space
+    int64_t FileSize() const;
+
+private:
+    struct BlockRecord {
+        int64_t offset_;
+        uint32_t size_;
+        uint32_t capacity_;
+    };
+
+    void WriterLoop();
+
+    /// Function to take space for size bytes in the file
+    BlockRecord AllocateRecord(uint32_t size);
+    void ReleaseRecord(const BlockRecord &record);
+
+private:
+    std::string filename_;
+    size_t block_bytes_;
+    std::FILE *file_;
+    int64_t file_size_;
+
+    std::unordered_map<Eigen::Vector3i, BlockRecord,
+            hash_eigen::hash<Eigen::Vector3i>> records_;
+    /// Blocks queued for writing, with the write queue in order
+    std::unordered_map<Eigen::Vector3i, std::shared_ptr<std::vector<uint8_t>>,
+            hash_eigen::hash<Eigen::Vector3i>> pending_;
+    std::deque<Eigen::Vector3i> queue_;
+    /// Reusable space in the file, by capacity
+    std::multimap<uint32_t, int64_t> free_records_;
+
+    mutable std::mutex mutex_;
+    mutable std::mutex file_mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable flush_cv_;
+    bool writing_;
+    bool stop_;
+    std::thread writer_;
+};
+
+}   // namespace open3d
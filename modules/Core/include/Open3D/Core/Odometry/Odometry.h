@@ -35,13 +35,44 @@
 #include <Open3D/Core/Odometry/OdometryOption.h>
 #include <Open3D/Core/Odometry/RGBDOdometryJacobian.h>
 #include <Open3D/Core/Camera/PinholeCameraIntrinsic.h>
+#include <Open3D/Core/Geometry/RGBDImage.h>
 #include <Open3D/Core/Utility/Eigen.h>
 
 namespace open3d {
 
-class RGBDImage;
+/// Class that holds an RGB-D image preprocessed once for odometry: the
+/// filtered intensity and depth pyramids, their Sobel gradients and the 3D
+/// vertex map of every level. In a sequence, a frame can be the target of one
+/// ComputeRGBDOdometry call and the source of the next one without being
+/// processed twice. The number of levels and the depth range come from the
+/// option, which should be the one passed to ComputeRGBDOdometry.
+class OdometryFrame
+{
+public:
+    OdometryFrame() {}
+    OdometryFrame(const RGBDImage &image,
+            const PinholeCameraIntrinsic &pinhole_camera_intrinsic =
+            PinholeCameraIntrinsic(),
+            const OdometryOption &option = OdometryOption());
+    ~OdometryFrame();
+    OdometryFrame(const OdometryFrame &) = delete;
+    OdometryFrame &operator=(const OdometryFrame &) = delete;
 
-/// Function to estimate 6D odometry between two RGB-D images
+public:
+    bool IsEmpty() const;
+    size_t NumberOfLevels() const { return pyramid_.size(); }
+
+public:
+    PinholeCameraIntrinsic intrinsic_;
+    std::vector<Eigen::Matrix3d> camera_matrix_pyramid_;
+    /// Intensity and depth, not yet normalized for a pair of frames
+    RGBDImagePyramid pyramid_;
+    RGBDImagePyramid pyramid_dx_;
+    RGBDImagePyramid pyramid_dy_;
+    ImagePyramid xyz_pyramid_;
+};
+
+/// Functions to estimate 6D odometry between two RGB-D images
 /// output: is_success, 4x4 motion matrix, 6x6 information matrix
 std::tuple<bool, Eigen::Matrix4d, Eigen::Matrix6d>
         ComputeRGBDOdometry(const RGBDImage &source, const RGBDImage &target,
@@ -52,4 +83,13 @@ std::tuple<bool, Eigen::Matrix4d, Eigen::Matrix6d>
         RGBDOdometryJacobianFromHybridTerm(),
         const OdometryOption &option = OdometryOption());
 
+/// The frames must share their intrinsic, image size and number of levels.
+std::tuple<bool, Eigen::Matrix4d, Eigen::Matrix6d>
+        ComputeRGBDOdometry(const OdometryFrame &source,
+        const OdometryFrame &target,
+        const Eigen::Matrix4d &odo_init = Eigen::Matrix4d::Identity(),
+        const RGBDOdometryJacobian &jacobian_method =
+        RGBDOdometryJacobianFromHybridTerm(),
+        const OdometryOption &option = OdometryOption());
+
 }   // namespace open3d
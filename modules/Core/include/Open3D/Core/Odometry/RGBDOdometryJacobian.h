@@ -62,6 +62,39 @@ public:
             const Eigen::Matrix3d &intrinsic,
             const Eigen::Matrix4d &extrinsic,
             const CorrespondenceSetPixelWise &corresps) const = 0;
+
+    /// Function to compute the rows of J and r for one pixel correspondence
+    /// (u_s, v_s, u_t, v_t), so that correspondences can be consumed as soon
+    /// as they are found. The default implementation calls the function above
+    /// with a correspondence set of one element. The color and hybrid terms
+    /// compute the rows directly, unless the function above is reached
+    /// through a subclass.
+    virtual void ComputePixelJacobianAndResidual(
+            const Eigen::Vector4i &corresp,
+            std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic) const;
+
+    /// Function to add J^T J, J^T r and r^T r of a block of correspondences,
+    /// given as source and target pixel indices (v * width + u), to JTJ, JTr
+    /// and r2_sum. Jacobians with a batch kernel evaluate the block in float
+    /// precision, several correspondences at a time, and return true. The
+    /// default implementation returns false and leaves the sums untouched;
+    /// ComputePixelJacobianAndResidual() is used instead. The color and
+    /// hybrid terms only use their kernel for their own exact type, so that
+    /// the row functions of a subclass are always called.
+    virtual bool AccumulateJTJandJTr(
+            const int32_t *source_indices, const int32_t *target_indices,
+            int32_t count,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic,
+            Eigen::Matrix6d &JTJ, Eigen::Vector6d &JTr, double &r2_sum) const;
 };
 
 /// Function to Compute Jacobian using color term
@@ -85,6 +118,24 @@ public:
             const Eigen::Matrix3d &intrinsic,
             const Eigen::Matrix4d &extrinsic,
             const CorrespondenceSetPixelWise &corresps) const override;
+    void ComputePixelJacobianAndResidual(
+            const Eigen::Vector4i &corresp,
+            std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic) const override;
+    bool AccumulateJTJandJTr(
+            const int32_t *source_indices, const int32_t *target_indices,
+            int32_t count,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic,
+            Eigen::Matrix6d &JTJ, Eigen::Vector6d &JTr,
+            double &r2_sum) const override;
 };
 
 /// Function to Compute Jacobian using hybrid term
@@ -107,6 +158,24 @@ public:
             const Eigen::Matrix3d &intrinsic,
             const Eigen::Matrix4d &extrinsic,
             const CorrespondenceSetPixelWise &corresps) const override;
+    void ComputePixelJacobianAndResidual(
+            const Eigen::Vector4i &corresp,
+            std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic) const override;
+    bool AccumulateJTJandJTr(
+            const int32_t *source_indices, const int32_t *target_indices,
+            int32_t count,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic,
+            Eigen::Matrix6d &JTJ, Eigen::Vector6d &JTr,
+            double &r2_sum) const override;
 };
 
 }   // namespace open3d
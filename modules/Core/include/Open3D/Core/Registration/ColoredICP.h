@@ -45,4 +45,14 @@ RegistrationResult RegistrationColoredICP(const PointCloud &source,
         const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria(),
         double lambda_geometric = 0.968);
 
+/// Function to align colored point clouds with a prepared target
+/// The target must have color gradients, see
+/// RegistrationTarget::PrepareColorGradients(). The original function uses a
+/// search radius of twice max_distance and 30 neighbors.
+RegistrationResult RegistrationColoredICP(const PointCloud &source,
+        const RegistrationTarget &target, double max_distance,
+        const Eigen::Matrix4d &init = Eigen::Matrix4d::Identity(),
+        const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria(),
+        double lambda_geometric = 0.968);
+
 }   // namespace open3d
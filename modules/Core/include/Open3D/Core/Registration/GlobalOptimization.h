@@ -27,14 +27,14 @@
 
 #pragma once
 
+#include <vector>
 #include <memory>
+#include <Open3D/Core/Registration/PoseGraph.h>
 #include <Open3D/Core/Registration/GlobalOptimizationMethod.h>
 #include <Open3D/Core/Registration/GlobalOptimizationConvergenceCriteria.h>
 
 namespace open3d {
 
-class PoseGraph;
-
 /// Function to optimize a PoseGraph
 /// Reference:
 /// [Kümmerle et al 2011]
@@ -62,4 +62,53 @@ std::shared_ptr<PoseGraph> CreatePoseGraphWithoutInvalidEdges(
         const PoseGraph &pose_graph,
         const GlobalOptimizationOption &option);
 
+/// Class that optimizes a PoseGraph incrementally while nodes and edges are
+/// appended, e.g. by an online SLAM system, in the spirit of [Kaess et al 2012].
+/// Node ids are treated as a chronological elimination ordering: new edges
+/// only affect the nodes from the smallest node id they touch up to the
+/// newest node. Update() re-solves only these nodes with Levenberg-Marquardt,
+/// keeping older nodes fixed at their current estimate. When the affected
+/// nodes exceed max_affected_ratio_ of the graph (e.g. a loop closure to the
+/// beginning of the sequence), the whole graph is relinearized and solved.
+/// The reference node (node 0 if option_.reference_node_ is not valid) never
+/// moves. Edges are not pruned; use CreatePoseGraphWithoutInvalidEdges on the
+/// result if needed.
+/// Reference:
+/// [Kaess et al 2012]
+///    M. Kaess, H. Johannsson, R. Roberts, V. Ila, J. Leonard, F. Dellaert,
+///    iSAM2: Incremental Smoothing and Mapping Using the Bayes Tree, IJRR 2012
+class IncrementalGlobalOptimization
+{
+public:
+    IncrementalGlobalOptimization(
+            const GlobalOptimizationConvergenceCriteria &criteria =
+            GlobalOptimizationConvergenceCriteria(),
+            const GlobalOptimizationOption &option =
+            GlobalOptimizationOption(),
+            double max_affected_ratio = 0.5);
+    ~IncrementalGlobalOptimization();
+
+public:
+    void AddNode(const PoseGraphNode &node);
+    /// Function to append an edge between two nodes that have been added
+    bool AddEdge(const PoseGraphEdge &edge);
+    /// Function to optimize the nodes affected since the last update
+    void Update();
+    const PoseGraph &GetPoseGraph() const { return pose_graph_; }
+
+public:
+    GlobalOptimizationConvergenceCriteria criteria_;
+    GlobalOptimizationOption option_;
+    double max_affected_ratio_;
+
+private:
+    PoseGraph pose_graph_;
+    /// Ids of the edges incident to every node
+    std::vector<std::vector<int32_t>> node_edges_;
+    /// Smallest node id touched since the last update, -1 if none
+    int32_t first_affected_node_;
+    /// Sum of information_(0, 0) over all edges, for the line process weight
+    double information_sum_;
+};
+
 }   // namespace open3d
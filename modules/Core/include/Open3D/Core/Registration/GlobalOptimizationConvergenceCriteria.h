@@ -31,19 +31,40 @@ namespace open3d {
 
 class GlobalOptimizationOption
 {
+public:
+    /// Solvers for the linear system H * delta = b of every iteration
+    /// Dense uses a dense LDLT of the full 6N x 6N matrix and is only suitable
+    /// for small graphs. SparseCholesky assembles H block-sparse (one 6x6 block
+    /// per connected pair of nodes) and factorizes it with a simplicial LDLT
+    /// under AMD ordering. ConjugateGradient runs a block-Jacobi preconditioned
+    /// conjugate gradient on the same sparse matrix.
+    enum class LinearSolverType {
+        Dense,
+        SparseCholesky,
+        ConjugateGradient,
+    };
+
 public:
     GlobalOptimizationOption(
             double max_correspondence_distance = 0.075,
             double edge_prune_threshold = 0.25,
-            int32_t reference_node = -1) :
+            int32_t reference_node = -1,
+            LinearSolverType linear_solver = LinearSolverType::SparseCholesky,
+            uint32_t max_iteration_cg = 1000,
+            double relative_tolerance_cg = 1e-8) :
             max_correspondence_distance_(max_correspondence_distance),
             edge_prune_threshold_(edge_prune_threshold),
-            reference_node_(reference_node) {
+            reference_node_(reference_node),
+            linear_solver_(linear_solver),
+            max_iteration_cg_(max_iteration_cg),
+            relative_tolerance_cg_(relative_tolerance_cg) {
         max_correspondence_distance_ = max_correspondence_distance < 0.0
                 ? 0.075 : max_correspondence_distance;
         edge_prune_threshold_ =
                 edge_prune_threshold < 0.0 || edge_prune_threshold > 1.0
                 ? 0.25 : edge_prune_threshold;
+        relative_tolerance_cg_ = relative_tolerance_cg <= 0.0
+                ? 1e-8 : relative_tolerance_cg;
     };
     ~GlobalOptimizationOption() {};
 
@@ -58,6 +79,12 @@ public:
     double edge_prune_threshold_;
     /// This node is unchanged after optimization
     int32_t reference_node_;
+    /// Linear solver used in every Gauss-Newton or Levenberg-Marquardt step
+    LinearSolverType linear_solver_;
+    /// Conjugate gradient stops after max_iteration_cg_ iterations, or when
+    /// the residual norm drops below relative_tolerance_cg_ * |b|
+    uint32_t max_iteration_cg_;
+    double relative_tolerance_cg_;
 };
 
 class GlobalOptimizationConvergenceCriteria
@@ -78,4 +78,30 @@ public:
             const GlobalOptimizationOption &option) const override;
 };
 
+/// Hierarchical optimization for large graphs. Nodes are grouped into submaps
+/// of submap_size_ consecutive nodes. The internal graph of every submap is
+/// optimized in parallel with Levenberg-Marquardt, keeping its first node
+/// (the anchor) fixed. Edges between submaps are then expressed between
+/// anchors, the coarse graph of anchors is optimized, and every submap is
+/// moved rigidly with its anchor. If global_refinement_ is true, the whole
+/// graph is finally optimized starting from this initialization.
+class GlobalOptimizationHierarchical : public GlobalOptimizationMethod
+{
+public:
+    GlobalOptimizationHierarchical(int32_t submap_size = 100,
+            bool global_refinement = false) : submap_size_(submap_size),
+            global_refinement_(global_refinement) {}
+    ~GlobalOptimizationHierarchical() override {}
+
+public:
+    void OptimizePoseGraph(
+            PoseGraph &pose_graph,
+            const GlobalOptimizationConvergenceCriteria &criteria,
+            const GlobalOptimizationOption &option) const override;
+
+public:
+    int32_t submap_size_;
+    bool global_refinement_;
+};
+
 }   // namespace open3d
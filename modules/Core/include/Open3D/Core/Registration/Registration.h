@@ -28,9 +28,11 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <tuple>
 #include <Eigen/Core>
 
+#include <Open3D/Core/Geometry/KDTreeSearchParam.h>
 #include <Open3D/Core/Registration/CorrespondenceChecker.h>
 #include <Open3D/Core/Registration/TransformationEstimation.h>
 #include <Open3D/Core/Utility/Eigen.h>
@@ -39,6 +41,7 @@ namespace open3d {
 
 class PointCloud;
 class Feature;
+class KDTreeFlann;
 
 /// Class that defines the convergence criteria of ICP
 /// ICP algorithm stops if the relative change of fitness and rmse hit
@@ -78,6 +81,39 @@ public:
     uint32_t max_validation_;
 };
 
+/// Class that defines how RANSAC hypotheses are validated
+/// By default, every hypothesis that passes the checkers is validated against
+/// the whole source point cloud (a KDTree search per source point).
+/// If staged_validation_ is true, a hypothesis is first prescored against the
+/// feature correspondence set only. The set is built from
+/// prescore_sample_size_ randomly chosen source points (0 means all points).
+/// In this mode, max_validation_ of RANSACConvergenceCriteria limits the
+/// number of prescored hypotheses. Only the best max_dense_validation_
+/// candidates are then validated against the whole point cloud, and the
+/// winner is refined with refine_iteration_ ICP iterations.
+/// seed_ seeds the random sampling of the hypotheses and of the prescore
+/// points. A negative seed_ seeds it from the clock.
+class RANSACValidationOption
+{
+public:
+    RANSACValidationOption(bool staged_validation = false,
+            uint32_t prescore_sample_size = 0,
+            uint32_t max_dense_validation = 10,
+            uint32_t refine_iteration = 30, int32_t seed = -1) :
+            staged_validation_(staged_validation),
+            prescore_sample_size_(prescore_sample_size),
+            max_dense_validation_(max_dense_validation),
+            refine_iteration_(refine_iteration), seed_(seed) {}
+    ~RANSACValidationOption() {}
+
+public:
+    bool staged_validation_;
+    uint32_t prescore_sample_size_;
+    uint32_t max_dense_validation_;
+    uint32_t refine_iteration_;
+    int32_t seed_;
+};
+
 /// Class that contains the registration result
 class RegistrationResult
 {
@@ -94,11 +130,65 @@ public:
     double fitness_;
 };
 
-/// Function for evaluation
+/// Class that holds a registration target prepared once for many sources: a
+/// copy of the target point cloud and its KDTree, plus normals and color
+/// gradients computed on demand. It can be passed to EvaluateRegistration,
+/// RegistrationICP, RegistrationColoredICP and
+/// GetInformationMatrixFromPointClouds to skip their per-call setup.
+class RegistrationTarget
+{
+public:
+    RegistrationTarget(const PointCloud &target);
+    ~RegistrationTarget();
+    RegistrationTarget(const RegistrationTarget &) = delete;
+    RegistrationTarget &operator=(const RegistrationTarget &) = delete;
+
+public:
+    /// Function to estimate normals if the target point cloud has none
+    bool PrepareNormals(const KDTreeSearchParam &search_param =
+            KDTreeSearchParamKNN());
+    /// Function to compute the color gradients used by colored ICP
+    /// The target point cloud must have normals and colors.
+    bool PrepareColorGradients(const KDTreeSearchParamHybrid &search_param);
+    bool HasColorGradients() const;
+
+public:
+    std::shared_ptr<PointCloud> pointcloud_;
+    std::shared_ptr<KDTreeFlann> kdtree_;
+    std::vector<Eigen::Vector3d> color_gradients_;
+};
+
+/// Class that holds a target point cloud downsampled with a list of voxel
+/// sizes, with a RegistrationTarget for every level. The levels are built in
+/// parallel once and can be reused by RegistrationMultiScaleICP while the
+/// target stays the same. A voxel size <= 0 keeps the original point cloud at
+/// that level.
+class MultiScaleICPTarget
+{
+public:
+    MultiScaleICPTarget(const PointCloud &target,
+            const std::vector<double> &voxel_sizes);
+    ~MultiScaleICPTarget();
+    MultiScaleICPTarget(const MultiScaleICPTarget &) = delete;
+    MultiScaleICPTarget &operator=(const MultiScaleICPTarget &) = delete;
+
+public:
+    size_t NumberOfLevels() const { return voxel_sizes_.size(); }
+
+public:
+    std::vector<double> voxel_sizes_;
+    std::vector<std::shared_ptr<RegistrationTarget>> levels_;
+};
+
+/// Functions for evaluation
 RegistrationResult EvaluateRegistration(const PointCloud &source,
         const PointCloud &target, double max_correspondence_distance,
         const Eigen::Matrix4d &transformation = Eigen::Matrix4d::Identity());
 
+RegistrationResult EvaluateRegistration(const PointCloud &source,
+        const RegistrationTarget &target, double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation = Eigen::Matrix4d::Identity());
+
 /// Functions for ICP registration
 RegistrationResult RegistrationICP(const PointCloud &source,
         const PointCloud &target, double max_correspondence_distance,
@@ -107,6 +197,35 @@ RegistrationResult RegistrationICP(const PointCloud &source,
         TransformationEstimationPointToPoint(false),
         const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria());
 
+RegistrationResult RegistrationICP(const PointCloud &source,
+        const RegistrationTarget &target, double max_correspondence_distance,
+        const Eigen::Matrix4d &init = Eigen::Matrix4d::Identity(),
+        const TransformationEstimation &estimation =
+        TransformationEstimationPointToPoint(false),
+        const ICPConvergenceCriteria &criteria = ICPConvergenceCriteria());
+
+/// Functions for multi-scale ICP registration
+/// Levels are processed in the given order (coarse to fine), each level
+/// starting from the transformation of the previous one.
+/// max_correspondence_distances must have one entry per level. criteria can be
+/// empty (default criteria for every level) or have one entry per level.
+/// The returned correspondence set refers to the points of the last level.
+RegistrationResult RegistrationMultiScaleICP(const PointCloud &source,
+        const MultiScaleICPTarget &target,
+        const std::vector<double> &max_correspondence_distances,
+        const Eigen::Matrix4d &init = Eigen::Matrix4d::Identity(),
+        const TransformationEstimation &estimation =
+        TransformationEstimationPointToPoint(false),
+        const std::vector<ICPConvergenceCriteria> &criteria = {});
+
+RegistrationResult RegistrationMultiScaleICP(const PointCloud &source,
+        const PointCloud &target, const std::vector<double> &voxel_sizes,
+        const std::vector<double> &max_correspondence_distances,
+        const Eigen::Matrix4d &init = Eigen::Matrix4d::Identity(),
+        const TransformationEstimation &estimation =
+        TransformationEstimationPointToPoint(false),
+        const std::vector<ICPConvergenceCriteria> &criteria = {});
+
 /// Function for global RANSAC registration based on a given set of
 /// correspondences
 RegistrationResult RegistrationRANSACBasedOnCorrespondence(
@@ -127,12 +246,18 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
         size_t ransac_n = 4,
         const std::vector<std::reference_wrapper<const CorrespondenceChecker>> &
         checkers = {}, const RANSACConvergenceCriteria &criteria =
-        RANSACConvergenceCriteria());
+        RANSACConvergenceCriteria(), const RANSACValidationOption &
+        validation = RANSACValidationOption());
 
-/// Function for computing information matrix from RegistrationResult
+/// Functions for computing information matrix from RegistrationResult
 Eigen::Matrix6d GetInformationMatrixFromPointClouds(
         const PointCloud &source, const PointCloud &target,
         double max_correspondence_distance,
         const Eigen::Matrix4d &transformation);
 
+Eigen::Matrix6d GetInformationMatrixFromPointClouds(
+        const PointCloud &source, const RegistrationTarget &target,
+        double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation);
+
 }   // namespace open3d
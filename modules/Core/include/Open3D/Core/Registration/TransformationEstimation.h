@@ -54,6 +54,23 @@ public:
     virtual Eigen::Matrix4d ComputeTransformation(const PointCloud &source,
             const PointCloud &target,
             const CorrespondenceSet &corres) const = 0;
+
+public:
+    /// Functions for fused ICP iterations
+    /// An estimation with a positive GetFusedStatisticsSize() lets ICP
+    /// accumulate the statistics it needs (e.g., JTJ and JTr) during the
+    /// nearest neighbor search, so the correspondence set is not walked again.
+    /// source_point is the source point transformed by the current estimate.
+    /// AccumulateFusedStatistics() must be thread safe.
+    virtual size_t GetFusedStatisticsSize() const { return 0; }
+    virtual void AccumulateFusedStatistics(const PointCloud & /*source*/,
+            int32_t /*source_index*/, const Eigen::Vector3d & /*source_point*/,
+            const PointCloud & /*target*/, int32_t /*target_index*/,
+            Eigen::VectorXd & /*statistics*/) const {}
+    virtual Eigen::Matrix4d ComputeTransformationFromFusedStatistics(
+            const Eigen::VectorXd & /*statistics*/) const {
+        return Eigen::Matrix4d::Identity();
+    }
 };
 
 /// Estimate a transformation for point to point distance
@@ -70,6 +87,13 @@ public:
     Eigen::Matrix4d ComputeTransformation(const PointCloud &source,
             const PointCloud &target,
             const CorrespondenceSet &corres) const override;
+    size_t GetFusedStatisticsSize() const override;
+    void AccumulateFusedStatistics(const PointCloud &source,
+            int32_t source_index, const Eigen::Vector3d &source_point,
+            const PointCloud &target, int32_t target_index,
+            Eigen::VectorXd &statistics) const override;
+    Eigen::Matrix4d ComputeTransformationFromFusedStatistics(
+            const Eigen::VectorXd &statistics) const override;
 
 public:
     bool with_scaling_ = false;
@@ -88,6 +112,13 @@ public:
     Eigen::Matrix4d ComputeTransformation(const PointCloud &source,
             const PointCloud &target,
             const CorrespondenceSet &corres) const override;
+    size_t GetFusedStatisticsSize() const override;
+    void AccumulateFusedStatistics(const PointCloud &source,
+            int32_t source_index, const Eigen::Vector3d &source_point,
+            const PointCloud &target, int32_t target_index,
+            Eigen::VectorXd &statistics) const override;
+    Eigen::Matrix4d ComputeTransformationFromFusedStatistics(
+            const Eigen::VectorXd &statistics) const override;
 };
 
 
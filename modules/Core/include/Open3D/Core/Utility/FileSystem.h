@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 
@@ -60,6 +62,14 @@ bool FileExists(const std::string &filename);
 
 bool RemoveFile(const std::string &filename);
 
+/// Function to move the position of file to offset bytes from its start.
+/// Offsets past 2 GB are supported on every platform.
+bool SeekFile(std::FILE *file, int64_t offset);
+
+/// Function to get the position of file in bytes from its start, or -1 on
+/// failure. Positions past 2 GB are supported on every platform.
+int64_t TellFile(std::FILE *file);
+
 bool ListFilesInDirectory(const std::string &directory,
         std::vector<std::string> &filenames);
 
@@ -27,32 +27,475 @@
 
 #include <Open3D/Core/Integration/ScalableTSDFVolume.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
 #include <unordered_set>
+#include <Eigen/Dense>
 
 #include <Open3D/Core/Utility/Console.h>
+#include <Open3D/Core/Utility/Helper.h>
 #include <Open3D/Core/Geometry/PointCloud.h>
-#include <Open3D/Core/Integration/UniformTSDFVolume.h>
 #include <Open3D/Core/Integration/MarchingCubesConst.h>
 
 namespace open3d {
 
+namespace {
+
+struct TSDFVoxel
+{
+    float tsdf_;
+    float weight_;
+
+    float GetTSDF() const { return tsdf_; }
+    float GetWeight() const { return weight_; }
+    Eigen::Vector3f GetColor() const { return Eigen::Vector3f::Zero(); }
+
+    void Integrate(float tsdf, const uint8_t * /*rgb*/) {
+        tsdf_ = (tsdf_ * weight_ + tsdf) / (weight_ + 1.0f);
+        weight_ += 1.0f;
+    }
+};
+
+struct ColoredTSDFVoxel
+{
+    float tsdf_;
+    float weight_;
+    float color_[3];
+
+    float GetTSDF() const { return tsdf_; }
+    float GetWeight() const { return weight_; }
+    Eigen::Vector3f GetColor() const {
+        return Eigen::Vector3f(color_[0], color_[1], color_[2]);
+    }
+
+    void Integrate(float tsdf, const uint8_t *rgb) {
+        tsdf_ = (tsdf_ * weight_ + tsdf) / (weight_ + 1.0f);
+        color_[0] = (color_[0] * weight_ + rgb[0]) / (weight_ + 1.0f);
+        color_[1] = (color_[1] * weight_ + rgb[1]) / (weight_ + 1.0f);
+        color_[2] = (color_[2] * weight_ + rgb[2]) / (weight_ + 1.0f);
+        weight_ += 1.0f;
+    }
+};
+
+/// Function to quantize a tsdf value in [-1, 1] to 16-bit fixed point
+inline int16_t EncodeCompactTSDF(float tsdf)
+{
+    return static_cast<int16_t>(tsdf * 32767.0f + (tsdf < 0.0f ?
+            -0.5f : 0.5f));
+}
+
+/// Function to round a color channel to 8 bits
+inline uint8_t EncodeCompactColor(float c)
+{
+    return static_cast<uint8_t>(std::min(std::max(c + 0.5f, 0.0f), 255.0f));
+}
+
+/// Voxel of the compact formats. The tsdf is stored as 16-bit fixed point and
+/// the weight saturates at the maximum of WeightType, after which the voxel
+/// keeps averaging new observations with that weight.
+template <typename WeightType>
+struct CompactTSDFVoxel
+{
+    int16_t tsdf_;
+    WeightType weight_;
+
+    float GetTSDF() const { return tsdf_ * (1.0f / 32767.0f); }
+    float GetWeight() const { return static_cast<float>(weight_); }
+    Eigen::Vector3f GetColor() const { return Eigen::Vector3f::Zero(); }
+
+    void Integrate(float tsdf, const uint8_t * /*rgb*/) {
+        float w = static_cast<float>(weight_);
+        tsdf_ = EncodeCompactTSDF((GetTSDF() * w + tsdf) / (w + 1.0f));
+        if (weight_ < std::numeric_limits<WeightType>::max()) {
+            weight_++;
+        }
+    }
+};
+
+template <typename WeightType>
+struct ColoredCompactTSDFVoxel
+{
+    int16_t tsdf_;
+    WeightType weight_;
+    uint8_t color_[3];
+
+    float GetTSDF() const { return tsdf_ * (1.0f / 32767.0f); }
+    float GetWeight() const { return static_cast<float>(weight_); }
+    Eigen::Vector3f GetColor() const {
+        return Eigen::Vector3f(color_[0], color_[1], color_[2]);
+    }
+
+    void Integrate(float tsdf, const uint8_t *rgb) {
+        float w = static_cast<float>(weight_);
+        float w_inv = 1.0f / (w + 1.0f);
+        tsdf_ = EncodeCompactTSDF((GetTSDF() * w + tsdf) * w_inv);
+        color_[0] = EncodeCompactColor((color_[0] * w + rgb[0]) * w_inv);
+        color_[1] = EncodeCompactColor((color_[1] * w + rgb[1]) * w_inv);
+        color_[2] = EncodeCompactColor((color_[2] * w + rgb[2]) * w_inv);
+        if (weight_ < std::numeric_limits<WeightType>::max()) {
+            weight_++;
+        }
+    }
+};
+
+size_t GetVoxelSize(bool with_color,
+        ScalableTSDFVolume::VoxelFormat voxel_format)
+{
+    switch (voxel_format) {
+    case ScalableTSDFVolume::VoxelFormat::Compact16:
+        return with_color ? sizeof(ColoredCompactTSDFVoxel<uint16_t>) :
+                sizeof(CompactTSDFVoxel<uint16_t>);
+    case ScalableTSDFVolume::VoxelFormat::Compact8:
+        return with_color ? sizeof(ColoredCompactTSDFVoxel<uint8_t>) :
+                sizeof(CompactTSDFVoxel<uint8_t>);
+    default:
+        return with_color ? sizeof(ColoredTSDFVoxel) : sizeof(TSDFVoxel);
+    }
+}
+
+/// Macro that runs the statement in a member function of ScalableTSDFVolume
+/// with VoxelType defined as the voxel type selected by with_color_ and
+/// voxel_format_
+#define DISPATCH_VOXEL_TYPE(...) \
+    switch (voxel_format_) { \
+    case VoxelFormat::Compact16: \
+        if (with_color_) { \
+            typedef ColoredCompactTSDFVoxel<uint16_t> VoxelType; \
+            __VA_ARGS__; \
+        } else { \
+            typedef CompactTSDFVoxel<uint16_t> VoxelType; \
+            __VA_ARGS__; \
+        } \
+        break; \
+    case VoxelFormat::Compact8: \
+        if (with_color_) { \
+            typedef ColoredCompactTSDFVoxel<uint8_t> VoxelType; \
+            __VA_ARGS__; \
+        } else { \
+            typedef CompactTSDFVoxel<uint8_t> VoxelType; \
+            __VA_ARGS__; \
+        } \
+        break; \
+    default: \
+        if (with_color_) { \
+            typedef ColoredTSDFVoxel VoxelType; \
+            __VA_ARGS__; \
+        } else { \
+            typedef TSDFVoxel VoxelType; \
+            __VA_ARGS__; \
+        } \
+        break; \
+    }
+
+/// Class that gives access to the voxels of a volume unit and of its 26
+/// neighbors, with the block lookups done once
+template <typename VoxelType>
+class VolumeUnitNeighborhood
+{
+public:
+    VolumeUnitNeighborhood(const VoxelBlockPool &pool, int32_t block_id,
+            int32_t resolution) : resolution_(resolution) {
+        const Eigen::Vector3i &index = pool.GetBlockIndex(block_id);
+        for (int32_t i = 0; i < 27; i++) {
+            int32_t id = i == 13 ? block_id : pool.Find(index +
+                    Eigen::Vector3i(i % 3 - 1, (i / 3) % 3 - 1, i / 9 - 1));
+            blocks_[i] = id < 0 ? NULL : reinterpret_cast<const VoxelType *>(
+                    pool.GetBlockData(id));
+        }
+    }
+
+    /// Function to return the neighbor slot of the unit containing idx, where
+    /// each coordinate of idx is in [-resolution_, 2 * resolution_). idx is
+    /// converted to the local voxel coordinate in that unit.
+    int32_t Locate(Eigen::Vector3i &idx) const {
+        int32_t slot = 13;
+        for (int32_t j = 0, stride = 1; j < 3; j++, stride *= 3) {
+            if (idx(j) < 0) {
+                idx(j) += resolution_;
+                slot -= stride;
+            } else if (idx(j) >= resolution_) {
+                idx(j) -= resolution_;
+                slot += stride;
+            }
+        }
+        return slot;
+    }
+
+    /// Function to return the voxel at idx, or NULL if its unit is not
+    /// allocated
+    const VoxelType *GetVoxel(const Eigen::Vector3i &idx) const {
+        Eigen::Vector3i local = idx;
+        const VoxelType *block = blocks_[Locate(local)];
+        if (block == NULL) {
+            return NULL;
+        }
+        return block + (local(0) * resolution_ + local(1)) * resolution_ +
+                local(2);
+    }
+
+private:
+    int32_t resolution_;
+    const VoxelType *blocks_[27];
+};
+
+/// Function to check if all eight corners of the marching cube at origin are
+/// observed
+template <typename VoxelType>
+bool IsCubeObserved(const VolumeUnitNeighborhood<VoxelType> &neighborhood,
+        const Eigen::Vector3i &origin)
+{
+    for (int32_t i = 0; i < 8; i++) {
+        const VoxelType *voxel = neighborhood.GetVoxel(origin + shift[i]);
+        if (voxel == NULL || voxel->GetWeight() == 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Function to return the central difference TSDF gradient at voxel idx of a
+/// neighborhood. The voxels of missing units count as 0, like in GetTSDFAt().
+template <typename VoxelType>
+Eigen::Vector3d GetVoxelGradient(
+        const VolumeUnitNeighborhood<VoxelType> &neighborhood,
+        const Eigen::Vector3i &idx)
+{
+    Eigen::Vector3d gradient;
+    for (int32_t i = 0; i < 3; i++) {
+        Eigen::Vector3i idx0 = idx, idx1 = idx;
+        idx0(i) -= 1;
+        idx1(i) += 1;
+        const VoxelType *voxel0 = neighborhood.GetVoxel(idx0);
+        const VoxelType *voxel1 = neighborhood.GetVoxel(idx1);
+        gradient(i) = (voxel1 == NULL ? 0.0 : voxel1->GetTSDF()) -
+                (voxel0 == NULL ? 0.0 : voxel0->GetTSDF());
+    }
+    return gradient;
+}
+
+/// Function to move the element of the last block into the erased block i,
+/// for per-block vectors that may be shorter than the number of blocks
+template <typename T>
+void EraseBlockElement(std::vector<T> &elements, size_t i, size_t last)
+{
+    if (i != last && i < elements.size()) {
+        elements[i] = last < elements.size() ? std::move(elements[last]) : T();
+    }
+    if (elements.size() > last) {
+        elements.resize(last);
+    }
+}
+
+const uint64_t UNIT_SET_EMPTY_KEY = ~uint64_t(0);
+const int32_t UNIT_SET_KEY_RANGE = 1 << 20;
+
+/// Insert-only hash set of volume unit indices that multiple threads can fill
+/// at the same time. An index is stored relative to the origin unit, packed
+/// in 21 bits per axis. Insert() fails once the set is 3/4 full, and the set
+/// is marked as overflowed.
+class ConcurrentVolumeUnitSet
+{
+public:
+    ConcurrentVolumeUnitSet(size_t slot_num, const Eigen::Vector3i &origin) :
+            slots_(slot_num), mask_(slot_num - 1),
+            max_size_(slot_num / 4 * 3), size_(0), overflowed_(false),
+            origin_(origin) {
+        for (auto &slot : slots_) {
+            slot.store(UNIT_SET_EMPTY_KEY, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    bool Insert(const Eigen::Vector3i &index) {
+        if (overflowed_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const Eigen::Vector3i offset = index - origin_;
+        for (int32_t j = 0; j < 3; j++) {
+            if (offset(j) < -UNIT_SET_KEY_RANGE || offset(j) >= UNIT_SET_KEY_RANGE) {
+                return false;
+            }
+        }
+        const uint64_t key =
+                (static_cast<uint64_t>(offset(0) + UNIT_SET_KEY_RANGE) << 42) |
+                (static_cast<uint64_t>(offset(1) + UNIT_SET_KEY_RANGE) << 21) |
+                static_cast<uint64_t>(offset(2) + UNIT_SET_KEY_RANGE);
+        size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >>
+                32) & mask_;
+        while (true) {
+            uint64_t current = slots_[slot].load(std::memory_order_relaxed);
+            if (current == UNIT_SET_EMPTY_KEY && slots_[slot].compare_exchange_strong(
+                    current, key, std::memory_order_relaxed)) {
+                if (size_.fetch_add(1, std::memory_order_relaxed) + 1 >=
+                        max_size_) {
+                    overflowed_.store(true, std::memory_order_relaxed);
+                }
+                return true;
+            }
+            if (current == key) {
+                return true;
+            }
+            slot = (slot + 1) & mask_;
+        }
+    }
+
+    bool Overflowed() const {
+        return overflowed_.load(std::memory_order_relaxed);
+    }
+
+    /// Function to return the indices in the set, sorted, so that the order
+    /// does not depend on the thread timing
+    std::vector<Eigen::Vector3i> GetIndices() const {
+        std::vector<uint64_t> keys;
+        keys.reserve(size_.load());
+        for (const auto &slot : slots_) {
+            uint64_t key = slot.load(std::memory_order_relaxed);
+            if (key != UNIT_SET_EMPTY_KEY) {
+                keys.push_back(key);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        std::vector<Eigen::Vector3i> indices(keys.size());
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        for (size_t i = 0; i < keys.size(); i++) {
+            indices[i] = origin_ + Eigen::Vector3i(
+                    static_cast<int32_t>((keys[i] >> 42) & mask),
+                    static_cast<int32_t>((keys[i] >> 21) & mask),
+                    static_cast<int32_t>(keys[i] & mask)) -
+                    Eigen::Vector3i(UNIT_SET_KEY_RANGE, UNIT_SET_KEY_RANGE, UNIT_SET_KEY_RANGE);
+        }
+        return indices;
+    }
+
+private:
+    std::vector<std::atomic<uint64_t>> slots_;
+    size_t mask_;
+    size_t max_size_;
+    std::atomic<size_t> size_;
+    std::atomic<bool> overflowed_;
+    Eigen::Vector3i origin_;
+};
+
+/// Function to visit the volume units that the segment from start to end
+/// passes through, in order (3D DDA by Amanatides and Woo). The points are
+/// given in units of volume unit length.
+template <typename Visitor>
+void TraverseVolumeUnits(const Eigen::Vector3d &start,
+        const Eigen::Vector3d &end, Visitor visit)
+{
+    Eigen::Vector3i index, last, step;
+    Eigen::Vector3d t_max, t_delta;
+    const Eigen::Vector3d dir = end - start;
+    for (int32_t j = 0; j < 3; j++) {
+        index(j) = static_cast<int32_t>(std::floor(start(j)));
+        last(j) = static_cast<int32_t>(std::floor(end(j)));
+        if (dir(j) > 0.0) {
+            step(j) = 1;
+            t_delta(j) = 1.0 / dir(j);
+            t_max(j) = (index(j) + 1 - start(j)) * t_delta(j);
+        } else if (dir(j) < 0.0) {
+            step(j) = -1;
+            t_delta(j) = -1.0 / dir(j);
+            t_max(j) = (start(j) - index(j)) * t_delta(j);
+        } else {
+            step(j) = 0;
+            t_delta(j) = std::numeric_limits<double>::infinity();
+            t_max(j) = std::numeric_limits<double>::infinity();
+        }
+    }
+    // The step count bounds the loop against rounding at the end point.
+    int32_t step_num = (last - index).cwiseAbs().sum();
+    visit(index);
+    for (int32_t i = 0; i < step_num; i++) {
+        int32_t j = t_max(0) < t_max(1) ? (t_max(0) < t_max(2) ? 0 : 2) :
+                (t_max(1) < t_max(2) ? 1 : 2);
+        index(j) += step(j);
+        t_max(j) += t_delta(j);
+        visit(index);
+    }
+}
+
+/// Edge length of the chunks of volume units that streaming extraction loads
+/// at a time, in volume units
+const int32_t STREAMING_CHUNK_SIZE = 8;
+
+/// Ratio of the distance at which a volume unit is evicted to the streaming
+/// radius. The margin keeps the units near the boundary from being written
+/// and loaded again as the camera moves back and forth.
+const double STREAMING_EVICTION_RATIO = 1.25;
+
+}   // unnamed namespace
+
 ScalableTSDFVolume::ScalableTSDFVolume(double voxel_length, double sdf_trunc,
         bool with_color, int32_t volume_unit_resolution/* = 16*/,
-        int32_t depth_sampling_stride/* = 4*/) :
+        int32_t depth_sampling_stride/* = 4*/,
+        VoxelFormat voxel_format/* = VoxelFormat::Float*/) :
         TSDFVolume(voxel_length, sdf_trunc, with_color),
         volume_unit_resolution_(volume_unit_resolution),
         volume_unit_length_(voxel_length * volume_unit_resolution),
-        depth_sampling_stride_(depth_sampling_stride)
+        depth_sampling_stride_(depth_sampling_stride),
+        voxel_format_(voxel_format), streaming_radius_(0.0),
+        volume_units_(volume_unit_resolution * volume_unit_resolution *
+        volume_unit_resolution * GetVoxelSize(with_color, voxel_format))
 {
 }
 
+ScalableTSDFVolume::ScalableTSDFVolume(const ScalableTSDFVolume &volume) :
+        TSDFVolume(volume),
+        volume_unit_resolution_(volume.volume_unit_resolution_),
+        volume_unit_length_(volume.volume_unit_length_),
+        depth_sampling_stride_(volume.depth_sampling_stride_),
+        voxel_format_(volume.voxel_format_),
+        streaming_radius_(volume.streaming_radius_),
+        volume_units_(volume.volume_units_),
+        unit_meshes_(volume.unit_meshes_),
+        unit_modified_(volume.unit_modified_),
+        reset_units_(volume.reset_units_),
+        stored_unit_meshes_(volume.stored_unit_meshes_),
+        stored_modified_units_(volume.stored_modified_units_)
+{
+    if (volume.block_store_ != NULL) {
+        volume.block_store_->Flush();
+        std::vector<Eigen::Vector3i> indices;
+        for (const auto &index : volume.block_store_->GetBlockIndices()) {
+            if (volume_units_.Find(index) < 0) {
+                indices.push_back(index);
+            }
+        }
+        LoadVolumeUnits(indices, *volume.block_store_);
+        unit_stored_.clear();
+    }
+}
+
 ScalableTSDFVolume::~ScalableTSDFVolume()
 {
 }
 
 void ScalableTSDFVolume::Reset()
 {
-    volume_units_.clear();
+    for (size_t i = 0; i < unit_meshes_.size(); i++) {
+        if (!unit_meshes_[i].triangles_.empty()) {
+            reset_units_.push_back(volume_units_.GetBlockIndex(
+                    static_cast<int32_t>(i)));
+        }
+    }
+    for (const auto &unit_mesh : stored_unit_meshes_) {
+        if (!unit_mesh.second.triangles_.empty()) {
+            reset_units_.push_back(unit_mesh.first);
+        }
+    }
+    unit_meshes_.clear();
+    unit_modified_.clear();
+    unit_stored_.clear();
+    stored_unit_meshes_.clear();
+    stored_modified_units_.clear();
+    volume_units_.Clear();
+    if (block_store_ != NULL) {
+        block_store_->Clear();
+    }
 }
 
 void ScalableTSDFVolume::Integrate(const RGBDImage &image,
@@ -70,30 +513,65 @@ void ScalableTSDFVolume::Integrate(const RGBDImage &image,
         PrintWarning("[ScalableTSDFVolume::Integrate] Unsupported image format. Please check if you have called CreateRGBDImageFromColorAndDepth() with convert_rgb_to_intensity=false.\n");
         return;
     }
-    auto depth2cameradistance = CreateDepthToCameraDistanceMultiplierFloatImage(
+    const Image &depth2cameradistance = GetDepthToCameraDistanceMultiplier(
             intrinsic);
-    auto pointcloud = CreatePointCloudFromDepthImage(image.depth_, intrinsic,
-            extrinsic, 1000.0, 1000.0, depth_sampling_stride_);
-    std::unordered_set<Eigen::Vector3i, hash_eigen::hash<Eigen::Vector3i>>
-            touched_volume_units_;
-    for (const auto &point : pointcloud->points_) {
-        auto min_bound = LocateVolumeUnit(point - Eigen::Vector3d(
-                sdf_trunc_, sdf_trunc_, sdf_trunc_));
-        auto max_bound = LocateVolumeUnit(point + Eigen::Vector3d(
-                sdf_trunc_, sdf_trunc_, sdf_trunc_));
-        for (int32_t x = min_bound(0); x <= max_bound(0); x++) {
-            for (int32_t y = min_bound(1); y <= max_bound(1); y++) {
-                for (int32_t z = min_bound(2); z <= max_bound(2); z++) {
-                    auto loc = Eigen::Vector3i(x, y, z);
-                    if (touched_volume_units_.find(loc) ==
-                            touched_volume_units_.end()) {
-                        touched_volume_units_.insert(loc);
-                        auto volume = OpenVolumeUnit(Eigen::Vector3i(x, y, z));
-                        volume->IntegrateWithDepthToCameraDistanceMultiplier(
-                                image, intrinsic, extrinsic,
-                                *depth2cameradistance);
-                    }
-                }
+    const std::vector<Eigen::Vector3i> touched_volume_units =
+            LocateTouchedVolumeUnits(image.depth_, intrinsic, extrinsic,
+            depth2cameradistance);
+
+    // Allocate the new volume units in one batch before integration, so that
+    // volume_units_ is not modified inside the parallel loop.
+    volume_units_.Reserve(volume_units_.NumberOfBlocks() +
+            touched_volume_units.size());
+    if (block_store_ != NULL) {
+        std::vector<Eigen::Vector3i> stored_indices;
+        for (const auto &index : touched_volume_units) {
+            if (volume_units_.Find(index) < 0 &&
+                    block_store_->Contains(index)) {
+                stored_indices.push_back(index);
+            }
+        }
+        LoadVolumeUnits(stored_indices, *block_store_);
+    }
+    std::vector<int32_t> block_ids;
+    block_ids.reserve(touched_volume_units.size());
+    for (const auto &index : touched_volume_units) {
+        block_ids.push_back(volume_units_.Activate(index));
+    }
+    unit_modified_.resize(volume_units_.NumberOfBlocks(), 0);
+    for (int32_t block_id : block_ids) {
+        unit_modified_[block_id] = 1;
+        if (block_id < static_cast<int32_t>(unit_stored_.size())) {
+            unit_stored_[block_id] = 0;
+        }
+    }
+    DISPATCH_VOXEL_TYPE(IntegrateVolumeUnits<VoxelType>(image, intrinsic,
+            extrinsic, depth2cameradistance, block_ids));
+
+    if (block_store_ != NULL) {
+        // Evict the units far from the camera, except those integrated in
+        // this frame. Going down from the last block id, the unit moved into
+        // an evicted block id has been checked.
+        const Eigen::Vector3d camera = -extrinsic.block<3, 3>(0, 0).
+                transpose() * extrinsic.block<3, 1>(0, 3);
+        const Eigen::Vector3d half_unit = Eigen::Vector3d::Constant(
+                volume_unit_length_ * 0.5);
+        const double eviction_radius = streaming_radius_ *
+                STREAMING_EVICTION_RATIO;
+        std::vector<uint8_t> touched(volume_units_.NumberOfBlocks(), 0);
+        for (int32_t block_id : block_ids) {
+            touched[block_id] = 1;
+        }
+        for (int32_t block_id = static_cast<int32_t>(
+                volume_units_.NumberOfBlocks()) - 1; block_id >= 0;
+                block_id--) {
+            Eigen::Vector3d center = volume_units_.GetBlockIndex(block_id).
+                    cast<double>() * volume_unit_length_ + half_unit;
+            if (touched[block_id] == 0 &&
+                    (center - camera).norm() > eviction_radius) {
+                const size_t last = volume_units_.NumberOfBlocks() - 1;
+                EvictVolumeUnit(block_id);
+                EraseBlockElement(touched, block_id, last);
             }
         }
     }
@@ -102,228 +580,278 @@ void ScalableTSDFVolume::Integrate(const RGBDImage &image,
 std::shared_ptr<PointCloud> ScalableTSDFVolume::ExtractPointCloud()
 {
     auto pointcloud = std::make_shared<PointCloud>();
-    double half_voxel_length = voxel_length_ * 0.5;
-    float w0, w1, f0, f1;
-    Eigen::Vector3f c0, c1;
-    for (const auto &unit : volume_units_) {
-        if (unit.second.volume_) {
-            const auto &volume0 = *unit.second.volume_;
-            const auto &index0 = unit.second.index_;
-            for (uint32_t x = 0; x < volume0.resolution_; x++) {
-                for (uint32_t y = 0; y < volume0.resolution_; y++) {
-                    for (uint32_t z = 0; z < volume0.resolution_; z++) {
-                        Eigen::Vector3i idx0(x, y, z);
-                        w0 = volume0.weight_[volume0.IndexOf(idx0)];
-                        f0 = volume0.tsdf_[volume0.IndexOf(idx0)];
-                        if (with_color_)
-                            c0 = volume0.color_[volume0.IndexOf(idx0)];
-                        if (w0 != 0.0f && f0 < 0.98f && f0 >= -0.98f) {
-                            Eigen::Vector3d p0 = Eigen::Vector3d(
-                                half_voxel_length + voxel_length_ * x,
-                                half_voxel_length + voxel_length_ * y,
-                                half_voxel_length + voxel_length_ * z) +
-                                index0.cast<double>() * volume_unit_length_;
-                            for (int32_t i = 0; i < 3; i++) {
-                                Eigen::Vector3d p1 = p0;
-                                Eigen::Vector3i idx1 = idx0;
-                                Eigen::Vector3i index1 = index0;
-                                p1(i) += voxel_length_;
-                                idx1(i) += 1;
-                                if (idx1(i) < static_cast<Eigen::Vector3i::Scalar>(volume0.resolution_)) {
-                                    w1 = volume0.weight_[volume0.IndexOf(idx1)];
-                                    f1 = volume0.tsdf_[volume0.IndexOf(idx1)];
-                                    if (with_color_)
-                                        c1 = volume0.color_[
-                                                volume0.IndexOf(idx1)];
-                                } else {
-                                    idx1(i) -= volume0.resolution_;
-                                    index1(i) += 1;
-                                    auto unit_itr = volume_units_.find(index1);
-                                    if (unit_itr == volume_units_.end()) {
-                                        w1 = 0.0f; f1 = 0.0f;
-                                    } else {
-                                        const auto &volume1 =
-                                                *unit_itr->second.volume_;
-                                        w1 = volume1.weight_[volume1.IndexOf(
-                                                idx1)];
-                                        f1 = volume1.tsdf_[volume1.IndexOf(
-                                            idx1)];
-                                        if (with_color_)
-                                            c1 = volume1.color_[
-                                                volume1.IndexOf(idx1)];
-                                    }
-                                }
-                                if (w1 != 0.0f && f1 < 0.98f && f1 >= -0.98f &&
-                                        f0 * f1 < 0) {
-                                    float r0 = std::fabs(f0);
-                                    float r1 = std::fabs(f1);
-                                    Eigen::Vector3d p = p0;
-                                    p(i) = (p0(i) * r1 + p1(i) * r0) /
-                                            (r0 + r1);
-                                    pointcloud->points_.push_back(p);
-                                    if (with_color_) {
-                                        pointcloud->colors_.push_back(
-                                                ((c0 * r1 + c1 * r0) /
-                                                (r0 + r1) / 255.0f).
-                                                cast<double>());
-                                    }
-                                    // has_normal
-                                    pointcloud->normals_.push_back(
-                                            GetNormalAt(p));
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+    if (block_store_ == NULL) {
+        std::vector<int32_t> block_ids(volume_units_.NumberOfBlocks());
+        for (size_t i = 0; i < block_ids.size(); i++) {
+            block_ids[i] = static_cast<int32_t>(i);
+        }
+        DISPATCH_VOXEL_TYPE(ExtractPointCloudImpl<VoxelType>(block_ids,
+                *pointcloud));
+        return pointcloud;
+    }
+    for (const auto &chunk : GetVolumeUnitChunks()) {
+        auto loaded_indices = LoadStoredVolumeUnits(chunk, true);
+        std::vector<int32_t> block_ids(chunk.size());
+        for (size_t i = 0; i < chunk.size(); i++) {
+            block_ids[i] = volume_units_.Find(chunk[i]);
         }
+        DISPATCH_VOXEL_TYPE(ExtractPointCloudImpl<VoxelType>(block_ids,
+                *pointcloud));
+        EvictVolumeUnits(loaded_indices);
     }
     return pointcloud;
 }
 
 std::shared_ptr<TriangleMesh> ScalableTSDFVolume::ExtractTriangleMesh()
 {
-    // implementation of marching cubes, based on
-    // http://paulbourke.net/geometry/polygonise/
-    auto mesh = std::make_shared<TriangleMesh>();
-    double half_voxel_length = voxel_length_ * 0.5;
-    std::unordered_map<Eigen::Vector4i, size_t, hash_eigen::hash<Eigen::Vector4i>>
-        edgeindex_to_vertexindex;
-    size_t edge_to_index[12];
-    for (const auto &unit : volume_units_) {
-        if (unit.second.volume_) {
-            const auto &volume0 = *unit.second.volume_;
-            const auto &index0 = unit.second.index_;
-            for (uint32_t x = 0; x < volume0.resolution_; x++) {
-                for (uint32_t y = 0; y < volume0.resolution_; y++) {
-                    for (uint32_t z = 0; z < volume0.resolution_; z++) {
-                        Eigen::Vector3i idx0(x, y, z);
-                        uint32_t cube_index = 0;
-                        float w[8];
-                        float f[8];
-                        Eigen::Vector3d c[8];
-                        for (int32_t i = 0; i < 8; i++) {
-                            Eigen::Vector3i index1 = index0;
-                            Eigen::Vector3i idx1 = idx0 + shift[i];
-                            if (idx1(0) < volume_unit_resolution_ &&
-                                idx1(1) < volume_unit_resolution_ &&
-                                idx1(2) < volume_unit_resolution_) {
-                                w[i] = volume0.weight_[volume0.IndexOf(idx1)];
-                                f[i] = volume0.tsdf_[volume0.IndexOf(idx1)];
-                                if (with_color_)
-                                    c[i] = volume0.color_[volume0.IndexOf(
-                                            idx1)].cast<double>() / 255.0;;
-                            } else {
-                                for (int32_t j = 0; j < 3; j++) {
-                                    if (idx1(j) >= volume_unit_resolution_) {
-                                        idx1(j) -= volume_unit_resolution_;
-                                        index1(j) += 1;
-                                    }
-                                }
-                                auto unit_itr1 = volume_units_.find(index1);
-                                if (unit_itr1 == volume_units_.end()) {
-                                    w[i] = 0.0f;  f[i] = 0.0f;
-                                } else {
-                                    const auto &volume1 =
-                                            *unit_itr1->second.volume_;
-                                    w[i] = volume1.weight_[volume1.IndexOf(
-                                            idx1)];
-                                    f[i] = volume1.tsdf_[volume1.IndexOf(idx1)];
-                                    if (with_color_)
-                                        c[i] = volume1.color_[volume1.IndexOf(
-                                                idx1)].cast<double>() / 255.0;
-                                }
-                            }
-                            if (w[i] == 0.0f) {
-                                cube_index = 0;
-                                break;
-                            } else {
-                                if (f[i] < 0.0f) {
-                                    cube_index |= (1 << i);
-                                }
-                            }
-                        }
-                        if (cube_index == 0 || cube_index == 255) {
-                            continue;
-                        }
-                        for (int32_t i = 0; i < 12; i++) {
-                            if (edge_table[cube_index] & (1 << i)) {
-                                Eigen::Vector4i edge_index = Eigen::Vector4i(
-                                        index0(0), index0(1), index0(2), 0) *
-                                        volume_unit_resolution_ +
-                                        Eigen::Vector4i(x, y, z, 0) +
-                                        edge_shift[i];
-                                if (edgeindex_to_vertexindex.find(edge_index) ==
-                                        edgeindex_to_vertexindex.end()) {
-                                    edge_to_index[i] =
-                                            mesh->vertices_.size();
-                                    edgeindex_to_vertexindex[edge_index] =
-                                            mesh->vertices_.size();
-                                    Eigen::Vector3d pt(
-                                            half_voxel_length +
-                                            voxel_length_ * edge_index(0),
-                                            half_voxel_length +
-                                            voxel_length_ * edge_index(1),
-                                            half_voxel_length +
-                                            voxel_length_ * edge_index(2));
-                                    double f0 = std::abs((double)f[
-                                            edge_to_vert[i][0]]);
-                                    double f1 = std::abs((double)f[
-                                            edge_to_vert[i][1]]);
-                                    pt(edge_index(3)) += f0 * voxel_length_ /
-                                            (f0 + f1);
-                                    mesh->vertices_.push_back(pt);
-                                    if (with_color_) {
-                                        const auto &c0 = c[edge_to_vert[i][0]];
-                                        const auto &c1 = c[edge_to_vert[i][1]];
-                                        mesh->vertex_colors_.push_back(
-                                            (f1 * c0 + f0 * c1) / (f0 + f1));
-                                    }
-                                } else {
-                                    edge_to_index[i] =
-                                            edgeindex_to_vertexindex[
-                                            edge_index];
-                                }
-                            }
-                        }
-                        for (int32_t i = 0; tri_table[cube_index][i] != -1; i += 3)
-                        {
-                            mesh->triangles_.push_back(Eigen::Vector3i(
-                                static_cast<Eigen::Vector3i::Scalar>(edge_to_index[tri_table[cube_index][i]]),
-                                static_cast<Eigen::Vector3i::Scalar>(edge_to_index[tri_table[cube_index][i + 2]]),
-                                static_cast<Eigen::Vector3i::Scalar>(edge_to_index[tri_table[cube_index][i + 1]])));
-                        }
+    std::vector<std::vector<Eigen::Vector3i>> chunks;
+    if (block_store_ == NULL) {
+        chunks.resize(1);
+        chunks[0].resize(volume_units_.NumberOfBlocks());
+        for (size_t i = 0; i < chunks[0].size(); i++) {
+            chunks[0][i] = volume_units_.GetBlockIndex(static_cast<int32_t>(i));
+        }
+    } else {
+        chunks = GetVolumeUnitChunks();
+    }
+    std::vector<Eigen::Vector3i> indices;
+    std::vector<std::vector<VolumeUnitMesh>> chunk_meshes(chunks.size());
+    for (size_t c = 0; c < chunks.size(); c++) {
+        const auto &chunk = chunks[c];
+        std::vector<Eigen::Vector3i> loaded_indices;
+        if (block_store_ != NULL) {
+            loaded_indices = LoadStoredVolumeUnits(chunk, true);
+        }
+        chunk_meshes[c].resize(chunk.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int32_t i = 0; i < static_cast<int32_t>(chunk.size()); i++) {
+            DISPATCH_VOXEL_TYPE(ExtractVolumeUnitMesh<VoxelType>(
+                    volume_units_.Find(chunk[i]), chunk_meshes[c][i]));
+        }
+        indices.insert(indices.end(), chunk.begin(), chunk.end());
+        EvictVolumeUnits(loaded_indices);
+    }
+    std::vector<const VolumeUnitMesh *> unit_meshes;
+    unit_meshes.reserve(indices.size());
+    for (const auto &meshes : chunk_meshes) {
+        for (const auto &unit_mesh : meshes) {
+            unit_meshes.push_back(&unit_mesh);
+        }
+    }
+    return StitchVolumeUnitMeshes(indices, unit_meshes);
+}
+
+std::shared_ptr<TriangleMesh> ScalableTSDFVolume::ExtractTriangleMeshIncremental()
+{
+    std::vector<uint8_t> had_triangles;
+    DISPATCH_VOXEL_TYPE(UpdateVolumeUnitMeshes<VoxelType>(had_triangles));
+    reset_units_.clear();
+    std::vector<Eigen::Vector3i> indices;
+    std::vector<const VolumeUnitMesh *> unit_meshes;
+    indices.reserve(unit_meshes_.size() + stored_unit_meshes_.size());
+    unit_meshes.reserve(unit_meshes_.size() + stored_unit_meshes_.size());
+    for (size_t i = 0; i < unit_meshes_.size(); i++) {
+        indices.push_back(volume_units_.GetBlockIndex(static_cast<int32_t>(i)));
+        unit_meshes.push_back(&unit_meshes_[i]);
+    }
+    for (const auto &unit_mesh : stored_unit_meshes_) {
+        indices.push_back(unit_mesh.first);
+        unit_meshes.push_back(&unit_mesh.second);
+    }
+    return StitchVolumeUnitMeshes(indices, unit_meshes);
+}
+
+ScalableTSDFVolume::MeshDelta ScalableTSDFVolume::ExtractTriangleMeshDelta()
+{
+    MeshDelta delta;
+    delta.removed_units_.swap(reset_units_);
+    std::vector<uint8_t> had_triangles;
+    std::vector<Eigen::Vector3i> updated_indices;
+    DISPATCH_VOXEL_TYPE(updated_indices = UpdateVolumeUnitMeshes<VoxelType>(
+            had_triangles));
+    for (size_t u = 0; u < updated_indices.size(); u++) {
+        const Eigen::Vector3i &index = updated_indices[u];
+        if (had_triangles[u] != 0) {
+            delta.removed_units_.push_back(index);
+        }
+        const VolumeUnitMesh *unit_mesh = FindVolumeUnitMesh(index);
+        if (unit_mesh == NULL || unit_mesh->triangles_.empty()) {
+            continue;
+        }
+        // Copy the vertices referred to by the triangles of the unit,
+        // including the ones owned by its neighbors. A triangle whose vertex
+        // cannot be found (the mesh of the neighbor is missing or out of
+        // date) is dropped.
+        auto mesh = std::make_shared<TriangleMesh>();
+        std::unordered_map<int32_t, int32_t> corner_to_vertex;
+        mesh->triangles_.reserve(unit_mesh->triangles_.size());
+        size_t dropped_num = 0;
+        for (size_t i = 0; i < unit_mesh->triangles_.size(); i++) {
+            Eigen::Vector3i triangle;
+            bool is_valid = true;
+            for (int32_t j = 0; j < 3; j++) {
+                int32_t corner = unit_mesh->triangles_[i](j);
+                auto itr = corner_to_vertex.find(corner);
+                if (itr == corner_to_vertex.end()) {
+                    const VolumeUnitMesh *owner_mesh = NULL;
+                    int32_t vertex_index = 0;
+                    if (!FindVolumeUnitMeshVertex(index, corner, owner_mesh,
+                            vertex_index)) {
+                        is_valid = false;
+                        break;
+                    }
+                    itr = corner_to_vertex.insert(std::make_pair(corner,
+                            static_cast<int32_t>(mesh->vertices_.size()))).
+                            first;
+                    mesh->vertices_.push_back(owner_mesh->vertices_[
+                            vertex_index]);
+                    if (with_color_) {
+                        mesh->vertex_colors_.push_back(owner_mesh->
+                                vertex_colors_[vertex_index]);
                     }
                 }
+                triangle(j) = itr->second;
+            }
+            if (is_valid) {
+                mesh->triangles_.push_back(triangle);
+            } else {
+                dropped_num++;
             }
         }
+        if (dropped_num > 0) {
+            PrintWarning("[ExtractTriangleMeshDelta] Dropped %d triangles of volume unit (%d, %d, %d) with missing vertices.\n",
+                    (int32_t)dropped_num, index(0), index(1), index(2));
+        }
+        delta.added_units_.push_back(index);
+        delta.added_meshes_.push_back(mesh);
     }
-    return mesh;
+    return delta;
 }
 
 std::shared_ptr<PointCloud> ScalableTSDFVolume::ExtractVoxelPointCloud()
 {
     auto voxel = std::make_shared<PointCloud>();
-    for (auto &unit : volume_units_) {
-        if (unit.second.volume_) {
-            auto v = unit.second.volume_->ExtractVoxelPointCloud();
-            *voxel += *v;
+    if (block_store_ == NULL) {
+        std::vector<int32_t> block_ids(volume_units_.NumberOfBlocks());
+        for (size_t i = 0; i < block_ids.size(); i++) {
+            block_ids[i] = static_cast<int32_t>(i);
+        }
+        DISPATCH_VOXEL_TYPE(ExtractVoxelPointCloudImpl<VoxelType>(block_ids,
+                *voxel));
+        return voxel;
+    }
+    for (const auto &chunk : GetVolumeUnitChunks()) {
+        auto loaded_indices = LoadStoredVolumeUnits(chunk, false);
+        std::vector<int32_t> block_ids(chunk.size());
+        for (size_t i = 0; i < chunk.size(); i++) {
+            block_ids[i] = volume_units_.Find(chunk[i]);
         }
+        DISPATCH_VOXEL_TYPE(ExtractVoxelPointCloudImpl<VoxelType>(block_ids,
+                *voxel));
+        EvictVolumeUnits(loaded_indices);
     }
     return voxel;
 }
 
-std::shared_ptr<UniformTSDFVolume> ScalableTSDFVolume::OpenVolumeUnit(
-        const Eigen::Vector3i &index)
+bool ScalableTSDFVolume::EnableStreaming(const std::string &block_store_path,
+        double streaming_radius)
+{
+    DisableStreaming();
+    auto block_store = std::make_shared<VoxelBlockStore>(block_store_path,
+            volume_units_.BlockBytes());
+    if (!block_store->IsOpen()) {
+        return false;
+    }
+    block_store_ = block_store;
+    streaming_radius_ = streaming_radius;
+    unit_stored_.assign(volume_units_.NumberOfBlocks(), 0);
+    return true;
+}
+
+void ScalableTSDFVolume::DisableStreaming()
+{
+    if (block_store_ == NULL) {
+        return;
+    }
+    std::vector<Eigen::Vector3i> indices;
+    for (const auto &index : block_store_->GetBlockIndices()) {
+        if (volume_units_.Find(index) < 0) {
+            indices.push_back(index);
+        }
+    }
+    LoadVolumeUnits(indices, *block_store_);
+    block_store_.reset();
+    unit_stored_.clear();
+}
+
+size_t ScalableTSDFVolume::NumberOfVolumeUnits() const
+{
+    if (block_store_ == NULL) {
+        return volume_units_.NumberOfBlocks();
+    }
+    size_t num = volume_units_.NumberOfBlocks();
+    for (const auto &index : block_store_->GetBlockIndices()) {
+        if (volume_units_.Find(index) < 0) {
+            num++;
+        }
+    }
+    return num;
+}
+
+std::vector<Eigen::Vector3i> ScalableTSDFVolume::GetVolumeUnitIndices() const
+{
+    std::vector<Eigen::Vector3i> indices(volume_units_.NumberOfBlocks());
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = volume_units_.GetBlockIndex(static_cast<int32_t>(i));
+    }
+    if (block_store_ != NULL) {
+        for (const auto &index : block_store_->GetBlockIndices()) {
+            if (volume_units_.Find(index) < 0) {
+                indices.push_back(index);
+            }
+        }
+    }
+    return indices;
+}
+
+bool ScalableTSDFVolume::CopyVolumeUnit(const Eigen::Vector3i &index,
+        uint8_t *data) const
+{
+    int32_t block_id = volume_units_.Find(index);
+    if (block_id >= 0) {
+        std::memcpy(data, volume_units_.GetBlockData(block_id),
+                volume_units_.BlockBytes());
+        return true;
+    }
+    if (block_store_ != NULL) {
+        return block_store_->Read(index, data);
+    }
+    return false;
+}
+
+int32_t ScalableTSDFVolume::ActivateVolumeUnit(const Eigen::Vector3i &index)
 {
-    auto &unit = volume_units_[index];
-    if (!unit.volume_) {
-        unit.volume_.reset(new UniformTSDFVolume(volume_unit_length_,
-                volume_unit_resolution_, sdf_trunc_, with_color_,
-                index.cast<double>() * volume_unit_length_));
-        unit.index_ = index;
+    int32_t block_id = volume_units_.Activate(index);
+    const size_t block_num = volume_units_.NumberOfBlocks();
+    unit_modified_.resize(block_num, 0);
+    unit_modified_[block_id] = 1;
+    if (block_store_ != NULL) {
+        unit_stored_.resize(block_num, 0);
+        unit_stored_[block_id] = 0;
+        stored_modified_units_.erase(index);
     }
-    return unit.volume_;
+    return block_id;
+}
+
+std::shared_ptr<TSDFRaycastImage> ScalableTSDFVolume::Raycast(
+        const PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4d &extrinsic, double depth_min/* = 0.1*/,
+        double depth_max/* = 3.0*/)
+{
+    DISPATCH_VOXEL_TYPE(return RaycastImpl<VoxelType>(intrinsic, extrinsic,
+            depth_min, depth_max));
 }
 
 Eigen::Vector3d ScalableTSDFVolume::GetNormalAt(const Eigen::Vector3d &p)
@@ -341,48 +869,755 @@ Eigen::Vector3d ScalableTSDFVolume::GetNormalAt(const Eigen::Vector3d &p)
 }
 
 double ScalableTSDFVolume::GetTSDFAt(const Eigen::Vector3d &p)
+{
+    DISPATCH_VOXEL_TYPE(return GetTSDFAtImpl<VoxelType>(p));
+}
+
+std::vector<Eigen::Vector3i> ScalableTSDFVolume::LocateTouchedVolumeUnits(
+        const Image &depth, const PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        const Image &depth_to_camera_distance_multiplier) const
+{
+    const double fx = intrinsic.GetFocalLength().first;
+    const double fy = intrinsic.GetFocalLength().second;
+    const double cx = intrinsic.GetPrincipalPoint().first;
+    const double cy = intrinsic.GetPrincipalPoint().second;
+    // Camera to world transformation, scaled to units of volume unit length
+    const Eigen::Matrix3d rotation = extrinsic.block<3, 3>(0, 0).transpose() /
+            volume_unit_length_;
+    const Eigen::Vector3d camera = -extrinsic.block<3, 3>(0, 0).transpose() *
+            extrinsic.block<3, 1>(0, 3) / volume_unit_length_;
+    const Eigen::Vector3i camera_unit(
+            static_cast<int32_t>(std::floor(camera(0))),
+            static_cast<int32_t>(std::floor(camera(1))),
+            static_cast<int32_t>(std::floor(camera(2))));
+    const int32_t stride = std::max(depth_sampling_stride_, 1);
+    const int32_t row_num = (depth.height_ + stride - 1) / stride;
+
+    size_t slot_num = size_t(1) << 16;
+    while (true) {
+        ConcurrentVolumeUnitSet touched_units(slot_num, camera_unit);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int32_t i = 0; i < row_num; i++) {
+            const int32_t v = i * stride;
+            for (int32_t u = 0; u < depth.width_ && !touched_units.Overflowed();
+                    u += stride) {
+                const double d = *PointerAt<float>(depth, u, v);
+                if (d <= 0.0) {
+                    continue;
+                }
+                // The ray segment within sdf_trunc_ of the depth sample
+                const double multiplier = *PointerAt<float>(
+                        depth_to_camera_distance_multiplier, u, v);
+                const double trunc = sdf_trunc_ / multiplier;
+                const Eigen::Vector3d ray = rotation * Eigen::Vector3d(
+                        (u - cx) / fx, (v - cy) / fy, 1.0);
+                TraverseVolumeUnits(camera + ray * std::max(d - trunc, 0.0),
+                        camera + ray * (d + trunc),
+                        [&](const Eigen::Vector3i &index) {
+                    touched_units.Insert(index);
+                });
+            }
+        }
+        if (!touched_units.Overflowed()) {
+            return touched_units.GetIndices();
+        }
+        slot_num *= 4;
+    }
+}
+
+template <typename VoxelType>
+void ScalableTSDFVolume::IntegrateVolumeUnits(const RGBDImage &image,
+        const PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        const Image &depth_to_camera_distance_multiplier,
+        const std::vector<int32_t> &block_ids)
+{
+    const float fx = static_cast<float>(intrinsic.GetFocalLength().first);
+    const float fy = static_cast<float>(intrinsic.GetFocalLength().second);
+    const float cx = static_cast<float>(intrinsic.GetPrincipalPoint().first);
+    const float cy = static_cast<float>(intrinsic.GetPrincipalPoint().second);
+    const Eigen::Matrix4f extrinsic_f = extrinsic.cast<float>();
+    const float voxel_length_f = static_cast<float>(voxel_length_);
+    const float half_voxel_length_f = voxel_length_f * 0.5f;
+    const float sdf_trunc_f = static_cast<float>(sdf_trunc_);
+    const float sdf_trunc_inv_f = 1.0f / sdf_trunc_f;
+    const Eigen::Matrix4f extrinsic_scaled_f = extrinsic_f *
+            voxel_length_f;
+    const float safe_width_f = intrinsic.width_ - 0.0001f;
+    const float safe_height_f = intrinsic.height_ - 0.0001f;
+    const int32_t resolution = volume_unit_resolution_;
+
+    // Integrate the voxel slices of all touched units in a single parallel
+    // loop instead of one small parallel region per unit.
+    const int32_t slice_num = static_cast<int32_t>(block_ids.size()) *
+            resolution;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t i = 0; i < slice_num; i++) {
+        const int32_t block_id = block_ids[i / resolution];
+        const int32_t x = i % resolution;
+        const Eigen::Vector3f origin = (volume_units_.GetBlockIndex(
+                block_id).cast<double>() * volume_unit_length_).cast<float>();
+        VoxelType *voxel = reinterpret_cast<VoxelType *>(
+                volume_units_.GetBlockData(block_id)) +
+                x * resolution * resolution;
+        for (int32_t y = 0; y < resolution; y++) {
+            Eigen::Vector4f voxel_pt_camera = extrinsic_f * Eigen::Vector4f(
+                    half_voxel_length_f + voxel_length_f * x + origin(0),
+                    half_voxel_length_f + voxel_length_f * y + origin(1),
+                    half_voxel_length_f + origin(2),
+                    1.0f);
+            for (int32_t z = 0; z < resolution; z++,
+                    voxel_pt_camera(0) += extrinsic_scaled_f(0, 2),
+                    voxel_pt_camera(1) += extrinsic_scaled_f(1, 2),
+                    voxel_pt_camera(2) += extrinsic_scaled_f(2, 2),
+                    voxel++) {
+                if (voxel_pt_camera(2) > 0) {
+                    float u_f = voxel_pt_camera(0) * fx /
+                            voxel_pt_camera(2) + cx + 0.5f;
+                    float v_f = voxel_pt_camera(1) * fy /
+                            voxel_pt_camera(2) + cy + 0.5f;
+                    if (u_f >= 0.0001f && u_f < safe_width_f &&
+                            v_f >= 0.0001f && v_f < safe_height_f) {
+                        int32_t u = static_cast<int32_t>(u_f);
+                        int32_t v = static_cast<int32_t>(v_f);
+                        float d = *PointerAt<float>(image.depth_, u, v);
+                        if (d > 0.0f) {
+                            float sdf = (d - voxel_pt_camera(2)) * (
+                                    *PointerAt<float>(
+                                    depth_to_camera_distance_multiplier,
+                                    u, v));
+                            if (sdf > -sdf_trunc_f) {
+                                // integrate
+                                float tsdf = std::min(1.0f,
+                                        sdf * sdf_trunc_inv_f);
+                                voxel->Integrate(tsdf, with_color_ ?
+                                        PointerAt<uint8_t>(image.color_, u, v,
+                                        0) : NULL);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename VoxelType>
+void ScalableTSDFVolume::ExtractPointCloudImpl(
+        const std::vector<int32_t> &block_ids, PointCloud &pointcloud)
+{
+    // The units are processed in parallel into one point cloud each, which
+    // are concatenated in order. The normals are interpolated along the edge
+    // from the central difference gradients of its two voxels, read from the
+    // unit and its one-voxel halo.
+    const double half_voxel_length = voxel_length_ * 0.5;
+    const int32_t resolution = volume_unit_resolution_;
+    std::vector<PointCloud> unit_pointclouds(block_ids.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t k = 0; k < static_cast<int32_t>(block_ids.size()); k++) {
+        const int32_t block_id = block_ids[k];
+        const Eigen::Vector3i &index0 = volume_units_.GetBlockIndex(block_id);
+        const Eigen::Vector3d origin = index0.cast<double>() *
+                volume_unit_length_;
+        VolumeUnitNeighborhood<VoxelType> neighborhood(volume_units_,
+                block_id, resolution);
+        const VoxelType *block = reinterpret_cast<const VoxelType *>(
+                volume_units_.GetBlockData(block_id));
+        PointCloud &unit_pointcloud = unit_pointclouds[k];
+        for (int32_t x = 0; x < resolution; x++) {
+            for (int32_t y = 0; y < resolution; y++) {
+                for (int32_t z = 0; z < resolution; z++) {
+                    const VoxelType &voxel0 = block[(x * resolution + y) *
+                            resolution + z];
+                    float w0 = voxel0.GetWeight();
+                    float f0 = voxel0.GetTSDF();
+                    if (w0 == 0.0f || f0 >= 0.98f || f0 < -0.98f) {
+                        continue;
+                    }
+                    Eigen::Vector3i idx0(x, y, z);
+                    Eigen::Vector3d p0 = Eigen::Vector3d(
+                            half_voxel_length + voxel_length_ * x,
+                            half_voxel_length + voxel_length_ * y,
+                            half_voxel_length + voxel_length_ * z) + origin;
+                    bool has_gradient0 = false;
+                    Eigen::Vector3d gradient0;
+                    for (int32_t i = 0; i < 3; i++) {
+                        Eigen::Vector3i idx1 = idx0;
+                        idx1(i) += 1;
+                        const VoxelType *voxel1 = neighborhood.GetVoxel(idx1);
+                        if (voxel1 == NULL) {
+                            continue;
+                        }
+                        float w1 = voxel1->GetWeight();
+                        float f1 = voxel1->GetTSDF();
+                        if (w1 != 0.0f && f1 < 0.98f && f1 >= -0.98f &&
+                                f0 * f1 < 0) {
+                            float r0 = std::fabs(f0);
+                            float r1 = std::fabs(f1);
+                            Eigen::Vector3d p = p0;
+                            p(i) = (p0(i) * r1 + (p0(i) + voxel_length_) *
+                                    r0) / (r0 + r1);
+                            unit_pointcloud.points_.push_back(p);
+                            if (with_color_) {
+                                unit_pointcloud.colors_.push_back(
+                                        ((voxel0.GetColor() * r1 +
+                                        voxel1->GetColor() * r0) /
+                                        (r0 + r1) / 255.0f).template
+                                        cast<double>());
+                            }
+                            // has_normal
+                            if (!has_gradient0) {
+                                gradient0 = GetVoxelGradient(neighborhood,
+                                        idx0);
+                                has_gradient0 = true;
+                            }
+                            double t = r0 / (r0 + r1);
+                            unit_pointcloud.normals_.push_back((gradient0 *
+                                    (1.0 - t) + GetVoxelGradient(neighborhood,
+                                    idx1) * t).normalized());
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (const auto &unit_pointcloud : unit_pointclouds) {
+        pointcloud += unit_pointcloud;
+    }
+}
+
+template <typename VoxelType>
+void ScalableTSDFVolume::ExtractVolumeUnitMesh(int32_t block_id,
+        VolumeUnitMesh &unit_mesh)
+{
+    // implementation of marching cubes, based on
+    // http://paulbourke.net/geometry/polygonise/
+    // A volume unit owns the vertices on the edges that start at one of its
+    // voxels and go in the positive x, y or z direction. Triangles refer to
+    // vertices owned by the next units in x, y and z through their edge keys,
+    // so that every unit can be meshed independently.
+    unit_mesh.vertex_keys_.clear();
+    unit_mesh.vertices_.clear();
+    unit_mesh.vertex_colors_.clear();
+    unit_mesh.triangles_.clear();
+    const double half_voxel_length = voxel_length_ * 0.5;
+    const int32_t resolution = volume_unit_resolution_;
+    const int32_t strides[3] = {resolution * resolution, resolution, 1};
+    int32_t corner_offsets[8];
+    for (int32_t i = 0; i < 8; i++) {
+        corner_offsets[i] = shift[i](0) * strides[0] +
+                shift[i](1) * strides[1] + shift[i](2) * strides[2];
+    }
+    VolumeUnitNeighborhood<VoxelType> neighborhood(volume_units_, block_id,
+            resolution);
+    const Eigen::Vector3i offset = volume_units_.GetBlockIndex(block_id) *
+            resolution;
+    const VoxelType *block = reinterpret_cast<const VoxelType *>(
+            volume_units_.GetBlockData(block_id));
+
+    const VoxelType *p_voxel = block;
+    for (int32_t x = 0; x < resolution; x++) {
+        for (int32_t y = 0; y < resolution; y++) {
+            for (int32_t z = 0; z < resolution; z++, p_voxel++) {
+                const VoxelType &voxel0 = *p_voxel;
+                if (voxel0.GetWeight() == 0.0f) {
+                    continue;
+                }
+                Eigen::Vector3i idx0(x, y, z);
+                for (int32_t i = 0; i < 3; i++) {
+                    Eigen::Vector3i idx1 = idx0;
+                    idx1(i) += 1;
+                    const VoxelType *voxel1 = idx1(i) < resolution ?
+                            p_voxel + strides[i] : neighborhood.GetVoxel(idx1);
+                    if (voxel1 == NULL || voxel1->GetWeight() == 0.0f ||
+                            (voxel0.GetTSDF() < 0.0f) ==
+                            (voxel1->GetTSDF() < 0.0f)) {
+                        continue;
+                    }
+                    // The vertex exists if one of the four cubes that share
+                    // the edge is fully observed.
+                    const int32_t j = (i + 1) % 3, k = (i + 2) % 3;
+                    bool observed = false;
+                    for (int32_t c = 0; c < 4 && !observed; c++) {
+                        Eigen::Vector3i origin = idx0;
+                        origin(j) -= c & 1;
+                        origin(k) -= (c >> 1) & 1;
+                        observed = IsCubeObserved(neighborhood, origin);
+                    }
+                    if (!observed) {
+                        continue;
+                    }
+                    Eigen::Vector3i edge_index = offset + idx0;
+                    Eigen::Vector3d pt(
+                            half_voxel_length + voxel_length_ * edge_index(0),
+                            half_voxel_length + voxel_length_ * edge_index(1),
+                            half_voxel_length + voxel_length_ * edge_index(2));
+                    double f0 = std::abs((double)voxel0.GetTSDF());
+                    double f1 = std::abs((double)voxel1->GetTSDF());
+                    pt(i) += f0 * voxel_length_ / (f0 + f1);
+                    unit_mesh.vertex_keys_.push_back(((x * resolution + y) *
+                            resolution + z) * 3 + i);
+                    unit_mesh.vertices_.push_back(pt);
+                    if (with_color_) {
+                        Eigen::Vector3d c0 = voxel0.GetColor().template
+                                cast<double>() / 255.0;
+                        Eigen::Vector3d c1 = voxel1->GetColor().template
+                                cast<double>() / 255.0;
+                        unit_mesh.vertex_colors_.push_back(
+                                (f1 * c0 + f0 * c1) / (f0 + f1));
+                    }
+                }
+            }
+        }
+    }
+
+    int32_t edge_to_corner[12];
+    p_voxel = block;
+    for (int32_t x = 0; x < resolution; x++) {
+        for (int32_t y = 0; y < resolution; y++) {
+            for (int32_t z = 0; z < resolution; z++, p_voxel++) {
+                if (p_voxel->GetWeight() == 0.0f) {
+                    continue;
+                }
+                Eigen::Vector3i idx0(x, y, z);
+                const bool interior = x + 1 < resolution &&
+                        y + 1 < resolution && z + 1 < resolution;
+                uint32_t cube_index = 0;
+                for (int32_t i = 0; i < 8; i++) {
+                    const VoxelType *voxel = interior ?
+                            p_voxel + corner_offsets[i] :
+                            neighborhood.GetVoxel(idx0 + shift[i]);
+                    if (voxel == NULL || voxel->GetWeight() == 0.0f) {
+                        cube_index = 0;
+                        break;
+                    }
+                    if (voxel->GetTSDF() < 0.0f) {
+                        cube_index |= (1 << i);
+                    }
+                }
+                if (cube_index == 0 || cube_index == 255) {
+                    continue;
+                }
+                for (int32_t i = 0; i < 12; i++) {
+                    if (edge_table[cube_index] & (1 << i)) {
+                        Eigen::Vector3i idx1 = idx0 + edge_shift[i].head<3>();
+                        int32_t neighbor = 0;
+                        for (int32_t j = 0; j < 3; j++) {
+                            if (idx1(j) >= resolution) {
+                                idx1(j) -= resolution;
+                                neighbor |= (1 << j);
+                            }
+                        }
+                        edge_to_corner[i] = (((idx1(0) * resolution +
+                                idx1(1)) * resolution + idx1(2)) * 3 +
+                                edge_shift[i](3)) * 8 + neighbor;
+                    }
+                }
+                for (int32_t i = 0; tri_table[cube_index][i] != -1; i += 3) {
+                    unit_mesh.triangles_.push_back(Eigen::Vector3i(
+                            edge_to_corner[tri_table[cube_index][i]],
+                            edge_to_corner[tri_table[cube_index][i + 2]],
+                            edge_to_corner[tri_table[cube_index][i + 1]]));
+                }
+            }
+        }
+    }
+}
+
+template <typename VoxelType>
+std::vector<Eigen::Vector3i> ScalableTSDFVolume::UpdateVolumeUnitMeshes(
+        std::vector<uint8_t> &had_triangles)
+{
+    unit_modified_.resize(volume_units_.NumberOfBlocks(), 0);
+    std::vector<Eigen::Vector3i> modified_indices(
+            stored_modified_units_.begin(), stored_modified_units_.end());
+    for (size_t i = 0; i < unit_modified_.size(); i++) {
+        if (unit_modified_[i] != 0) {
+            modified_indices.push_back(volume_units_.GetBlockIndex(
+                    static_cast<int32_t>(i)));
+        }
+    }
+
+    // A unit reads the voxels of its 26 neighbors, so the neighbors of a
+    // modified unit have to be meshed again as well.
+    std::unordered_set<Eigen::Vector3i, hash_eigen::hash<Eigen::Vector3i>>
+            dirty_set;
+    std::vector<Eigen::Vector3i> dirty_indices;
+    for (const auto &index : modified_indices) {
+        for (int32_t i = 0; i < 27; i++) {
+            Eigen::Vector3i index1 = index + Eigen::Vector3i(
+                    i % 3 - 1, (i / 3) % 3 - 1, i / 9 - 1);
+            if (HasVolumeUnit(index1) && dirty_set.insert(index1).second) {
+                dirty_indices.push_back(index1);
+            }
+        }
+    }
+    std::vector<Eigen::Vector3i> loaded_indices;
+    if (block_store_ != NULL) {
+        loaded_indices = LoadStoredVolumeUnits(dirty_indices, true);
+    }
+
+    const int32_t block_num = static_cast<int32_t>(
+            volume_units_.NumberOfBlocks());
+    unit_meshes_.resize(block_num);
+    unit_modified_.assign(block_num, 0);
+    stored_modified_units_.clear();
+    std::vector<int32_t> dirty_ids(dirty_indices.size());
+    for (size_t i = 0; i < dirty_indices.size(); i++) {
+        dirty_ids[i] = volume_units_.Find(dirty_indices[i]);
+    }
+    std::sort(dirty_ids.begin(), dirty_ids.end());
+    had_triangles.resize(dirty_ids.size());
+    for (size_t i = 0; i < dirty_ids.size(); i++) {
+        dirty_indices[i] = volume_units_.GetBlockIndex(dirty_ids[i]);
+        had_triangles[i] = unit_meshes_[dirty_ids[i]].triangles_.empty() ?
+                0 : 1;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t i = 0; i < static_cast<int32_t>(dirty_ids.size()); i++) {
+        ExtractVolumeUnitMesh<VoxelType>(dirty_ids[i],
+                unit_meshes_[dirty_ids[i]]);
+    }
+    EvictVolumeUnits(loaded_indices);
+    return dirty_indices;
+}
+
+const ScalableTSDFVolume::VolumeUnitMesh *
+        ScalableTSDFVolume::FindVolumeUnitMesh(const Eigen::Vector3i &index)
+        const
+{
+    int32_t block_id = volume_units_.Find(index);
+    if (block_id >= 0) {
+        return block_id < static_cast<int32_t>(unit_meshes_.size()) ?
+                &unit_meshes_[block_id] : NULL;
+    }
+    auto itr = stored_unit_meshes_.find(index);
+    return itr == stored_unit_meshes_.end() ? NULL : &itr->second;
+}
+
+bool ScalableTSDFVolume::FindVolumeUnitMeshVertex(const Eigen::Vector3i &index,
+        int32_t corner, const VolumeUnitMesh *&owner_mesh,
+        int32_t &vertex_index) const
+{
+    int32_t neighbor = corner & 7;
+    owner_mesh = FindVolumeUnitMesh(index + Eigen::Vector3i(neighbor & 1,
+            (neighbor >> 1) & 1, (neighbor >> 2) & 1));
+    if (owner_mesh == NULL) {
+        return false;
+    }
+    const auto &keys = owner_mesh->vertex_keys_;
+    auto itr = std::lower_bound(keys.begin(), keys.end(), corner >> 3);
+    if (itr == keys.end() || *itr != (corner >> 3)) {
+        return false;
+    }
+    vertex_index = static_cast<int32_t>(itr - keys.begin());
+    return true;
+}
+
+std::shared_ptr<TriangleMesh> ScalableTSDFVolume::StitchVolumeUnitMeshes(
+        const std::vector<Eigen::Vector3i> &indices,
+        const std::vector<const VolumeUnitMesh *> &unit_meshes) const
+{
+    auto mesh = std::make_shared<TriangleMesh>();
+    const int32_t unit_num = static_cast<int32_t>(unit_meshes.size());
+    std::unordered_map<Eigen::Vector3i, int32_t,
+            hash_eigen::hash<Eigen::Vector3i>> unit_map;
+    unit_map.reserve(unit_num);
+    std::vector<size_t> vertex_offsets(unit_num + 1, 0);
+    std::vector<size_t> triangle_offsets(unit_num + 1, 0);
+    for (int32_t u = 0; u < unit_num; u++) {
+        unit_map[indices[u]] = u;
+        vertex_offsets[u + 1] = vertex_offsets[u] +
+                unit_meshes[u]->vertices_.size();
+        triangle_offsets[u + 1] = triangle_offsets[u] +
+                unit_meshes[u]->triangles_.size();
+    }
+    mesh->vertices_.resize(vertex_offsets[unit_num]);
+    if (with_color_) {
+        mesh->vertex_colors_.resize(vertex_offsets[unit_num]);
+    }
+    mesh->triangles_.resize(triangle_offsets[unit_num]);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t u = 0; u < unit_num; u++) {
+        const auto &unit_mesh = *unit_meshes[u];
+        std::copy(unit_mesh.vertices_.begin(), unit_mesh.vertices_.end(),
+                mesh->vertices_.begin() + vertex_offsets[u]);
+        if (with_color_) {
+            std::copy(unit_mesh.vertex_colors_.begin(),
+                    unit_mesh.vertex_colors_.end(),
+                    mesh->vertex_colors_.begin() + vertex_offsets[u]);
+        }
+        if (unit_mesh.triangles_.empty()) {
+            continue;
+        }
+        int32_t owners[8];
+        for (int32_t i = 0; i < 8; i++) {
+            auto itr = unit_map.find(indices[u] + Eigen::Vector3i(i & 1,
+                    (i >> 1) & 1, (i >> 2) & 1));
+            owners[i] = itr == unit_map.end() ? -1 : itr->second;
+        }
+        for (size_t i = 0; i < unit_mesh.triangles_.size(); i++) {
+            Eigen::Vector3i &triangle = mesh->triangles_[
+                    triangle_offsets[u] + i];
+            for (int32_t j = 0; j < 3; j++) {
+                int32_t corner = unit_mesh.triangles_[i](j);
+                int32_t owner = owners[corner & 7];
+                if (owner < 0) {
+                    triangle.setConstant(-1);
+                    break;
+                }
+                const auto &keys = unit_meshes[owner]->vertex_keys_;
+                auto itr = std::lower_bound(keys.begin(), keys.end(),
+                        corner >> 3);
+                if (itr == keys.end() || *itr != (corner >> 3)) {
+                    triangle.setConstant(-1);
+                    break;
+                }
+                triangle(j) = static_cast<int32_t>(vertex_offsets[owner] +
+                        (itr - keys.begin()));
+            }
+        }
+    }
+
+    // Triangles whose vertex is owned by a missing or out of date unit mesh
+    // were marked with -1 and are dropped.
+    auto end = std::remove_if(mesh->triangles_.begin(),
+            mesh->triangles_.end(), [](const Eigen::Vector3i &triangle) {
+                return triangle(0) < 0;
+            });
+    size_t dropped_num = mesh->triangles_.end() - end;
+    if (dropped_num > 0) {
+        mesh->triangles_.erase(end, mesh->triangles_.end());
+        PrintWarning("[StitchVolumeUnitMeshes] Dropped %d triangles with missing vertices.\n",
+                (int32_t)dropped_num);
+    }
+    return mesh;
+}
+
+void ScalableTSDFVolume::LoadVolumeUnits(
+        const std::vector<Eigen::Vector3i> &indices,
+        const VoxelBlockStore &block_store)
+{
+    volume_units_.Reserve(volume_units_.NumberOfBlocks() + indices.size());
+    std::vector<int32_t> block_ids(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        const Eigen::Vector3i &index = indices[i];
+        int32_t block_id = volume_units_.Activate(index);
+        block_ids[i] = block_id;
+        const size_t block_num = volume_units_.NumberOfBlocks();
+        unit_modified_.resize(block_num, 0);
+        unit_stored_.resize(block_num, 0);
+        unit_stored_[block_id] = 1;
+        auto modified_itr = stored_modified_units_.find(index);
+        if (modified_itr != stored_modified_units_.end()) {
+            unit_modified_[block_id] = 1;
+            stored_modified_units_.erase(modified_itr);
+        }
+        auto mesh_itr = stored_unit_meshes_.find(index);
+        if (mesh_itr != stored_unit_meshes_.end()) {
+            unit_meshes_.resize(block_num);
+            unit_meshes_[block_id] = std::move(mesh_itr->second);
+            stored_unit_meshes_.erase(mesh_itr);
+        }
+    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t i = 0; i < static_cast<int32_t>(indices.size()); i++) {
+        block_store.Read(indices[i], volume_units_.GetBlockData(block_ids[i]));
+    }
+}
+
+void ScalableTSDFVolume::EvictVolumeUnit(int32_t block_id)
+{
+    const Eigen::Vector3i index = volume_units_.GetBlockIndex(block_id);
+    if (block_id >= static_cast<int32_t>(unit_stored_.size()) ||
+            unit_stored_[block_id] == 0) {
+        block_store_->Write(index, volume_units_.GetBlockData(block_id));
+    }
+    if (block_id < static_cast<int32_t>(unit_modified_.size()) &&
+            unit_modified_[block_id] != 0) {
+        stored_modified_units_.insert(index);
+    }
+    if (block_id < static_cast<int32_t>(unit_meshes_.size()) &&
+            (!unit_meshes_[block_id].vertices_.empty() ||
+            !unit_meshes_[block_id].triangles_.empty())) {
+        stored_unit_meshes_[index] = std::move(unit_meshes_[block_id]);
+    }
+    EraseVolumeUnit(block_id);
+}
+
+void ScalableTSDFVolume::EraseVolumeUnit(int32_t block_id)
+{
+    const size_t last = volume_units_.NumberOfBlocks() - 1;
+    EraseBlockElement(unit_meshes_, block_id, last);
+    EraseBlockElement(unit_modified_, block_id, last);
+    EraseBlockElement(unit_stored_, block_id, last);
+    volume_units_.Erase(block_id);
+}
+
+std::vector<Eigen::Vector3i> ScalableTSDFVolume::LoadStoredVolumeUnits(
+        const std::vector<Eigen::Vector3i> &indices, bool with_neighbors)
+{
+    std::unordered_set<Eigen::Vector3i, hash_eigen::hash<Eigen::Vector3i>>
+            visited;
+    std::vector<Eigen::Vector3i> stored_indices;
+    for (const auto &index : indices) {
+        for (int32_t i = 0; i < (with_neighbors ? 27 : 1); i++) {
+            Eigen::Vector3i index1 = with_neighbors ? Eigen::Vector3i(index +
+                    Eigen::Vector3i(i % 3 - 1, (i / 3) % 3 - 1, i / 9 - 1)) :
+                    index;
+            if (visited.insert(index1).second &&
+                    volume_units_.Find(index1) < 0 &&
+                    block_store_->Contains(index1)) {
+                stored_indices.push_back(index1);
+            }
+        }
+    }
+    LoadVolumeUnits(stored_indices, *block_store_);
+    return stored_indices;
+}
+
+void ScalableTSDFVolume::EvictVolumeUnits(
+        const std::vector<Eigen::Vector3i> &indices)
+{
+    for (const auto &index : indices) {
+        int32_t block_id = volume_units_.Find(index);
+        if (block_id >= 0) {
+            EvictVolumeUnit(block_id);
+        }
+    }
+}
+
+std::vector<std::vector<Eigen::Vector3i>>
+        ScalableTSDFVolume::GetVolumeUnitChunks() const
+{
+    std::vector<Eigen::Vector3i> indices;
+    indices.reserve(volume_units_.NumberOfBlocks());
+    for (int32_t block_id = 0; block_id <
+            static_cast<int32_t>(volume_units_.NumberOfBlocks());
+            block_id++) {
+        indices.push_back(volume_units_.GetBlockIndex(block_id));
+    }
+    for (const auto &index : block_store_->GetBlockIndices()) {
+        if (volume_units_.Find(index) < 0) {
+            indices.push_back(index);
+        }
+    }
+    auto chunk_of = [](const Eigen::Vector3i &index) {
+        Eigen::Vector3i chunk;
+        for (int32_t i = 0; i < 3; i++) {
+            chunk(i) = index(i) >= 0 ? index(i) / STREAMING_CHUNK_SIZE :
+                    (index(i) + 1) / STREAMING_CHUNK_SIZE - 1;
+        }
+        return chunk;
+    };
+    auto less = [](const Eigen::Vector3i &a, const Eigen::Vector3i &b) {
+        return std::lexicographical_compare(a.data(), a.data() + 3,
+                b.data(), b.data() + 3);
+    };
+    std::sort(indices.begin(), indices.end(), [&](const Eigen::Vector3i &a,
+            const Eigen::Vector3i &b) {
+        Eigen::Vector3i chunk_a = chunk_of(a), chunk_b = chunk_of(b);
+        return chunk_a == chunk_b ? less(a, b) : less(chunk_a, chunk_b);
+    });
+    std::vector<std::vector<Eigen::Vector3i>> chunks;
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (i == 0 || chunk_of(indices[i]) != chunk_of(indices[i - 1])) {
+            chunks.push_back(std::vector<Eigen::Vector3i>());
+        }
+        chunks.back().push_back(indices[i]);
+    }
+    return chunks;
+}
+
+template <typename VoxelType>
+void ScalableTSDFVolume::ExtractVoxelPointCloudImpl(
+        const std::vector<int32_t> &block_ids, PointCloud &voxel)
+{
+    double half_voxel_length = voxel_length_ * 0.5;
+    const int32_t resolution = volume_unit_resolution_;
+    for (int32_t block_id : block_ids) {
+        const Eigen::Vector3d origin = volume_units_.GetBlockIndex(
+                block_id).cast<double>() * volume_unit_length_;
+        const VoxelType *p_voxel = reinterpret_cast<const VoxelType *>(
+                volume_units_.GetBlockData(block_id));
+        for (int32_t x = 0; x < resolution; x++) {
+            for (int32_t y = 0; y < resolution; y++) {
+                Eigen::Vector3d pt(
+                        half_voxel_length + voxel_length_ * x,
+                        half_voxel_length + voxel_length_ * y,
+                        half_voxel_length);
+                for (int32_t z = 0; z < resolution; z++,
+                        pt(2) += voxel_length_, p_voxel++) {
+                    float f = p_voxel->GetTSDF();
+                    if (p_voxel->GetWeight() != 0.0f && f < 0.98f &&
+                            f >= -0.98f) {
+                        voxel.points_.push_back(pt + origin);
+                        double c = (static_cast<double>(f) + 1.0) * 0.5;
+                        voxel.colors_.push_back(Eigen::Vector3d(c, c, c));
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename VoxelType>
+double ScalableTSDFVolume::GetTSDFAtImpl(const Eigen::Vector3d &p)
 {
     Eigen::Vector3d p_locate = p - Eigen::Vector3d(0.5, 0.5, 0.5) *
             voxel_length_;
     Eigen::Vector3i index0 = LocateVolumeUnit(p_locate);
-    auto unit_itr = volume_units_.find(index0);
-    if (unit_itr == volume_units_.end()) {
+    int32_t block_id = volume_units_.Find(index0);
+    if (block_id < 0) {
         return 0.0;
     }
-    const auto &volume0 = *unit_itr->second.volume_;
+    const VoxelType *volume0 = reinterpret_cast<const VoxelType *>(
+            volume_units_.GetBlockData(block_id));
+    const int32_t resolution = volume_unit_resolution_;
     Eigen::Vector3i idx0;
     Eigen::Vector3d p_grid = (p_locate - index0.cast<double>() *
             volume_unit_length_) / voxel_length_;
     for (int32_t i = 0; i < 3; i++) {
         idx0(i) = static_cast<Eigen::Vector3i::Scalar>(std::floor(p_grid(i)));
         if (idx0(i) < 0) idx0(i) = 0;
-        if (idx0(i) >= volume_unit_resolution_)
-            idx0(i) = volume_unit_resolution_ - 1;
+        if (idx0(i) >= resolution) idx0(i) = resolution - 1;
     }
     Eigen::Vector3d r = p_grid - idx0.cast<double>();
     float f[8];
     for (int32_t i = 0; i < 8; i++) {
         Eigen::Vector3i index1 = index0;
         Eigen::Vector3i idx1 = idx0 + shift[i];
-        if (idx1(0) < volume_unit_resolution_ &&
-            idx1(1) < volume_unit_resolution_ &&
-            idx1(2) < volume_unit_resolution_) {
-            f[i] = volume0.tsdf_[volume0.IndexOf(idx1)];
-        } else {
+        const VoxelType *volume1 = volume0;
+        if (idx1(0) >= resolution || idx1(1) >= resolution ||
+                idx1(2) >= resolution) {
             for (int32_t j = 0; j < 3; j++) {
-                if (idx1(j) >= volume_unit_resolution_) {
-                    idx1(j) -= volume_unit_resolution_;
+                if (idx1(j) >= resolution) {
+                    idx1(j) -= resolution;
                     index1(j) += 1;
                 }
             }
-            auto unit_itr1 = volume_units_.find(index1);
-            if (unit_itr1 == volume_units_.end()) {
-                f[i] = 0.0f;
-            } else {
-                const auto &volume1 = *unit_itr1->second.volume_;
-                f[i] = volume1.tsdf_[volume1.IndexOf(idx1)];
-            }
+            int32_t block_id1 = volume_units_.Find(index1);
+            volume1 = block_id1 < 0 ? NULL :
+                    reinterpret_cast<const VoxelType *>(
+                    volume_units_.GetBlockData(block_id1));
         }
+        f[i] = volume1 == NULL ? 0.0f : volume1[(idx1(0) * resolution +
+                idx1(1)) * resolution + idx1(2)].GetTSDF();
     }
     return (1 - r(0)) * ( (1 - r(1)) * ((1 - r(2)) * f[0] + r(2) * f[4]) +
             r(1) * ((1 - r(2)) * f[3] + r(2) * f[7])) +
@@ -390,4 +1625,159 @@ double ScalableTSDFVolume::GetTSDFAt(const Eigen::Vector3d &p)
             r(1) * ((1 - r(2)) * f[2] + r(2) * f[6]));
 }
 
+template <typename VoxelType>
+std::shared_ptr<TSDFRaycastImage> ScalableTSDFVolume::RaycastImpl(
+        const PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4d &extrinsic, double depth_min, double depth_max)
+{
+    auto raycast = std::make_shared<TSDFRaycastImage>();
+    const int32_t width = intrinsic.width_;
+    const int32_t height = intrinsic.height_;
+    raycast->depth_.PrepareImage(width, height, 1, 4);
+    raycast->vertex_.PrepareImage(width, height, 3, 4);
+    raycast->normal_.PrepareImage(width, height, 3, 4);
+    if (with_color_) {
+        raycast->color_.PrepareImage(width, height, 3, 1);
+    }
+    const double fx = intrinsic.GetFocalLength().first;
+    const double fy = intrinsic.GetFocalLength().second;
+    const double cx = intrinsic.GetPrincipalPoint().first;
+    const double cy = intrinsic.GetPrincipalPoint().second;
+    const Eigen::Matrix4d pose = extrinsic.inverse();
+    const Eigen::Matrix3d rotation = pose.block<3, 3>(0, 0);
+    const Eigen::Vector3d camera = pose.block<3, 1>(0, 3);
+    const int32_t resolution = volume_unit_resolution_;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t v = 0; v < height; v++) {
+        for (int32_t u = 0; u < width; u++) {
+            // The ray is parameterized by the depth t: p = camera + t * ray
+            const Eigen::Vector3d ray = rotation * Eigen::Vector3d(
+                    (u - cx) / fx, (v - cy) / fy, 1.0);
+            const double ray_length = ray.norm();
+            const double min_step = voxel_length_ / ray_length;
+            Eigen::Vector3i index(0, 0, 0);
+            const VoxelType *block = NULL;
+            bool block_valid = false;
+            double t = depth_min, t_prev = 0.0;
+            float f_prev = 0.0f;
+            bool prev_observed = false;
+            bool hit = false;
+            while (t < depth_max) {
+                Eigen::Vector3d p = camera + t * ray;
+                Eigen::Vector3i index1 = LocateVolumeUnit(p);
+                if (!block_valid || index1 != index) {
+                    index = index1;
+                    int32_t block_id = volume_units_.Find(index);
+                    block = block_id < 0 ? NULL :
+                            reinterpret_cast<const VoxelType *>(
+                            volume_units_.GetBlockData(block_id));
+                    block_valid = true;
+                }
+                if (block == NULL) {
+                    // Skip the empty volume unit: move t to where the ray
+                    // leaves it.
+                    double t_exit = depth_max;
+                    for (int32_t i = 0; i < 3; i++) {
+                        if (ray(i) != 0.0) {
+                            double bound = (index(i) + (ray(i) > 0.0 ? 1 : 0)) *
+                                    volume_unit_length_;
+                            t_exit = std::min(t_exit,
+                                    (bound - camera(i)) / ray(i));
+                        }
+                    }
+                    t = std::max(t_exit, t) + 0.01 * min_step;
+                    prev_observed = false;
+                    continue;
+                }
+                Eigen::Vector3i idx;
+                Eigen::Vector3d p_grid = (p - index.cast<double>() *
+                        volume_unit_length_) / voxel_length_;
+                for (int32_t i = 0; i < 3; i++) {
+                    idx(i) = std::min(std::max(static_cast<int32_t>(
+                            std::floor(p_grid(i))), 0), resolution - 1);
+                }
+                const VoxelType &voxel = block[(idx(0) * resolution +
+                        idx(1)) * resolution + idx(2)];
+                if (voxel.GetWeight() == 0.0f) {
+                    prev_observed = false;
+                    t += min_step;
+                    continue;
+                }
+                float f = voxel.GetTSDF();
+                if (prev_observed && f_prev > 0.0f && f < 0.0f) {
+                    // Refine the zero crossing between t_prev and t with the
+                    // trilinear TSDF, or with the voxel values if the
+                    // interpolated TSDF does not change sign.
+                    double g_prev = GetTSDFAt(camera + t_prev * ray);
+                    double g = GetTSDFAt(p);
+                    if (!(g_prev > 0.0 && g < 0.0)) {
+                        g_prev = f_prev;
+                        g = f;
+                    }
+                    t = t_prev + (t - t_prev) * g_prev / (g_prev - g);
+                    hit = true;
+                    break;
+                }
+                if (prev_observed && f_prev < 0.0f && f > 0.0f) {
+                    // back face of a surface
+                    break;
+                }
+                f_prev = f;
+                t_prev = t;
+                prev_observed = true;
+                t += std::max(min_step, 0.8 * f * sdf_trunc_ / ray_length);
+            }
+
+            float *depth = PointerAt<float>(raycast->depth_, u, v);
+            float *vertex = PointerAt<float>(raycast->vertex_, u, v, 0);
+            float *normal = PointerAt<float>(raycast->normal_, u, v, 0);
+            if (!hit) {
+                *depth = 0.0f;
+                vertex[0] = vertex[1] = vertex[2] = 0.0f;
+                normal[0] = normal[1] = normal[2] = 0.0f;
+                if (with_color_) {
+                    uint8_t *color = PointerAt<uint8_t>(raycast->color_, u, v,
+                            0);
+                    color[0] = color[1] = color[2] = 0;
+                }
+                continue;
+            }
+            Eigen::Vector3d p = camera + t * ray;
+            Eigen::Vector3d n = GetNormalAt(p);
+            *depth = static_cast<float>(t);
+            for (int32_t i = 0; i < 3; i++) {
+                vertex[i] = static_cast<float>(p(i));
+                normal[i] = static_cast<float>(n(i));
+            }
+            if (with_color_) {
+                uint8_t *color = PointerAt<uint8_t>(raycast->color_, u, v, 0);
+                Eigen::Vector3i index1 = LocateVolumeUnit(p);
+                int32_t block_id = volume_units_.Find(index1);
+                Eigen::Vector3f c = Eigen::Vector3f::Zero();
+                if (block_id >= 0) {
+                    Eigen::Vector3d p_grid = (p - index1.cast<double>() *
+                            volume_unit_length_) / voxel_length_;
+                    Eigen::Vector3i idx;
+                    for (int32_t i = 0; i < 3; i++) {
+                        idx(i) = std::min(std::max(static_cast<int32_t>(
+                                std::floor(p_grid(i))), 0), resolution - 1);
+                    }
+                    c = reinterpret_cast<const VoxelType *>(
+                            volume_units_.GetBlockData(block_id))[(idx(0) *
+                            resolution + idx(1)) * resolution + idx(2)].
+                            GetColor();
+                }
+                for (int32_t i = 0; i < 3; i++) {
+                    color[i] = static_cast<uint8_t>(std::min(std::max(
+                            c(i) + 0.5f, 0.0f), 255.0f));
+                }
+            }
+        }
+    }
+    return raycast;
+}
+
 }   // namespace open3d
@@ -0,0 +1,144 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+
+#include <Open3D/Core/Integration/TSDFVolume.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace open3d {
+
+namespace {
+
+struct TSDFFrame
+{
+public:
+    RGBDImage image_;
+    Eigen::Matrix4d extrinsic_;
+};
+
+}   // unnamed namespace
+
+int32_t TSDFVolume::IntegrateSequence(const PinholeCameraIntrinsic &intrinsic,
+        int32_t frame_num, const std::function<bool(int32_t, RGBDImage &,
+        Eigen::Matrix4d &)> &load_frame, int32_t prefetch_num/* = 2*/)
+{
+    const size_t queue_size = static_cast<size_t>(std::max(prefetch_num, 1));
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::shared_ptr<TSDFFrame>> queue;
+    bool loading = true;
+    bool stopping = false;
+    std::exception_ptr load_exception;
+
+    std::thread loader([&]() {
+        for (int32_t i = 0; i < frame_num; i++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queue_cv.wait(lock, [&]() {
+                    return queue.size() < queue_size || stopping;
+                });
+                if (stopping) {
+                    break;
+                }
+            }
+            auto frame = std::make_shared<TSDFFrame>();
+            frame->extrinsic_.setIdentity();
+            try {
+                if (!load_frame(i, frame->image_, frame->extrinsic_)) {
+                    break;
+                }
+            } catch (...) {
+                // Rethrown on the calling thread after the join.
+                load_exception = std::current_exception();
+                break;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(frame);
+            queue_cv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        loading = false;
+        queue_cv.notify_all();
+    });
+
+    int32_t integrated_num = 0;
+    try {
+        while (true) {
+            std::shared_ptr<TSDFFrame> frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queue_cv.wait(lock, [&]() {
+                    return !queue.empty() || !loading;
+                });
+                if (queue.empty()) {
+                    break;
+                }
+                frame = queue.front();
+                queue.pop_front();
+                queue_cv.notify_all();
+            }
+            Integrate(frame->image_, intrinsic, frame->extrinsic_);
+            integrated_num++;
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queue_cv.notify_all();
+        }
+        loader.join();
+        throw;
+    }
+    loader.join();
+    if (load_exception) {
+        std::rethrow_exception(load_exception);
+    }
+    return integrated_num;
+}
+
+const Image &TSDFVolume::GetDepthToCameraDistanceMultiplier(
+        const PinholeCameraIntrinsic &intrinsic)
+{
+    if (depth_to_camera_distance_multiplier_ == NULL ||
+            multiplier_intrinsic_.width_ != intrinsic.width_ ||
+            multiplier_intrinsic_.height_ != intrinsic.height_ ||
+            multiplier_intrinsic_.intrinsic_matrix_ !=
+            intrinsic.intrinsic_matrix_) {
+        depth_to_camera_distance_multiplier_ =
+                CreateDepthToCameraDistanceMultiplierFloatImage(intrinsic);
+        multiplier_intrinsic_ = intrinsic;
+    }
+    return *depth_to_camera_distance_multiplier_;
+}
+
+}   // namespace open3d
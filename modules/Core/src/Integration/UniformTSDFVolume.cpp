@@ -27,14 +27,47 @@
 
 #include <Open3D/Core/Integration/UniformTSDFVolume.h>
 
-#include <unordered_map>
+#include <algorithm>
 #include <thread>
+#include <Eigen/Dense>
 
 #include <Open3D/Core/Utility/Helper.h>
 #include <Open3D/Core/Integration/MarchingCubesConst.h>
 
 namespace open3d {
 
+namespace {
+
+/// Number of voxels along z that the integration kernel updates at a time.
+/// Eigen maps the lane arrays to SIMD registers.
+const int32_t INTEGRATION_LANE_NUM = 8;
+typedef Eigen::Array<float, INTEGRATION_LANE_NUM, 1> LaneArrayf;
+typedef Eigen::Array<bool, INTEGRATION_LANE_NUM, 1> LaneArrayb;
+typedef Eigen::Array<float, 3, INTEGRATION_LANE_NUM> LaneColorArrayf;
+
+/// Function to narrow [z_begin, z_end) to the z where a + b * z > 0, with a
+/// margin of one voxel on each side
+void ClipVoxelColumn(double a, double b, int32_t &z_begin, int32_t &z_end)
+{
+    if (b == 0.0) {
+        if (a <= 0.0) {
+            z_end = z_begin;
+        }
+    } else if (b > 0.0) {
+        double z = std::floor(-a / b) - 1.0;
+        if (z > z_begin) {
+            z_begin = z < z_end ? static_cast<int32_t>(z) : z_end;
+        }
+    } else {
+        double z = std::ceil(-a / b) + 1.0;
+        if (z < z_end) {
+            z_end = z > z_begin ? static_cast<int32_t>(z) : z_begin;
+        }
+    }
+}
+
+}   // unnamed namespace
+
 UniformTSDFVolume::UniformTSDFVolume(double length, uint32_t resolution,
         double sdf_trunc, bool with_color,
         const Eigen::Vector3d &origin/* = Eigen::Vector3d::Zero()*/) :
@@ -77,57 +110,89 @@ void UniformTSDFVolume::Integrate(const RGBDImage &image,
         PrintWarning("[UniformTSDFVolume::Integrate] Unsupported image format. Please check if you have called CreateRGBDImageFromColorAndDepth() with convert_rgb_to_intensity=false.\n");
         return;
     }
-    auto depth2cameradistance = CreateDepthToCameraDistanceMultiplierFloatImage(
+    const Image &depth2cameradistance = GetDepthToCameraDistanceMultiplier(
             intrinsic);
     IntegrateWithDepthToCameraDistanceMultiplier(image, intrinsic,
-            extrinsic, *depth2cameradistance);
+            extrinsic, depth2cameradistance);
 }
 
 std::shared_ptr<PointCloud> UniformTSDFVolume::ExtractPointCloud()
 {
+    // The x slices are processed in parallel into one point cloud each, which
+    // are concatenated in order. The normals are interpolated along the edge
+    // from the central difference gradients of its two voxels.
     auto pointcloud = std::make_shared<PointCloud>();
-    double half_voxel_length = voxel_length_ * 0.5;
-    for (uint32_t x = 1; x < resolution_ - 1; x++) {
-        for (uint32_t y = 1; y < resolution_ - 1; y++) {
-            for (uint32_t z = 1; z < resolution_ - 1; z++) {
+    const double half_voxel_length = voxel_length_ * 0.5;
+    const int32_t resolution = static_cast<int32_t>(resolution_);
+    const int32_t strides[3] = {resolution * resolution, resolution, 1};
+    const float *tsdf = tsdf_.data();
+    const float *weight = weight_.data();
+    auto GetVoxelGradient = [&](int32_t index) {
+        return Eigen::Vector3d(
+                tsdf[index + strides[0]] - tsdf[index - strides[0]],
+                tsdf[index + strides[1]] - tsdf[index - strides[1]],
+                tsdf[index + strides[2]] - tsdf[index - strides[2]]);
+    };
+    std::vector<PointCloud> slice_pointclouds(resolution > 2 ?
+            resolution - 2 : 0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t x = 1; x < resolution - 1; x++) {
+        PointCloud &slice_pointcloud = slice_pointclouds[x - 1];
+        for (int32_t y = 1; y < resolution - 1; y++) {
+            for (int32_t z = 1; z < resolution - 1; z++) {
+                const int32_t index0 = (x * resolution + y) * resolution + z;
+                float w0 = weight[index0];
+                float f0 = tsdf[index0];
+                if (w0 == 0.0f || f0 >= 0.98f || f0 < -0.98f) {
+                    continue;
+                }
                 Eigen::Vector3i idx0(x, y, z);
-                float w0 = weight_[IndexOf(idx0)];
-                float f0 = tsdf_[IndexOf(idx0)];
-                if (w0 != 0.0f && f0 < 0.98f && f0 >= -0.98f) {
-                    Eigen::Vector3d p0(
-                            half_voxel_length + voxel_length_ * x,
-                            half_voxel_length + voxel_length_ * y,
-                            half_voxel_length + voxel_length_ * z);
-                    for (int32_t i = 0; i < 3; i++) {
-                        Eigen::Vector3d p1 = p0;
-                        p1(i) += voxel_length_;
-                        Eigen::Vector3i idx1 = idx0;
-                        idx1(i) += 1;
-                        if (idx1(i) < static_cast<Eigen::Vector3i::Scalar>(resolution_ - 1)) {
-                            float w1 = weight_[IndexOf(idx1)];
-                            float f1 = tsdf_[IndexOf(idx1)];
-                            if (w1 != 0.0f && f1 < 0.98f && f1 >= -0.98f &&
-                                    f0 * f1 < 0) {
-                                float r0 = std::fabs(f0);
-                                float r1 = std::fabs(f1);
-                                Eigen::Vector3d p = p0;
-                                p(i) = (p0(i) * r1 + p1(i) * r0) / (r0 + r1);
-                                pointcloud->points_.push_back(p + origin_);
-                                if (with_color_) {
-                                    pointcloud->colors_.push_back(
-                                            ((color_[IndexOf(idx0)] * r1 +
-                                            color_[IndexOf(idx1)] * r0) /
-                                            (r0 + r1) / 255.0f).cast<double>());
-                                }
-                                // has_normal
-                                pointcloud->normals_.push_back(GetNormalAt(p));
-                            }
+                Eigen::Vector3d p0(
+                        half_voxel_length + voxel_length_ * x,
+                        half_voxel_length + voxel_length_ * y,
+                        half_voxel_length + voxel_length_ * z);
+                bool has_gradient0 = false;
+                Eigen::Vector3d gradient0;
+                for (int32_t i = 0; i < 3; i++) {
+                    if (idx0(i) + 1 >= resolution - 1) {
+                        continue;
+                    }
+                    const int32_t index1 = index0 + strides[i];
+                    float w1 = weight[index1];
+                    float f1 = tsdf[index1];
+                    if (w1 != 0.0f && f1 < 0.98f && f1 >= -0.98f &&
+                            f0 * f1 < 0) {
+                        float r0 = std::fabs(f0);
+                        float r1 = std::fabs(f1);
+                        Eigen::Vector3d p = p0;
+                        p(i) = (p0(i) * r1 + (p0(i) + voxel_length_) * r0) /
+                                (r0 + r1);
+                        slice_pointcloud.points_.push_back(p + origin_);
+                        if (with_color_) {
+                            slice_pointcloud.colors_.push_back(
+                                    ((color_[index0] * r1 +
+                                    color_[index1] * r0) /
+                                    (r0 + r1) / 255.0f).cast<double>());
                         }
+                        // has_normal
+                        if (!has_gradient0) {
+                            gradient0 = GetVoxelGradient(index0);
+                            has_gradient0 = true;
+                        }
+                        double t = r0 / (r0 + r1);
+                        slice_pointcloud.normals_.push_back((gradient0 *
+                                (1.0 - t) + GetVoxelGradient(index1) * t).
+                                normalized());
                     }
                 }
             }
         }
     }
+    for (const auto &slice_pointcloud : slice_pointclouds) {
+        *pointcloud += slice_pointcloud;
+    }
     return pointcloud;
 }
 
@@ -135,30 +200,133 @@ std::shared_ptr<TriangleMesh> UniformTSDFVolume::ExtractTriangleMesh()
 {
     // implementation of marching cubes, based on
     // http://paulbourke.net/geometry/polygonise/
+    // Each x slice of voxels owns the vertices on the edges that start at one
+    // of its voxels and go in the positive x, y or z direction. The slices
+    // are processed in parallel in two passes: the first one creates the
+    // owned vertices, the second one emits the triangles and refers to
+    // vertices owned by the next slice through its vertex offset.
     auto mesh = std::make_shared<TriangleMesh>();
-    double half_voxel_length = voxel_length_ * 0.5;
-    std::unordered_map<Eigen::Vector4i, size_t, hash_eigen::hash<Eigen::Vector4i>>
-            edgeindex_to_vertexindex;
-    size_t edge_to_index[12];
-    for (uint32_t x = 0; x < resolution_ - 1; x++) {
-        for (uint32_t y = 0; y < resolution_ - 1; y++) {
-            for (uint32_t z = 0; z < resolution_ - 1; z++) {
+    const double half_voxel_length = voxel_length_ * 0.5;
+    const int32_t resolution = static_cast<int32_t>(resolution_);
+    const int32_t strides[3] = {resolution * resolution, resolution, 1};
+    int32_t corner_offsets[8];
+    for (int32_t i = 0; i < 8; i++) {
+        corner_offsets[i] = shift[i](0) * strides[0] +
+                shift[i](1) * strides[1] + shift[i](2) * strides[2];
+    }
+    // A cube is fully observed if its origin is in [0, resolution - 2]^3 and
+    // all eight corners have a non-zero weight.
+    auto IsCubeObserved = [&](const Eigen::Vector3i &origin) {
+        for (int32_t i = 0; i < 3; i++) {
+            if (origin(i) < 0 || origin(i) >= resolution - 1) {
+                return false;
+            }
+        }
+        size_t index = IndexOf(origin);
+        for (int32_t i = 0; i < 8; i++) {
+            if (weight_[index + corner_offsets[i]] == 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // vertex_keys[x] is the sorted list of ((y * resolution + z) * 3 + axis)
+    // of the edges that carry a vertex in slice x
+    std::vector<std::vector<int32_t>> vertex_keys(resolution);
+    std::vector<std::vector<Eigen::Vector3d>> vertices(resolution);
+    std::vector<std::vector<Eigen::Vector3d>> vertex_colors(resolution);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t x = 0; x < resolution; x++) {
+        for (int32_t y = 0; y < resolution; y++) {
+            for (int32_t z = 0; z < resolution; z++) {
+                Eigen::Vector3i idx0(x, y, z);
+                size_t index0 = IndexOf(idx0);
+                if (weight_[index0] == 0.0f) {
+                    continue;
+                }
+                for (int32_t i = 0; i < 3; i++) {
+                    if (idx0(i) + 1 >= resolution) {
+                        continue;
+                    }
+                    size_t index1 = index0 + strides[i];
+                    if (weight_[index1] == 0.0f ||
+                            (tsdf_[index0] < 0.0f) == (tsdf_[index1] < 0.0f)) {
+                        continue;
+                    }
+                    // The vertex exists if one of the four cubes that share
+                    // the edge is fully observed.
+                    const int32_t j = (i + 1) % 3, k = (i + 2) % 3;
+                    bool observed = false;
+                    for (int32_t c = 0; c < 4 && !observed; c++) {
+                        Eigen::Vector3i origin = idx0;
+                        origin(j) -= c & 1;
+                        origin(k) -= (c >> 1) & 1;
+                        observed = IsCubeObserved(origin);
+                    }
+                    if (!observed) {
+                        continue;
+                    }
+                    Eigen::Vector3d pt(
+                            half_voxel_length + voxel_length_ * x,
+                            half_voxel_length + voxel_length_ * y,
+                            half_voxel_length + voxel_length_ * z);
+                    double f0 = std::abs((double)tsdf_[index0]);
+                    double f1 = std::abs((double)tsdf_[index1]);
+                    pt(i) += f0 * voxel_length_ / (f0 + f1);
+                    vertex_keys[x].push_back((y * resolution + z) * 3 + i);
+                    vertices[x].push_back(pt + origin_);
+                    if (with_color_) {
+                        Eigen::Vector3d c0 = color_[index0].cast<double>() /
+                                255.0;
+                        Eigen::Vector3d c1 = color_[index1].cast<double>() /
+                                255.0;
+                        vertex_colors[x].push_back(
+                                (f1 * c0 + f0 * c1) / (f0 + f1));
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<size_t> vertex_offsets(resolution + 1, 0);
+    for (int32_t x = 0; x < resolution; x++) {
+        vertex_offsets[x + 1] = vertex_offsets[x] + vertices[x].size();
+    }
+    mesh->vertices_.resize(vertex_offsets[resolution]);
+    if (with_color_) {
+        mesh->vertex_colors_.resize(vertex_offsets[resolution]);
+    }
+
+    std::vector<std::vector<Eigen::Vector3i>> triangles(resolution);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t x = 0; x < resolution; x++) {
+        std::copy(vertices[x].begin(), vertices[x].end(),
+                mesh->vertices_.begin() + vertex_offsets[x]);
+        if (with_color_) {
+            std::copy(vertex_colors[x].begin(), vertex_colors[x].end(),
+                    mesh->vertex_colors_.begin() + vertex_offsets[x]);
+        }
+        if (x == resolution - 1) {
+            continue;
+        }
+        int32_t edge_to_index[12];
+        for (int32_t y = 0; y < resolution - 1; y++) {
+            for (int32_t z = 0; z < resolution - 1; z++) {
+                size_t index0 = IndexOf(x, y, z);
                 uint32_t cube_index = 0;
-                float f[8];
-                Eigen::Vector3d c[8];
-                for (int32_t i = 0; i < 8; i++ ) {
-                    Eigen::Vector3i idx = Eigen::Vector3i(x, y, z) + shift[i];
-                    if (weight_[IndexOf(idx)] == 0.0f) {
+                for (int32_t i = 0; i < 8; i++) {
+                    size_t index = index0 + corner_offsets[i];
+                    if (weight_[index] == 0.0f) {
                         cube_index = 0;
                         break;
-                    } else {
-                        f[i] = tsdf_[IndexOf(idx)];
-                        if (f[i] < 0.0f) {
-                            cube_index |= (1 << i);
-                        }
-                        if (with_color_) {
-                            c[i] = color_[IndexOf(idx)].cast<double>() / 255.0;
-                        }
+                    }
+                    if (tsdf_[index] < 0.0f) {
+                        cube_index |= (1 << i);
                     }
                 }
                 if (cube_index == 0 || cube_index == 255) {
@@ -168,43 +336,37 @@ std::shared_ptr<TriangleMesh> UniformTSDFVolume::ExtractTriangleMesh()
                     if (edge_table[cube_index] & (1 << i)) {
                         Eigen::Vector4i edge_index =
                                 Eigen::Vector4i(x, y, z, 0) + edge_shift[i];
-                        if (edgeindex_to_vertexindex.find(edge_index) ==
-                                edgeindex_to_vertexindex.end()) {
-                            edge_to_index[i] = mesh->vertices_.size();
-                            edgeindex_to_vertexindex[edge_index] =
-                                    mesh->vertices_.size();
-                            Eigen::Vector3d pt(
-                                    half_voxel_length +
-                                    voxel_length_ * edge_index(0),
-                                    half_voxel_length +
-                                    voxel_length_ * edge_index(1),
-                                    half_voxel_length +
-                                    voxel_length_ * edge_index(2));
-                            double f0 = std::abs((double)f[edge_to_vert[i][0]]);
-                            double f1 = std::abs((double)f[edge_to_vert[i][1]]);
-                            pt(edge_index(3)) += f0 * voxel_length_ / (f0 + f1);
-                            mesh->vertices_.push_back(pt + origin_);
-                            if (with_color_) {
-                                const auto &c0 = c[edge_to_vert[i][0]];
-                                const auto &c1 = c[edge_to_vert[i][1]];
-                                mesh->vertex_colors_.push_back(
-                                        (f1 * c0 + f0 * c1) / (f0 + f1));
-                            }
-                        } else {
-                            edge_to_index[i] = edgeindex_to_vertexindex.find(
-                                    edge_index)->second;
-                        }
+                        int32_t key = (edge_index(1) * resolution +
+                                edge_index(2)) * 3 + edge_index(3);
+                        const auto &keys = vertex_keys[edge_index(0)];
+                        edge_to_index[i] = static_cast<int32_t>(
+                                vertex_offsets[edge_index(0)] +
+                                (std::lower_bound(keys.begin(), keys.end(),
+                                key) - keys.begin()));
                     }
                 }
                 for (int32_t i = 0; tri_table[cube_index][i] != -1; i += 3) {
-                    mesh->triangles_.push_back(Eigen::Vector3i(
-                            static_cast<Eigen::Vector3i::Scalar>(edge_to_index[tri_table[cube_index][i]]),
-                            static_cast<Eigen::Vector3i::Scalar>(edge_to_index[tri_table[cube_index][i + 2]]),
-                            static_cast<Eigen::Vector3i::Scalar>(edge_to_index[tri_table[cube_index][i + 1]])));
+                    triangles[x].push_back(Eigen::Vector3i(
+                            edge_to_index[tri_table[cube_index][i]],
+                            edge_to_index[tri_table[cube_index][i + 2]],
+                            edge_to_index[tri_table[cube_index][i + 1]]));
                 }
             }
         }
     }
+
+    std::vector<size_t> triangle_offsets(resolution + 1, 0);
+    for (int32_t x = 0; x < resolution; x++) {
+        triangle_offsets[x + 1] = triangle_offsets[x] + triangles[x].size();
+    }
+    mesh->triangles_.resize(triangle_offsets[resolution]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t x = 0; x < resolution; x++) {
+        std::copy(triangles[x].begin(), triangles[x].end(),
+                mesh->triangles_.begin() + triangle_offsets[x]);
+    }
     return mesh;
 }
 
@@ -235,6 +397,139 @@ std::shared_ptr<PointCloud> UniformTSDFVolume::ExtractVoxelPointCloud()
     return voxel;
 }
 
+std::shared_ptr<TSDFRaycastImage> UniformTSDFVolume::Raycast(
+        const PinholeCameraIntrinsic &intrinsic,
+        const Eigen::Matrix4d &extrinsic, double depth_min/* = 0.1*/,
+        double depth_max/* = 3.0*/)
+{
+    auto raycast = std::make_shared<TSDFRaycastImage>();
+    const int32_t width = intrinsic.width_;
+    const int32_t height = intrinsic.height_;
+    raycast->depth_.PrepareImage(width, height, 1, 4);
+    raycast->vertex_.PrepareImage(width, height, 3, 4);
+    raycast->normal_.PrepareImage(width, height, 3, 4);
+    if (with_color_) {
+        raycast->color_.PrepareImage(width, height, 3, 1);
+    }
+    const double fx = intrinsic.GetFocalLength().first;
+    const double fy = intrinsic.GetFocalLength().second;
+    const double cx = intrinsic.GetPrincipalPoint().first;
+    const double cy = intrinsic.GetPrincipalPoint().second;
+    const Eigen::Matrix4d pose = extrinsic.inverse();
+    const Eigen::Matrix3d rotation = pose.block<3, 3>(0, 0);
+    // camera center in the volume coordinate
+    const Eigen::Vector3d camera = pose.block<3, 1>(0, 3) - origin_;
+    const int32_t resolution = static_cast<int32_t>(resolution_);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t v = 0; v < height; v++) {
+        for (int32_t u = 0; u < width; u++) {
+            // The ray is parameterized by the depth t: p = camera + t * ray
+            const Eigen::Vector3d ray = rotation * Eigen::Vector3d(
+                    (u - cx) / fx, (v - cy) / fy, 1.0);
+            const double ray_length = ray.norm();
+            const double min_step = voxel_length_ / ray_length;
+            // Clip the ray to the volume. Voxels closer than two voxels to
+            // the border are skipped, so that trilinear interpolation and
+            // normal estimation stay inside the grid.
+            double t = depth_min, t_end = depth_max;
+            const double border = 2.0 * voxel_length_;
+            for (int32_t i = 0; i < 3; i++) {
+                if (ray(i) != 0.0) {
+                    double t0 = (border - camera(i)) / ray(i);
+                    double t1 = (length_ - border - camera(i)) / ray(i);
+                    t = std::max(t, std::min(t0, t1));
+                    t_end = std::min(t_end, std::max(t0, t1));
+                } else if (camera(i) < border ||
+                        camera(i) > length_ - border) {
+                    t_end = t;
+                }
+            }
+            double t_prev = 0.0;
+            float f_prev = 0.0f;
+            bool prev_observed = false;
+            bool hit = false;
+            for (; t < t_end; ) {
+                Eigen::Vector3d p = camera + t * ray;
+                Eigen::Vector3i idx;
+                for (int32_t i = 0; i < 3; i++) {
+                    idx(i) = std::min(std::max(static_cast<int32_t>(
+                            std::floor(p(i) / voxel_length_)), 0),
+                            resolution - 1);
+                }
+                size_t index = IndexOf(idx);
+                if (weight_[index] == 0.0f) {
+                    prev_observed = false;
+                    t += min_step;
+                    continue;
+                }
+                float f = tsdf_[index];
+                if (prev_observed && f_prev > 0.0f && f < 0.0f) {
+                    // Refine the zero crossing between t_prev and t with the
+                    // trilinear TSDF, or with the voxel values if the
+                    // interpolated TSDF does not change sign.
+                    double g_prev = GetTSDFAt(camera + t_prev * ray);
+                    double g = GetTSDFAt(p);
+                    if (!(g_prev > 0.0 && g < 0.0)) {
+                        g_prev = f_prev;
+                        g = f;
+                    }
+                    t = t_prev + (t - t_prev) * g_prev / (g_prev - g);
+                    hit = true;
+                    break;
+                }
+                if (prev_observed && f_prev < 0.0f && f > 0.0f) {
+                    // back face of a surface
+                    break;
+                }
+                f_prev = f;
+                t_prev = t;
+                prev_observed = true;
+                t += std::max(min_step, 0.8 * f * sdf_trunc_ / ray_length);
+            }
+
+            float *depth = PointerAt<float>(raycast->depth_, u, v);
+            float *vertex = PointerAt<float>(raycast->vertex_, u, v, 0);
+            float *normal = PointerAt<float>(raycast->normal_, u, v, 0);
+            if (!hit) {
+                *depth = 0.0f;
+                vertex[0] = vertex[1] = vertex[2] = 0.0f;
+                normal[0] = normal[1] = normal[2] = 0.0f;
+                if (with_color_) {
+                    uint8_t *color = PointerAt<uint8_t>(raycast->color_, u, v,
+                            0);
+                    color[0] = color[1] = color[2] = 0;
+                }
+                continue;
+            }
+            Eigen::Vector3d p = camera + t * ray;
+            Eigen::Vector3d n = GetNormalAt(p);
+            *depth = static_cast<float>(t);
+            for (int32_t i = 0; i < 3; i++) {
+                vertex[i] = static_cast<float>(p(i) + origin_(i));
+                normal[i] = static_cast<float>(n(i));
+            }
+            if (with_color_) {
+                uint8_t *color = PointerAt<uint8_t>(raycast->color_, u, v, 0);
+                Eigen::Vector3i idx;
+                for (int32_t i = 0; i < 3; i++) {
+                    idx(i) = std::min(std::max(static_cast<int32_t>(
+                            std::floor(p(i) / voxel_length_)), 0),
+                            resolution - 1);
+                }
+                const Eigen::Vector3f &c = color_[IndexOf(idx)];
+                for (int32_t i = 0; i < 3; i++) {
+                    color[i] = static_cast<uint8_t>(std::min(std::max(
+                            c(i) + 0.5f, 0.0f), 255.0f));
+                }
+            }
+        }
+    }
+    return raycast;
+}
+
 void UniformTSDFVolume::IntegrateWithDepthToCameraDistanceMultiplier(
         const RGBDImage &image, const PinholeCameraIntrinsic &intrinsic,
         const Eigen::Matrix4d &extrinsic,
@@ -253,67 +548,126 @@ void UniformTSDFVolume::IntegrateWithDepthToCameraDistanceMultiplier(
             voxel_length_f;
     const float safe_width_f = intrinsic.width_ - 0.0001f;
     const float safe_height_f = intrinsic.height_ - 0.0001f;
+    const int32_t resolution = static_cast<int32_t>(resolution_);
+    const int32_t width = image.depth_.width_;
+    const float *depth_data = reinterpret_cast<const float *>(
+            image.depth_.data_.data());
+    const float *multiplier_data = reinterpret_cast<const float *>(
+            depth_to_camera_distance_multiplier.data_.data());
+    const uint8_t *color_data = with_color_ ? image.color_.data_.data() : NULL;
+    const LaneArrayf lane_offsets = LaneArrayf::LinSpaced(
+            INTEGRATION_LANE_NUM, 0.0f, INTEGRATION_LANE_NUM - 1.0f);
 
+    // A column of voxels along z is first clipped to the range that projects
+    // into the image: each image border is a linear inequality in z. The
+    // voxels of that range are updated INTEGRATION_LANE_NUM at a time: the
+    // projection, the masks and the weighted averages are lane arrays, only
+    // the depth and color lookups are done per lane. A voxel takes one
+    // reciprocal of its new weight instead of one division per averaged
+    // value.
 #ifdef _OPENMP
 #pragma omp parallel for schedule(static)
 #endif
-    for (int32_t x = 0; x < static_cast<int32_t>(resolution_); x++) {
-        for (uint32_t y = 0; y < resolution_; y++) {
-            uint32_t idx_shift = x * resolution_ * resolution_ + y * resolution_;
-            float *p_tsdf = (float *)tsdf_.data() + idx_shift;
-            float *p_weight = (float *)weight_.data() + idx_shift;
-            float *p_color = (float *)color_.data() + idx_shift * 3;
-            Eigen::Vector4f voxel_pt_camera = extrinsic_f * Eigen::Vector4f(
-                    half_voxel_length_f + voxel_length_f * x +
+    for (int32_t x = 0; x < resolution; x++) {
+        int32_t pixels[INTEGRATION_LANE_NUM];
+        for (int32_t y = 0; y < resolution; y++) {
+            const size_t idx_shift = (size_t)(x * resolution + y) * resolution;
+            const Eigen::Vector4f voxel_pt_camera = extrinsic_f *
+                    Eigen::Vector4f(half_voxel_length_f + voxel_length_f * x +
                     static_cast<float>(origin_(0)),
                     half_voxel_length_f + voxel_length_f * y +
                     static_cast<float>(origin_(1)),
                     half_voxel_length_f + static_cast<float>(origin_(2)),
                     1.0f);
-            for (uint32_t z = 0; z < resolution_; z++,
-                    voxel_pt_camera(0) += extrinsic_scaled_f(0, 2),
-                    voxel_pt_camera(1) += extrinsic_scaled_f(1, 2),
-                    voxel_pt_camera(2) += extrinsic_scaled_f(2, 2),
-                    p_tsdf++, p_weight++, p_color += 3) {
-                if (voxel_pt_camera(2) > 0) {
-                    float u_f = voxel_pt_camera(0) * fx /
-                            voxel_pt_camera(2) + cx + 0.5f;
-                    float v_f = voxel_pt_camera(1) * fy /
-                            voxel_pt_camera(2) + cy + 0.5f;
-                    if (u_f >= 0.0001f && u_f < safe_width_f &&
-                            v_f >= 0.0001f && v_f < safe_height_f) {
-                        int32_t u = static_cast<int32_t>(u_f);
-                        int32_t v = static_cast<int32_t>(v_f);
-                        float d = *PointerAt<float>(image.depth_, u, v);
-                        if (d > 0.0f) {
-                            float sdf = (d - voxel_pt_camera(2)) * (
-                                    *PointerAt<float>(
-                                    depth_to_camera_distance_multiplier,
-                                    u, v));
-                            if (sdf > -sdf_trunc_f) {
-                                // integrate
-                                float tsdf = std::min(1.0f,
-                                        sdf * sdf_trunc_inv_f);
-                                *p_tsdf = ((*p_tsdf) * (*p_weight) + tsdf) /
-                                        (*p_weight + 1.0f);
-                                if (with_color_) {
-                                    const uint8_t *rgb = PointerAt<uint8_t>(
-                                            image.color_, u, v, 0);
-                                    p_color[0] = (p_color[0] *
-                                            (*p_weight) + rgb[0]) /
-                                            (*p_weight + 1.0f);
-                                    p_color[1] = (p_color[1] *
-                                            (*p_weight) + rgb[1]) /
-                                            (*p_weight + 1.0f);
-                                    p_color[2] = (p_color[2] *
-                                            (*p_weight) + rgb[2]) /
-                                            (*p_weight + 1.0f);
-                                }
-                                *p_weight += 1.0f;
-                            }
+            const double pt[3] = {voxel_pt_camera(0), voxel_pt_camera(1),
+                    voxel_pt_camera(2)};
+            const double step[3] = {extrinsic_scaled_f(0, 2),
+                    extrinsic_scaled_f(1, 2), extrinsic_scaled_f(2, 2)};
+            const double u_min = cx + 0.5 - 0.0001, u_max = cx + 0.5 -
+                    safe_width_f;
+            const double v_min = cy + 0.5 - 0.0001, v_max = cy + 0.5 -
+                    safe_height_f;
+            int32_t z_begin = 0, z_end = resolution;
+            ClipVoxelColumn(pt[2], step[2], z_begin, z_end);
+            ClipVoxelColumn(pt[0] * fx + u_min * pt[2],
+                    step[0] * fx + u_min * step[2], z_begin, z_end);
+            ClipVoxelColumn(-pt[0] * fx - u_max * pt[2],
+                    -step[0] * fx - u_max * step[2], z_begin, z_end);
+            ClipVoxelColumn(pt[1] * fy + v_min * pt[2],
+                    step[1] * fy + v_min * step[2], z_begin, z_end);
+            ClipVoxelColumn(-pt[1] * fy - v_max * pt[2],
+                    -step[1] * fy - v_max * step[2], z_begin, z_end);
+            for (int32_t z = z_begin; z < z_end; z += INTEGRATION_LANE_NUM) {
+                const int32_t lane_num = std::min(INTEGRATION_LANE_NUM,
+                        z_end - z);
+                const LaneArrayf z_f = lane_offsets + static_cast<float>(z);
+                const LaneArrayf pt_x = voxel_pt_camera(0) +
+                        z_f * extrinsic_scaled_f(0, 2);
+                const LaneArrayf pt_y = voxel_pt_camera(1) +
+                        z_f * extrinsic_scaled_f(1, 2);
+                const LaneArrayf pt_z = voxel_pt_camera(2) +
+                        z_f * extrinsic_scaled_f(2, 2);
+                const LaneArrayf u_f = pt_x * fx / pt_z + cx + 0.5f;
+                const LaneArrayf v_f = pt_y * fy / pt_z + cy + 0.5f;
+                LaneArrayb mask = (pt_z > 0.0f) && (u_f >= 0.0001f) &&
+                        (u_f < safe_width_f) && (v_f >= 0.0001f) &&
+                        (v_f < safe_height_f) &&
+                        (lane_offsets < static_cast<float>(lane_num));
+                if (!mask.any()) {
+                    continue;
+                }
+
+                LaneArrayf d = LaneArrayf::Zero();
+                LaneArrayf multiplier = LaneArrayf::Zero();
+                for (int32_t k = 0; k < INTEGRATION_LANE_NUM; k++) {
+                    if (mask(k)) {
+                        pixels[k] = static_cast<int32_t>(v_f(k)) * width +
+                                static_cast<int32_t>(u_f(k));
+                        d(k) = depth_data[pixels[k]];
+                        multiplier(k) = multiplier_data[pixels[k]];
+                    }
+                }
+                const LaneArrayf sdf = (d - pt_z) * multiplier;
+                mask = mask && (d > 0.0f) && (sdf > -sdf_trunc_f);
+                if (!mask.any()) {
+                    continue;
+                }
+
+                // integrate
+                const LaneArrayf tsdf = (sdf * sdf_trunc_inv_f).min(1.0f);
+                LaneArrayf voxel_tsdf, voxel_weight;
+                std::copy(tsdf_.data() + idx_shift + z, tsdf_.data() +
+                        idx_shift + z + lane_num, voxel_tsdf.data());
+                std::copy(weight_.data() + idx_shift + z, weight_.data() +
+                        idx_shift + z + lane_num, voxel_weight.data());
+                const LaneArrayf weight_inv = (voxel_weight + 1.0f).inverse();
+                if (with_color_) {
+                    LaneColorArrayf voxel_color, rgb = LaneColorArrayf::Zero();
+                    float *p_color = color_[idx_shift + z].data();
+                    std::copy(p_color, p_color + lane_num * 3,
+                            voxel_color.data());
+                    for (int32_t k = 0; k < INTEGRATION_LANE_NUM; k++) {
+                        if (mask(k)) {
+                            const uint8_t *p_rgb = color_data + pixels[k] * 3;
+                            rgb.col(k) << p_rgb[0], p_rgb[1], p_rgb[2];
                         }
                     }
+                    const LaneColorArrayf weight3 = voxel_weight.transpose().
+                            replicate<3, 1>();
+                    voxel_color = mask.transpose().replicate<3, 1>().select(
+                            (voxel_color * weight3 + rgb) *
+                            weight_inv.transpose().replicate<3, 1>(),
+                            voxel_color);
+                    std::copy(voxel_color.data(), voxel_color.data() +
+                            lane_num * 3, p_color);
                 }
+                voxel_tsdf = mask.select((voxel_tsdf * voxel_weight + tsdf) *
+                        weight_inv, voxel_tsdf);
+                voxel_weight = mask.select(voxel_weight + 1.0f, voxel_weight);
+                std::copy(voxel_tsdf.data(), voxel_tsdf.data() + lane_num,
+                        tsdf_.data() + idx_shift + z);
+                std::copy(voxel_weight.data(), voxel_weight.data() + lane_num,
+                        weight_.data() + idx_shift + z);
             }
         }
     }
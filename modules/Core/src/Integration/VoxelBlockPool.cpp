@@ -0,0 +1,169 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+#include <Open3D/Core/Integration/VoxelBlockPool.h>
+
+#include <cstring>
+
+namespace open3d {
+
+namespace {
+
+const size_t MIN_HASH_SLOT_NUM = 1024;
+
+}   // unnamed namespace
+
+VoxelBlockPool::VoxelBlockPool(size_t block_bytes,
+        size_t arena_block_num/* = 64*/) : block_bytes_(block_bytes),
+        arena_block_num_(arena_block_num > 0 ? arena_block_num : 1)
+{
+    Rehash(MIN_HASH_SLOT_NUM);
+}
+
+VoxelBlockPool::~VoxelBlockPool()
+{
+}
+
+void VoxelBlockPool::Clear()
+{
+    arenas_.clear();
+    arenas_.shrink_to_fit();
+    block_indices_.clear();
+    block_indices_.shrink_to_fit();
+    hash_table_.clear();
+    Rehash(MIN_HASH_SLOT_NUM);
+}
+
+void VoxelBlockPool::Reserve(size_t block_num)
+{
+    // keep the load factor of the hash table at or below 0.5
+    if (block_num * 2 > hash_table_.size()) {
+        size_t slot_num = hash_table_.size();
+        while (block_num * 2 > slot_num) {
+            slot_num *= 2;
+        }
+        Rehash(slot_num);
+    }
+    block_indices_.reserve(block_num);
+}
+
+int32_t VoxelBlockPool::Activate(const Eigen::Vector3i &index)
+{
+    if ((block_indices_.size() + 1) * 2 > hash_table_.size()) {
+        Rehash(hash_table_.size() * 2);
+    }
+    size_t slot = Hash(index);
+    while (hash_table_[slot].block_id_ >= 0) {
+        if (hash_table_[slot].index_ == index) {
+            return hash_table_[slot].block_id_;
+        }
+        slot = (slot + 1) & hash_mask_;
+    }
+    int32_t block_id = static_cast<int32_t>(block_indices_.size());
+    if (block_id % arena_block_num_ == 0) {
+        arenas_.push_back(std::vector<uint8_t>(
+                arena_block_num_ * block_bytes_, 0));
+    }
+    block_indices_.push_back(index);
+    hash_table_[slot].index_ = index;
+    hash_table_[slot].block_id_ = block_id;
+    return block_id;
+}
+
+void VoxelBlockPool::Erase(int32_t block_id)
+{
+    const int32_t last_id = static_cast<int32_t>(block_indices_.size()) - 1;
+    if (block_id < 0 || block_id > last_id) {
+        return;
+    }
+
+    // Remove the hash entry with backward shift deletion, so that no probe
+    // sequence is broken and no tombstones are needed.
+    size_t slot = Hash(block_indices_[block_id]);
+    while (hash_table_[slot].block_id_ != block_id) {
+        slot = (slot + 1) & hash_mask_;
+    }
+    size_t next = (slot + 1) & hash_mask_;
+    while (hash_table_[next].block_id_ >= 0) {
+        size_t home = Hash(hash_table_[next].index_);
+        if (((next - home) & hash_mask_) >= ((next - slot) & hash_mask_)) {
+            hash_table_[slot] = hash_table_[next];
+            slot = next;
+        }
+        next = (next + 1) & hash_mask_;
+    }
+    hash_table_[slot].block_id_ = -1;
+
+    if (block_id != last_id) {
+        const Eigen::Vector3i &last_index = block_indices_[last_id];
+        slot = Hash(last_index);
+        while (hash_table_[slot].block_id_ != last_id) {
+            slot = (slot + 1) & hash_mask_;
+        }
+        hash_table_[slot].block_id_ = block_id;
+        block_indices_[block_id] = last_index;
+        std::memcpy(GetBlockData(block_id), GetBlockData(last_id),
+                block_bytes_);
+    }
+    // Activate() expects the free blocks of the last arena to be zero-filled.
+    std::memset(GetBlockData(last_id), 0, block_bytes_);
+    block_indices_.pop_back();
+    if (block_indices_.size() % arena_block_num_ == 0) {
+        arenas_.pop_back();
+    }
+}
+
+size_t VoxelBlockPool::MemoryUsage() const
+{
+    return arenas_.size() * arena_block_num_ * block_bytes_ +
+            hash_table_.size() * sizeof(HashEntry) +
+            block_indices_.capacity() * sizeof(Eigen::Vector3i);
+}
+
+void VoxelBlockPool::Rehash(size_t slot_num)
+{
+    uint32_t bits = 0;
+    while ((size_t(1) << bits) < slot_num) {
+        bits++;
+    }
+    HashEntry empty_entry;
+    empty_entry.index_.setZero();
+    empty_entry.block_id_ = -1;
+    hash_table_.assign(size_t(1) << bits, empty_entry);
+    hash_mask_ = hash_table_.size() - 1;
+    hash_shift_ = 32 - bits;
+    for (size_t i = 0; i < block_indices_.size(); i++) {
+        size_t slot = Hash(block_indices_[i]);
+        while (hash_table_[slot].block_id_ >= 0) {
+            slot = (slot + 1) & hash_mask_;
+        }
+        hash_table_[slot].index_ = block_indices_[i];
+        hash_table_[slot].block_id_ = static_cast<int32_t>(i);
+    }
+}
+
+}   // namespace open3d
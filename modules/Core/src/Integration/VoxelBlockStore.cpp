@@ -0,0 +1,266 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+
+#include <Open3D/Core/Integration/VoxelBlockStore.h>
+
+#include <cstring>
+#include <liblzf/lzf.h>
+
+#include <Open3D/Core/Utility/Console.h>
+#include <Open3D/Core/Utility/FileSystem.h>
+
+namespace open3d {
+
+VoxelBlockStore::VoxelBlockStore(const std::string &filename,
+        size_t block_bytes) : filename_(filename), block_bytes_(block_bytes),
+        file_size_(0), writing_(false), stop_(false)
+{
+    file_ = std::fopen(filename.c_str(), "w+b");
+    if (file_ == NULL) {
+        PrintWarning("[VoxelBlockStore] Cannot open file %s.\n",
+                filename.c_str());
+        return;
+    }
+    writer_ = std::thread(&VoxelBlockStore::WriterLoop, this);
+}
+
+VoxelBlockStore::~VoxelBlockStore()
+{
+    if (file_ == NULL) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queue_cv_.notify_all();
+    writer_.join();
+    std::fclose(file_);
+    std::remove(filename_.c_str());
+}
+
+void VoxelBlockStore::Write(const Eigen::Vector3i &index, const uint8_t *data)
+{
+    if (file_ == NULL) {
+        return;
+    }
+    auto buffer = std::make_shared<std::vector<uint8_t>>(data,
+            data + block_bytes_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto itr = records_.find(index);
+        if (itr != records_.end()) {
+            ReleaseRecord(itr->second);
+            records_.erase(itr);
+        }
+        pending_[index] = buffer;
+        queue_.push_back(index);
+    }
+    queue_cv_.notify_one();
+}
+
+bool VoxelBlockStore::Read(const Eigen::Vector3i &index, uint8_t *data) const
+{
+    BlockRecord record;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto pending_itr = pending_.find(index);
+        if (pending_itr != pending_.end()) {
+            std::memcpy(data, pending_itr->second->data(), block_bytes_);
+            return true;
+        }
+        auto itr = records_.find(index);
+        if (itr == records_.end()) {
+            return false;
+        }
+        record = itr->second;
+    }
+    std::vector<uint8_t> buffer(record.size_);
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        if (!filesystem::SeekFile(file_, record.offset_) ||
+                std::fread(buffer.data(), 1, record.size_, file_) !=
+                record.size_) {
+            PrintWarning("[VoxelBlockStore] Read failed.\n");
+            return false;
+        }
+    }
+    if (record.size_ == block_bytes_) {
+        std::memcpy(data, buffer.data(), block_bytes_);
+    } else if (lzf_decompress(buffer.data(), record.size_, data,
+            static_cast<unsigned int>(block_bytes_)) != block_bytes_) {
+        PrintWarning("[VoxelBlockStore] Decompression failed.\n");
+        return false;
+    }
+    return true;
+}
+
+void VoxelBlockStore::Erase(const Eigen::Vector3i &index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(index);
+    auto itr = records_.find(index);
+    if (itr != records_.end()) {
+        ReleaseRecord(itr->second);
+        records_.erase(itr);
+    }
+}
+
+bool VoxelBlockStore::Contains(const Eigen::Vector3i &index) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.find(index) != pending_.end() ||
+            records_.find(index) != records_.end();
+}
+
+size_t VoxelBlockStore::NumberOfBlocks() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size() + records_.size();
+}
+
+std::vector<Eigen::Vector3i> VoxelBlockStore::GetBlockIndices() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Eigen::Vector3i> indices;
+    indices.reserve(pending_.size() + records_.size());
+    for (const auto &pending : pending_) {
+        indices.push_back(pending.first);
+    }
+    for (const auto &record : records_) {
+        indices.push_back(record.first);
+    }
+    return indices;
+}
+
+void VoxelBlockStore::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    flush_cv_.wait(lock, [this]() { return queue_.empty() && !writing_; });
+}
+
+void VoxelBlockStore::Clear()
+{
+    Flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    records_.clear();
+    free_records_.clear();
+    file_size_ = 0;
+}
+
+int64_t VoxelBlockStore::FileSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_size_;
+}
+
+void VoxelBlockStore::WriterLoop()
+{
+    std::vector<uint8_t> compressed(block_bytes_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queue_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;
+        }
+        Eigen::Vector3i index = queue_.front();
+        queue_.pop_front();
+        auto itr = pending_.find(index);
+        if (itr == pending_.end()) {
+            // erased before it was written
+            if (queue_.empty()) {
+                flush_cv_.notify_all();
+            }
+            continue;
+        }
+        std::shared_ptr<std::vector<uint8_t>> buffer = itr->second;
+        writing_ = true;
+        lock.unlock();
+
+        // A block that does not compress is stored as it is.
+        uint32_t size = lzf_compress(buffer->data(),
+                static_cast<unsigned int>(block_bytes_), compressed.data(),
+                static_cast<unsigned int>(block_bytes_ - 1));
+        const uint8_t *bytes = compressed.data();
+        if (size == 0) {
+            size = static_cast<uint32_t>(block_bytes_);
+            bytes = buffer->data();
+        }
+        lock.lock();
+        BlockRecord record = AllocateRecord(size);
+        lock.unlock();
+        bool success;
+        {
+            std::lock_guard<std::mutex> file_lock(file_mutex_);
+            success = filesystem::SeekFile(file_, record.offset_) &&
+                    std::fwrite(bytes, 1, size, file_) == size;
+        }
+        if (!success) {
+            PrintWarning("[VoxelBlockStore] Write failed.\n");
+        }
+        lock.lock();
+        // The block may have been erased or written again in the meantime.
+        itr = pending_.find(index);
+        if (success && itr != pending_.end() && itr->second == buffer) {
+            pending_.erase(itr);
+            records_[index] = record;
+        } else {
+            ReleaseRecord(record);
+        }
+        writing_ = false;
+        if (queue_.empty()) {
+            flush_cv_.notify_all();
+        }
+    }
+    flush_cv_.notify_all();
+}
+
+VoxelBlockStore::BlockRecord VoxelBlockStore::AllocateRecord(uint32_t size)
+{
+    BlockRecord record;
+    auto itr = free_records_.lower_bound(size);
+    if (itr != free_records_.end()) {
+        record.offset_ = itr->second;
+        record.capacity_ = itr->first;
+        free_records_.erase(itr);
+    } else {
+        record.offset_ = file_size_;
+        record.capacity_ = size;
+        file_size_ += size;
+    }
+    record.size_ = size;
+    return record;
+}
+
+void VoxelBlockStore::ReleaseRecord(const BlockRecord &record)
+{
+    free_records_.insert(std::make_pair(record.capacity_, record.offset_));
+}
+
+}   // namespace open3d
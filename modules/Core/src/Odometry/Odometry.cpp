@@ -27,6 +27,9 @@
 
 #include <Open3D/Core/Odometry/Odometry.h>
 
+#include <atomic>
+#include <cstring>
+#include <limits>
 #include <Eigen/Dense>
 #include <Open3D/Core/Geometry/Image.h>
 #include <Open3D/Core/Geometry/RGBDImage.h>
@@ -38,83 +41,82 @@ namespace open3d {
 
 namespace {
 
-std::tuple<std::shared_ptr<Image>, std::shared_ptr<Image>>
-        InitializeCorrespondenceMap(int32_t width, int32_t height)
+const uint64_t EMPTY_CORRESPONDENCE_KEY = std::numeric_limits<uint64_t>::max();
+const int32_t JACOBIAN_BLOCK_SIZE = 256;
+
+/// Function to map a float to an unsigned integer of the same order
+inline uint32_t FloatToOrderedUInt32(float f)
 {
-    // initialization: filling with any (u,v) to (-1,-1)
-    auto correspondence_map = std::make_shared<Image>();
-    auto depth_buffer = std::make_shared<Image>();
-    correspondence_map->PrepareImage(width, height, 2, 4);
-    depth_buffer->PrepareImage(width, height, 1, 4);
-    for (int32_t v = 0; v < correspondence_map->height_; v++) {
-        for (int32_t u = 0; u < correspondence_map->width_; u++) {
-            *PointerAt<int32_t>(*correspondence_map, u, v, 0) = -1;
-            *PointerAt<int32_t>(*correspondence_map, u, v, 1) = -1;
-            *PointerAt<float>(*depth_buffer, u, v, 0) = -1.0f;
-        }
-    }
-    return std::make_tuple(correspondence_map, depth_buffer);
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
 }
 
-inline void AddElementToCorrespondenceMap(
-        Image &correspondence_map, Image &depth_buffer,
-        int32_t u_s, int32_t v_s, int32_t u_t, int32_t v_t, float transformed_d_t) {
-    int32_t exist_u_t, exist_v_t;
-    double exist_d_t;
-    exist_u_t = *PointerAt<int32_t>(correspondence_map, u_s, v_s, 0);
-    exist_v_t = *PointerAt<int32_t>(correspondence_map, u_s, v_s, 1);
-    if (exist_u_t != -1 && exist_v_t != -1) {
-        exist_d_t = *PointerAt<float>(depth_buffer, u_s, v_s);
-        if (transformed_d_t < exist_d_t) { // update nearer point as correspondence
-            *PointerAt<int32_t>(correspondence_map, u_s, v_s, 0) = u_t;
-            *PointerAt<int32_t>(correspondence_map, u_s, v_s, 1) = v_t;
-            *PointerAt<float>(depth_buffer, u_s, v_s) = transformed_d_t;
+/// Class that holds the correspondence map of one pyramid level. It is
+/// allocated once and reused by every iteration at that level. For every
+/// source pixel it keeps the target pixel with the smallest transformed
+/// depth. The depth and the target pixel are packed into one 64 bit key, so
+/// conflicts are resolved with an atomic minimum instead of per-thread maps.
+/// Ties keep the first target pixel in raster order, as a serial search
+/// would.
+class CorrespondenceMap
+{
+public:
+    CorrespondenceMap(int32_t width, int32_t height) : width_(width),
+            height_(height), keys_(size_t(width) * size_t(height)) {}
+
+public:
+    void Clear() {
+        const int32_t pixel_num = width_ * height_;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int32_t i = 0; i < pixel_num; i++) {
+            keys_[i].store(EMPTY_CORRESPONDENCE_KEY, std::memory_order_relaxed);
         }
-    } else { // register correspondence
-        *PointerAt<int32_t>(correspondence_map, u_s, v_s, 0) = u_t;
-        *PointerAt<int32_t>(correspondence_map, u_s, v_s, 1) = v_t;
-        *PointerAt<float>(depth_buffer, u_s, v_s) = transformed_d_t;
     }
-}
 
-void MergeCorrespondenceMaps(
-        Image &correspondence_map, Image &depth_buffer,
-        Image &correspondence_map_part, Image &depth_buffer_part)
-{
-    for (int32_t v_s = 0; v_s < correspondence_map.height_; v_s++) {
-        for (int32_t u_s = 0; u_s < correspondence_map.width_; u_s++) {
-            int32_t u_t = *PointerAt<int32_t>(correspondence_map_part, u_s, v_s, 0);
-            int32_t v_t = *PointerAt<int32_t>(correspondence_map_part, u_s, v_s, 1);
-            if (u_t != -1 && v_t != -1) {
-                float transformed_d_t = *PointerAt<float>(
-                        depth_buffer_part, u_s, v_s);
-                AddElementToCorrespondenceMap(correspondence_map,
-                        depth_buffer, u_s, v_s, u_t, v_t, transformed_d_t);
+    /// Function to add a correspondence, returns true if the source pixel
+    /// had none before
+    bool Add(int32_t source_index, int32_t target_index, float depth) {
+        const uint64_t key =
+                (static_cast<uint64_t>(FloatToOrderedUInt32(depth)) << 32) |
+                static_cast<uint64_t>(target_index);
+        std::atomic<uint64_t> &slot = keys_[source_index];
+        uint64_t current = slot.load(std::memory_order_relaxed);
+        while (key < current) {
+            if (slot.compare_exchange_weak(current, key,
+                    std::memory_order_relaxed)) {
+                return current == EMPTY_CORRESPONDENCE_KEY;
             }
         }
+        return false;
     }
-}
 
-int32_t CountCorrespondence(const Image &correspondence_map)
-{
-    int32_t correspondence_count = 0;
-    for (int32_t v_s = 0; v_s < correspondence_map.height_; v_s++) {
-        for (int32_t u_s = 0; u_s < correspondence_map.width_; u_s++) {
-            int32_t u_t = *PointerAt<int32_t>(correspondence_map, u_s, v_s, 0);
-            int32_t v_t = *PointerAt<int32_t>(correspondence_map, u_s, v_s, 1);
-            if (u_t != -1 && v_t != -1) {
-                correspondence_count++;
-            }
-        }
+    /// Function to return the target pixel of a source pixel, or -1
+    int32_t GetTargetIndex(int32_t source_index) const {
+        const uint64_t key = keys_[source_index].load(
+                std::memory_order_relaxed);
+        return key == EMPTY_CORRESPONDENCE_KEY ? -1 :
+                static_cast<int32_t>(key & 0xffffffffu);
     }
-    return correspondence_count;
-}
 
-std::shared_ptr<CorrespondenceSetPixelWise> ComputeCorrespondence(
+public:
+    int32_t width_;
+    int32_t height_;
+
+private:
+    std::vector<std::atomic<uint64_t>> keys_;
+};
+
+/// Function to fill the correspondence map, returns the number of source
+/// pixels that have a correspondence
+int32_t SearchCorrespondence(
         const Eigen::Matrix3d intrinsic_matrix,
         const Eigen::Matrix4d &extrinsic,
         const Image &depth_s, const Image &depth_t,
-        const OdometryOption &option)
+        const OdometryOption &option,
+        CorrespondenceMap &correspondence_map)
 {
     const Eigen::Matrix3d K = intrinsic_matrix;
     const Eigen::Matrix3d K_inv = K.inverse();
@@ -123,25 +125,15 @@ std::shared_ptr<CorrespondenceSetPixelWise> ComputeCorrespondence(
     const Eigen::Matrix3d KRK_inv = K * R * K_inv;
     Eigen::Vector3d Kt = K * extrinsic_inv.block<3, 1>(0, 3);
 
-    std::shared_ptr<Image> correspondence_map;
-    std::shared_ptr<Image> depth_buffer;
-    std::tie(correspondence_map, depth_buffer) =
-            InitializeCorrespondenceMap(depth_t.width_, depth_t.height_);
-
-#ifdef _OPENMP
-#pragma omp parallel
-    {
-#endif
-    std::shared_ptr<Image> correspondence_map_private;
-    std::shared_ptr<Image> depth_buffer_private;
-    std::tie(correspondence_map_private, depth_buffer_private) =
-            InitializeCorrespondenceMap(depth_t.width_, depth_t.height_);
+    correspondence_map.Clear();
+    int32_t correspondence_count = 0;
 #ifdef _OPENMP
-#pragma omp for nowait
+#pragma omp parallel for schedule(static) reduction(+:correspondence_count)
 #endif
     for (int32_t v_t = 0; v_t < depth_t.height_; v_t++) {
+        const float *depth_t_row = PointerAt<float>(depth_t, 0, v_t);
         for (int32_t u_t = 0; u_t < depth_t.width_; u_t++) {
-            double d_t = *PointerAt<float>(depth_t, u_t, v_t);
+            double d_t = depth_t_row[u_t];
             if (!std::isnan(d_t)) {
                 Eigen::Vector3d uv_in_t =
                         d_t * KRK_inv * Eigen::Vector3d(u_t, v_t, 1.0) + Kt;
@@ -153,38 +145,41 @@ std::shared_ptr<CorrespondenceSetPixelWise> ComputeCorrespondence(
                     double d_s = *PointerAt<float>(depth_s, u_s, v_s);
                     if (!std::isnan(d_s) && std::abs(transformed_d_t - d_s)
                         <= option.max_depth_diff_) {
-                        AddElementToCorrespondenceMap(
-                                *correspondence_map_private,
-                                *depth_buffer_private,
-                                u_s, v_s, u_t, v_t, static_cast<float>(transformed_d_t));
+                        if (correspondence_map.Add(
+                                v_s * depth_t.width_ + u_s,
+                                v_t * depth_t.width_ + u_t,
+                                static_cast<float>(transformed_d_t))) {
+                            correspondence_count++;
+                        }
                     }
                 }
             }
         }
     }
-#ifdef _OPENMP
-#pragma omp critical
+    return correspondence_count;
+}
+
+std::shared_ptr<CorrespondenceSetPixelWise> ComputeCorrespondence(
+        const Eigen::Matrix3d intrinsic_matrix,
+        const Eigen::Matrix4d &extrinsic,
+        const Image &depth_s, const Image &depth_t,
+        const OdometryOption &option)
 {
-#endif
-    MergeCorrespondenceMaps(
-            *correspondence_map, *depth_buffer,
-            *correspondence_map_private, *depth_buffer_private);
-#ifdef _OPENMP
-}   //  omp critical
-}   //  omp parallel
-#endif
+    CorrespondenceMap correspondence_map(depth_t.width_, depth_t.height_);
+    int32_t correspondence_count = SearchCorrespondence(intrinsic_matrix,
+            extrinsic, depth_s, depth_t, option, correspondence_map);
 
     auto correspondence = std::make_shared<CorrespondenceSetPixelWise>();
-    int32_t correspondence_count = CountCorrespondence(*correspondence_map);
     correspondence->resize(correspondence_count);
     int32_t cnt = 0;
-    for (int32_t v_s = 0; v_s < correspondence_map->height_; v_s++) {
-        for (int32_t u_s = 0; u_s < correspondence_map->width_; u_s++) {
-            int32_t u_t = *PointerAt<int32_t>(*correspondence_map, u_s, v_s, 0);
-            int32_t v_t = *PointerAt<int32_t>(*correspondence_map, u_s, v_s, 1);
-            if (u_t != -1 && v_t != -1) {
-                Eigen::Vector4i pixel_correspondence(u_s, v_s, u_t, v_t);
-                (*correspondence)[cnt] = pixel_correspondence;
+    for (int32_t v_s = 0; v_s < correspondence_map.height_; v_s++) {
+        for (int32_t u_s = 0; u_s < correspondence_map.width_; u_s++) {
+            int32_t target_index = correspondence_map.GetTargetIndex(
+                    v_s * correspondence_map.width_ + u_s);
+            if (target_index >= 0) {
+                (*correspondence)[cnt] = Eigen::Vector4i(u_s, v_s,
+                        target_index % correspondence_map.width_,
+                        target_index / correspondence_map.width_);
                 cnt++;
             }
         }
@@ -240,16 +235,12 @@ std::vector<Eigen::Matrix3d>
 
 Eigen::Matrix6d CreateInfomationMatrix(
         const Eigen::Matrix4d &extrinsic,
-        const PinholeCameraIntrinsic &pinhole_camera_intrinsic,
-        const Image &depth_s, const Image &depth_t,
+        const Eigen::Matrix3d &intrinsic_matrix,
+        const Image &depth_s, const Image &depth_t, const Image &xyz_t,
         const OdometryOption &option)
 {
     auto correspondence = ComputeCorrespondence(
-            pinhole_camera_intrinsic.intrinsic_matrix_,
-            extrinsic, depth_s, depth_t, option);
-
-    auto xyz_t = ConvertDepthImageToXYZImage(
-            depth_t, pinhole_camera_intrinsic.intrinsic_matrix_);
+            intrinsic_matrix, extrinsic, depth_s, depth_t, option);
 
     // write q^*
     // see http://redwood-data.org/indoor/registration.html
@@ -259,17 +250,17 @@ Eigen::Matrix6d CreateInfomationMatrix(
 #pragma omp parallel
     {
 #endif
-        Eigen::Matrix6d GTG_private = Eigen::Matrix6d::Identity();
+        Eigen::Matrix6d GTG_private = Eigen::Matrix6d::Zero();
         Eigen::Vector6d G_r_private = Eigen::Vector6d::Zero();
 #ifdef _OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp for schedule(static)
 #endif
         for (int32_t row = 0; row < static_cast<int32_t>(correspondence->size()); row++) {
             int32_t u_t = (*correspondence)[row](2);
             int32_t v_t = (*correspondence)[row](3);
-            double x = *PointerAt<float>(*xyz_t, u_t, v_t, 0);
-            double y = *PointerAt<float>(*xyz_t, u_t, v_t, 1);
-            double z = *PointerAt<float>(*xyz_t, u_t, v_t, 2);
+            double x = *PointerAt<float>(xyz_t, u_t, v_t, 0);
+            double y = *PointerAt<float>(xyz_t, u_t, v_t, 1);
+            double z = *PointerAt<float>(xyz_t, u_t, v_t, 2);
             G_r_private.setZero();
             G_r_private(0) = 1.0;
             G_r_private(4) = 2.0 * z;
@@ -298,14 +289,12 @@ Eigen::Matrix6d CreateInfomationMatrix(
     return std::move(GTG);
 }
 
-void NormalizeIntensity(Image &image_s, Image &image_t,
-        CorrespondenceSetPixelWise &correspondence)
+/// Function to return the scales that bring the mean intensity of the
+/// corresponding pixels of both images to 0.5
+std::tuple<double, double> ComputeIntensityScales(
+        const Image &image_s, const Image &image_t,
+        const CorrespondenceSetPixelWise &correspondence)
 {
-    if (image_s.width_ != image_t.width_ ||
-        image_s.height_ != image_t.height_) {
-        PrintError("[NormalizeIntensity] Size of two input images should be same\n");
-        return;
-    }
     double mean_s = 0.0, mean_t = 0.0;
     for (size_t row = 0; row < correspondence.size(); row++) {
         int32_t u_s = correspondence[row](0);
@@ -317,13 +306,18 @@ void NormalizeIntensity(Image &image_s, Image &image_t,
     }
     mean_s /= (double)correspondence.size();
     mean_t /= (double)correspondence.size();
-    LinearTransformImage(image_s, 0.5 / mean_s, 0.0);
-    LinearTransformImage(image_t, 0.5 / mean_t, 0.0);
+    return std::make_tuple(0.5 / mean_s, 0.5 / mean_t);
 }
 
-inline std::shared_ptr<RGBDImage> PackRGBDImage(
-    const Image &color, const Image &depth) {
-    return std::make_shared<RGBDImage>(RGBDImage(color, depth));
+/// Function to copy a level of a frame with its intensity scaled
+/// Pyramids and Sobel filters are linear, so this is the same as building
+/// them from the scaled image.
+std::shared_ptr<RGBDImage> PackScaledRGBDImage(
+        const RGBDImage &image, double color_scale)
+{
+    auto output = std::make_shared<RGBDImage>(image.color_, image.depth_);
+    LinearTransformImage(output->color_, color_scale, 0.0);
+    return output;
 }
 
 std::shared_ptr<Image> PreprocessDepth(
@@ -364,37 +358,171 @@ inline bool CheckRGBDImagePair(const RGBDImage &source, const RGBDImage &target)
             target.depth_.bytes_per_channel_ == 4);
 }
 
-std::tuple<std::shared_ptr<RGBDImage>, std::shared_ptr<RGBDImage>>
-        InitializeRGBDOdometry(
-        const RGBDImage &source, const RGBDImage &target,
+/// Function to preprocess an RGB-D image into a frame
+/// The gradients are only used when the frame is the target.
+void CreateOdometryFrame(OdometryFrame &frame, const RGBDImage &image,
         const PinholeCameraIntrinsic &pinhole_camera_intrinsic,
-        const Eigen::Matrix4d &odo_init,
-        const OdometryOption &option)
+        const OdometryOption &option, bool with_gradients)
 {
-    auto source_gray = FilterImage(source.color_,
-            Image::FilterType::Gaussian3);
-    auto target_gray = FilterImage(target.color_,
-            Image::FilterType::Gaussian3);
-    auto source_depth_preprocessed = PreprocessDepth(source.depth_, option);
-    auto target_depth_preprocessed = PreprocessDepth(target.depth_, option);
-    auto source_depth = FilterImage(*source_depth_preprocessed,
-            Image::FilterType::Gaussian3);
-    auto target_depth = FilterImage(*target_depth_preprocessed,
+    frame.intrinsic_ = pinhole_camera_intrinsic;
+    if (!CheckImagePair(image.color_, image.depth_) ||
+            image.color_.num_of_channels_ != 1 ||
+            image.depth_.num_of_channels_ != 1 ||
+            image.color_.bytes_per_channel_ != 4 ||
+            image.depth_.bytes_per_channel_ != 4) {
+        PrintWarning("[OdometryFrame] Unsupported image format.\n");
+        return;
+    }
+    uint8_t num_levels = static_cast<uint8_t>(
+            option.iteration_number_per_pyramid_level_.size());
+    auto gray = FilterImage(image.color_, Image::FilterType::Gaussian3);
+    auto depth = FilterImage(*PreprocessDepth(image.depth_, option),
             Image::FilterType::Gaussian3);
+    frame.pyramid_ = CreateRGBDImagePyramid(RGBDImage(*gray, *depth),
+            num_levels);
+    if (with_gradients) {
+        frame.pyramid_dx_ = FilterRGBDImagePyramid(frame.pyramid_,
+                Image::FilterType::Sobel3Dx);
+        frame.pyramid_dy_ = FilterRGBDImagePyramid(frame.pyramid_,
+                Image::FilterType::Sobel3Dy);
+    }
+    frame.camera_matrix_pyramid_ = CreateCameraMatrixPyramid(
+            frame.intrinsic_, num_levels);
+    frame.xyz_pyramid_.resize(num_levels);
+    for (uint8_t level = 0; level < num_levels; level++) {
+        frame.xyz_pyramid_[level] = ConvertDepthImageToXYZImage(
+                frame.pyramid_[level]->depth_,
+                frame.camera_matrix_pyramid_[level]);
+    }
+}
+
+inline bool CheckOdometryFramePair(const OdometryFrame &source,
+        const OdometryFrame &target, const OdometryOption &option)
+{
+    return (!source.IsEmpty() && !target.IsEmpty() &&
+            source.NumberOfLevels() ==
+            option.iteration_number_per_pyramid_level_.size() &&
+            target.NumberOfLevels() == source.NumberOfLevels() &&
+            target.pyramid_dx_.size() == target.NumberOfLevels() &&
+            target.pyramid_dy_.size() == target.NumberOfLevels() &&
+            CheckImagePair(source.pyramid_[0]->color_,
+            target.pyramid_[0]->color_) &&
+            source.intrinsic_.intrinsic_matrix_ ==
+            target.intrinsic_.intrinsic_matrix_);
+}
 
+std::tuple<double, double> InitializeRGBDOdometry(
+        const OdometryFrame &source, const OdometryFrame &target,
+        const Eigen::Matrix4d &odo_init,
+        const OdometryOption &option)
+{
+    const RGBDImage &source_level = *source.pyramid_[0];
+    const RGBDImage &target_level = *target.pyramid_[0];
     auto correspondence = ComputeCorrespondence(
-            pinhole_camera_intrinsic.intrinsic_matrix_, odo_init,
-            *source_depth, *target_depth, option);
-    size_t corresps_count_required = static_cast<size_t>(source_gray->height_ *
-            source_gray->width_ * option.minimum_correspondence_ratio_ + 0.5);
+            source.camera_matrix_pyramid_[0], odo_init,
+            source_level.depth_, target_level.depth_, option);
+    size_t corresps_count_required = static_cast<size_t>(
+            source_level.color_.height_ * source_level.color_.width_ *
+            option.minimum_correspondence_ratio_ + 0.5);
     if (correspondence->size() < corresps_count_required) {
         PrintWarning("[InitializeRGBDPair] Bad initial pose\n");
     }
-    NormalizeIntensity(*source_gray, *target_gray, *correspondence);
+    return ComputeIntensityScales(source_level.color_, target_level.color_,
+            *correspondence);
+}
 
-    auto source_out = PackRGBDImage(*source_gray, *source_depth);
-    auto target_out = PackRGBDImage(*target_gray, *target_depth);
-    return std::make_tuple(source_out, target_out);
+/// Function to compute JTJ and JTr directly from the correspondence map
+/// Same reduction as ComputeJTJandJTr(), without building the
+/// correspondence set first. The correspondences are handed to the batch
+/// kernel of the Jacobian in blocks of JACOBIAN_BLOCK_SIZE, or one at a time
+/// if it has none.
+std::tuple<Eigen::Matrix6d, Eigen::Vector6d> ComputeJTJandJTrFromMap(
+        const CorrespondenceMap &correspondence_map,
+        int32_t correspondence_count,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        const RGBDOdometryJacobian &jacobian_method)
+{
+    const int32_t width = correspondence_map.width_;
+    Eigen::Matrix6d JTJ;
+    Eigen::Vector6d JTr;
+    double r2_sum = 0.0;
+    JTJ.setZero();
+    JTr.setZero();
+#ifdef _OPENMP
+#pragma omp parallel
+    {
+#endif
+        Eigen::Matrix6d JTJ_private;
+        Eigen::Vector6d JTr_private;
+        double r2_sum_private = 0.0;
+        JTJ_private.setZero();
+        JTr_private.setZero();
+        std::vector<double> r;
+        std::vector<Eigen::Vector6d> J_r;
+        int32_t source_indices[JACOBIAN_BLOCK_SIZE];
+        int32_t target_indices[JACOBIAN_BLOCK_SIZE];
+        int32_t block_count = 0;
+        auto AccumulateBlock = [&]() {
+            if (!jacobian_method.AccumulateJTJandJTr(source_indices,
+                    target_indices, block_count, source, target, source_xyz,
+                    target_dx, target_dy, intrinsic, extrinsic, JTJ_private,
+                    JTr_private, r2_sum_private)) {
+                for (int32_t k = 0; k < block_count; k++) {
+                    jacobian_method.ComputePixelJacobianAndResidual(
+                            Eigen::Vector4i(source_indices[k] % width,
+                            source_indices[k] / width,
+                            target_indices[k] % width,
+                            target_indices[k] / width), J_r, r, source,
+                            target, source_xyz, target_dx, target_dy,
+                            intrinsic, extrinsic);
+                    for (size_t j = 0; j < r.size(); j++) {
+                        JTJ_private.noalias() += J_r[j] * J_r[j].transpose();
+                        JTr_private.noalias() += J_r[j] * r[j];
+                        r2_sum_private += r[j] * r[j];
+                    }
+                }
+            }
+            block_count = 0;
+        };
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+        for (int32_t v_s = 0; v_s < correspondence_map.height_; v_s++) {
+            for (int32_t u_s = 0; u_s < width; u_s++) {
+                int32_t target_index = correspondence_map.GetTargetIndex(
+                        v_s * width + u_s);
+                if (target_index < 0) {
+                    continue;
+                }
+                source_indices[block_count] = v_s * width + u_s;
+                target_indices[block_count] = target_index;
+                if (++block_count == JACOBIAN_BLOCK_SIZE) {
+                    AccumulateBlock();
+                }
+            }
+        }
+        if (block_count > 0) {
+            AccumulateBlock();
+        }
+#ifdef _OPENMP
+#pragma omp critical
+        {
+#endif
+            JTJ += JTJ_private;
+            JTr += JTr_private;
+            r2_sum += r2_sum_private;
+#ifdef _OPENMP
+        }
+    }
+#endif
+    r2_sum /= (double)correspondence_count;
+    PrintDebug("Residual : %.2e (# of elements : %d)\n", r2_sum,
+            correspondence_count);
+    return std::make_tuple(std::move(JTJ), std::move(JTr));
 }
 
 std::tuple<bool, Eigen::Matrix4d> DoSingleIteration(
@@ -405,30 +533,27 @@ std::tuple<bool, Eigen::Matrix4d> DoSingleIteration(
     const Eigen::Matrix3d intrinsic,
     const Eigen::Matrix4d &extrinsic_initial,
     const RGBDOdometryJacobian &jacobian_method,
-    const OdometryOption &option)
+    const OdometryOption &option,
+    CorrespondenceMap &correspondence_map)
 {
-    auto correspondence = ComputeCorrespondence(
-            intrinsic, extrinsic_initial, source.depth_, target.depth_, option);
+    int32_t correspondence_count = SearchCorrespondence(intrinsic,
+            extrinsic_initial, source.depth_, target.depth_, option,
+            correspondence_map);
     size_t corresps_count_required = static_cast<size_t>(source.color_.height_ *
             source.color_.width_ * option.minimum_correspondence_ratio_ + 0.5);
-    size_t corresps_count = static_cast<size_t>(correspondence->size());
+    size_t corresps_count = static_cast<size_t>(correspondence_count);
     if (corresps_count < corresps_count_required) {
         PrintWarning("[ComputeOdometry] Too fewer correspondences (%d found / %d required)\n",
                 corresps_count, corresps_count_required);
         return std::make_tuple(false, Eigen::Matrix4d::Identity());
     }
 
-    auto f_lambda = [&]
-            (size_t i, std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r) {
-        jacobian_method.ComputeJacobianAndResidual(i, J_r, r,
-                source, target, source_xyz, target_dx, target_dy,
-                intrinsic, extrinsic_initial, *correspondence);
-    };
     PrintDebug("Iter : %d, Level : %d, ", iter, level);
     Eigen::Matrix6d JTJ;
     Eigen::Vector6d JTr;
-    std::tie(JTJ, JTr) = ComputeJTJandJTr<Eigen::Matrix6d, Eigen::Vector6d>(
-            f_lambda, corresps_count);
+    std::tie(JTJ, JTr) = ComputeJTJandJTrFromMap(correspondence_map,
+            correspondence_count, source, target, source_xyz, target_dx,
+            target_dy, intrinsic, extrinsic_initial, jacobian_method);
 
     bool is_success;
     Eigen::Matrix4d extrinsic;
@@ -443,51 +568,41 @@ std::tuple<bool, Eigen::Matrix4d> DoSingleIteration(
 }
 
 std::tuple<bool, Eigen::Matrix4d> ComputeMultiscale(
-        const RGBDImage &source, const RGBDImage &target,
-        const PinholeCameraIntrinsic &pinhole_camera_intrinsic,
+        const OdometryFrame &source, const OdometryFrame &target,
+        double source_scale, double target_scale,
         const Eigen::Matrix4d &extrinsic_initial,
         const RGBDOdometryJacobian &jacobian_method,
         const OdometryOption &option)
 {
     std::vector<size_t> iter_counts = option.iteration_number_per_pyramid_level_;
-    uint8_t num_levels = static_cast<uint8_t>(iter_counts.size());
-
-    auto source_pyramid = CreateRGBDImagePyramid(source, num_levels);
-    auto target_pyramid = CreateRGBDImagePyramid(target, num_levels);
-    auto target_pyramid_dx = FilterRGBDImagePyramid
-            (target_pyramid, Image::FilterType::Sobel3Dx);
-    auto target_pyramid_dy = FilterRGBDImagePyramid
-            (target_pyramid, Image::FilterType::Sobel3Dy);
+    int32_t num_levels = static_cast<int32_t>(iter_counts.size());
 
     Eigen::Matrix4d result_odo = extrinsic_initial.isZero() ?
             Eigen::Matrix4d::Identity() : extrinsic_initial;
 
-    std::vector<Eigen::Matrix3d> pyramid_camera_matrix =
-            CreateCameraMatrixPyramid(pinhole_camera_intrinsic,
-            static_cast<uint8_t>(iter_counts.size()));
-
-    for (uint8_t level = num_levels - 1; level >= 0; level--) {
-        const Eigen::Matrix3d level_camera_matrix = pyramid_camera_matrix[level];
-
-        auto source_xyz_level = ConvertDepthImageToXYZImage(
-                source_pyramid[level]->depth_, level_camera_matrix);
-        auto source_level = PackRGBDImage(source_pyramid[level]->color_,
-                source_pyramid[level]->depth_);
-        auto target_level = PackRGBDImage(target_pyramid[level]->color_,
-                target_pyramid[level]->depth_);
-        auto target_dx_level = PackRGBDImage(target_pyramid_dx[level]->color_,
-                target_pyramid_dx[level]->depth_);
-        auto target_dy_level = PackRGBDImage(target_pyramid_dy[level]->color_,
-                target_pyramid_dy[level]->depth_);
+    for (int32_t level = num_levels - 1; level >= 0; level--) {
+        const Eigen::Matrix3d level_camera_matrix =
+                source.camera_matrix_pyramid_[level];
+
+        auto source_level = PackScaledRGBDImage(*source.pyramid_[level],
+                source_scale);
+        auto target_level = PackScaledRGBDImage(*target.pyramid_[level],
+                target_scale);
+        auto target_dx_level = PackScaledRGBDImage(
+                *target.pyramid_dx_[level], target_scale);
+        auto target_dy_level = PackScaledRGBDImage(
+                *target.pyramid_dy_[level], target_scale);
+        CorrespondenceMap correspondence_map(source_level->depth_.width_,
+                source_level->depth_.height_);
 
         for (size_t iter = 0; iter < iter_counts[num_levels - level - 1]; iter++) {
             Eigen::Matrix4d curr_odo;
             bool is_success;
             std::tie(is_success, curr_odo) = DoSingleIteration(
                 iter, level,
-                *source_level, *target_level, *source_xyz_level,
+                *source_level, *target_level, *source.xyz_pyramid_[level],
                 *target_dx_level, *target_dy_level, level_camera_matrix,
-                result_odo, jacobian_method, option);
+                result_odo, jacobian_method, option, correspondence_map);
             result_odo = curr_odo * result_odo;
 
             if (!is_success) {
@@ -501,6 +616,23 @@ std::tuple<bool, Eigen::Matrix4d> ComputeMultiscale(
 
 }   // unnamed namespace
 
+OdometryFrame::OdometryFrame(const RGBDImage &image,
+        const PinholeCameraIntrinsic &pinhole_camera_intrinsic
+        /* = PinholeCameraIntrinsic()*/,
+        const OdometryOption &option /* = OdometryOption()*/)
+{
+    CreateOdometryFrame(*this, image, pinhole_camera_intrinsic, option, true);
+}
+
+OdometryFrame::~OdometryFrame()
+{
+}
+
+bool OdometryFrame::IsEmpty() const
+{
+    return pyramid_.empty();
+}
+
 std::tuple<bool, Eigen::Matrix4d, Eigen::Matrix6d>
         ComputeRGBDOdometry(const RGBDImage &source, const RGBDImage &target,
         const PinholeCameraIntrinsic &pinhole_camera_intrinsic
@@ -515,23 +647,43 @@ std::tuple<bool, Eigen::Matrix4d, Eigen::Matrix6d>
         return std::make_tuple(false,
                 Eigen::Matrix4d::Identity(), Eigen::Matrix6d::Zero());
     }
+    OdometryFrame source_frame, target_frame;
+    CreateOdometryFrame(source_frame, source, pinhole_camera_intrinsic, option,
+            false);
+    CreateOdometryFrame(target_frame, target, pinhole_camera_intrinsic, option,
+            true);
+    return ComputeRGBDOdometry(source_frame, target_frame, odo_init,
+            jacobian_method, option);
+}
+
+std::tuple<bool, Eigen::Matrix4d, Eigen::Matrix6d>
+        ComputeRGBDOdometry(const OdometryFrame &source,
+        const OdometryFrame &target,
+        const Eigen::Matrix4d &odo_init /*= Eigen::Matrix4d::Identity()*/,
+        const RGBDOdometryJacobian &jacobian_method
+        /*=RGBDOdometryJacobianFromHybridTerm*/,
+        const OdometryOption &option /*= OdometryOption()*/)
+{
+    if (!CheckOdometryFramePair(source, target, option)) {
+        PrintError("[RGBDOdometry] Two frames should be same in size, intrinsic and number of levels.\n");
+        return std::make_tuple(false,
+                Eigen::Matrix4d::Identity(), Eigen::Matrix6d::Zero());
+    }
 
-    std::shared_ptr<RGBDImage> source_processed, target_processed;
-    std::tie(source_processed, target_processed) =
-            InitializeRGBDOdometry(source, target, pinhole_camera_intrinsic,
-            odo_init, option);
+    double source_scale, target_scale;
+    std::tie(source_scale, target_scale) = InitializeRGBDOdometry(
+            source, target, odo_init, option);
 
     Eigen::Matrix4d extrinsic;
     bool is_success;
-    std::tie(is_success, extrinsic) = ComputeMultiscale(
-            *source_processed, *target_processed,
-            pinhole_camera_intrinsic, odo_init, jacobian_method, option);
+    std::tie(is_success, extrinsic) = ComputeMultiscale(source, target,
+            source_scale, target_scale, odo_init, jacobian_method, option);
 
     if (is_success) {
         Eigen::Matrix4d trans_output = extrinsic;
         Eigen::MatrixXd info_output = CreateInfomationMatrix(extrinsic,
-                pinhole_camera_intrinsic, source_processed->depth_,
-                target_processed->depth_, option);
+                source.camera_matrix_pyramid_[0], source.pyramid_[0]->depth_,
+                target.pyramid_[0]->depth_, *target.xyz_pyramid_[0], option);
         return std::make_tuple(true, trans_output, info_output);
     }
     else {
@@ -27,6 +27,9 @@
 
 #include <Open3D/Core/Odometry/Odometry.h>
 
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
 #include <Open3D/Core/Geometry/Image.h>
 #include <Open3D/Core/Geometry/RGBDImage.h>
 #include <Open3D/Core/Odometry/RGBDOdometryJacobian.h>
@@ -37,25 +40,162 @@ namespace {
 
 const double SOBEL_SCALE = 0.125;
 const double LAMBDA_HYBRID_DEPTH = 0.968;
+const int32_t JACOBIAN_LANE_NUM = 8;
+typedef Eigen::Array<float, JACOBIAN_LANE_NUM, 1> LaneArrayf;
 
-}   // unnamed namespace
+/// Pointers to the image data read by the batch kernels
+struct KernelImages
+{
+    KernelImages(const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy) :
+            source_color_(Data(source.color_)),
+            target_color_(Data(target.color_)),
+            target_depth_(Data(target.depth_)),
+            source_xyz_(Data(source_xyz)),
+            target_dx_color_(Data(target_dx.color_)),
+            target_dx_depth_(Data(target_dx.depth_)),
+            target_dy_color_(Data(target_dy.color_)),
+            target_dy_depth_(Data(target_dy.depth_)) {}
 
-void RGBDOdometryJacobianFromColorTerm::ComputeJacobianAndResidual(
-        size_t row, std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+    static const float *Data(const Image &image) {
+        return reinterpret_cast<const float *>(image.data_.data());
+    }
+
+    const float *source_color_;
+    const float *target_color_;
+    const float *target_depth_;
+    const float *source_xyz_;
+    const float *target_dx_color_;
+    const float *target_dx_depth_;
+    const float *target_dy_color_;
+    const float *target_dy_depth_;
+};
+
+/// Structure of arrays of one lane of correspondences: the source points
+/// transformed by the current estimate and the target values. Lanes past the
+/// end of a block have valid_ = 0, a point at z = 1 and zero values.
+struct CorrespondenceLane
+{
+    LaneArrayf valid_;
+    LaneArrayf x_, y_, z_;
+    LaneArrayf diff_photo_;
+    LaneArrayf dIdx_, dIdy_;
+    LaneArrayf depth_t_;
+    LaneArrayf dDdx_, dDdy_;
+};
+
+void GatherCorrespondenceLane(const int32_t *source_indices,
+        const int32_t *target_indices, int32_t lane_num,
+        const KernelImages &images, const Eigen::Matrix3f &R,
+        const Eigen::Vector3f &t, bool with_depth, CorrespondenceLane &lane)
+{
+    LaneArrayf x_s = LaneArrayf::Zero();
+    LaneArrayf y_s = LaneArrayf::Zero();
+    LaneArrayf z_s = LaneArrayf::Zero();
+    lane.valid_.setZero();
+    lane.diff_photo_.setZero();
+    lane.dIdx_.setZero();
+    lane.dIdy_.setZero();
+    for (int32_t k = 0; k < lane_num; k++) {
+        const int32_t s = source_indices[k];
+        const int32_t t_idx = target_indices[k];
+        lane.valid_(k) = 1.0f;
+        x_s(k) = images.source_xyz_[s * 3];
+        y_s(k) = images.source_xyz_[s * 3 + 1];
+        z_s(k) = images.source_xyz_[s * 3 + 2];
+        lane.diff_photo_(k) = images.target_color_[t_idx] -
+                images.source_color_[s];
+        lane.dIdx_(k) = images.target_dx_color_[t_idx];
+        lane.dIdy_(k) = images.target_dy_color_[t_idx];
+    }
+    lane.x_ = R(0, 0) * x_s + R(0, 1) * y_s + R(0, 2) * z_s + t(0);
+    lane.y_ = R(1, 0) * x_s + R(1, 1) * y_s + R(1, 2) * z_s + t(1);
+    lane.z_ = R(2, 0) * x_s + R(2, 1) * y_s + R(2, 2) * z_s + t(2);
+    lane.x_ *= lane.valid_;
+    lane.y_ *= lane.valid_;
+    lane.z_ = lane.z_ * lane.valid_ + (1.0f - lane.valid_);
+    lane.dIdx_ *= static_cast<float>(SOBEL_SCALE);
+    lane.dIdy_ *= static_cast<float>(SOBEL_SCALE);
+    if (with_depth) {
+        lane.depth_t_.setZero();
+        lane.dDdx_.setZero();
+        lane.dDdy_.setZero();
+        for (int32_t k = 0; k < lane_num; k++) {
+            const int32_t t_idx = target_indices[k];
+            lane.depth_t_(k) = images.target_depth_[t_idx];
+            float dDdx = images.target_dx_depth_[t_idx];
+            float dDdy = images.target_dy_depth_[t_idx];
+            lane.dDdx_(k) = std::isnan(dDdx) ? 0.0f : dDdx;
+            lane.dDdy_(k) = std::isnan(dDdy) ? 0.0f : dDdy;
+        }
+        lane.dDdx_ *= static_cast<float>(SOBEL_SCALE);
+        lane.dDdy_ *= static_cast<float>(SOBEL_SCALE);
+    }
+}
+
+/// Class that sums the upper triangle of J^T J, J^T r and r^T r of a block
+/// in float lanes. The sums are added to the double precision totals once
+/// per block, so that the float sums stay short.
+class LaneJTJAccumulator
+{
+public:
+    LaneJTJAccumulator() {
+        for (auto &a : JTJ_) a.setZero();
+        for (auto &a : JTr_) a.setZero();
+        r2_.setZero();
+    }
+
+public:
+    void Add(const LaneArrayf (&J)[6], const LaneArrayf &r) {
+        int32_t k = 0;
+        for (int32_t i = 0; i < 6; i++) {
+            for (int32_t j = i; j < 6; j++) {
+                JTJ_[k++] += J[i] * J[j];
+            }
+            JTr_[i] += J[i] * r;
+        }
+        r2_ += r * r;
+    }
+
+    void AddTo(Eigen::Matrix6d &JTJ, Eigen::Vector6d &JTr,
+            double &r2_sum) const {
+        int32_t k = 0;
+        for (int32_t i = 0; i < 6; i++) {
+            for (int32_t j = i; j < 6; j++) {
+                const double sum = JTJ_[k++].sum();
+                JTJ(i, j) += sum;
+                if (i != j) {
+                    JTJ(j, i) += sum;
+                }
+            }
+            JTr(i) += JTr_[i].sum();
+        }
+        r2_sum += r2_.sum();
+    }
+
+private:
+    LaneArrayf JTJ_[21];
+    LaneArrayf JTr_[6];
+    LaneArrayf r2_;
+};
+
+void ComputeColorTermJacobianAndResidual(
+        const Eigen::Vector4i &corresp,
+        std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
         const RGBDImage &source, const RGBDImage &target,
         const Image &source_xyz,
         const RGBDImage &target_dx, const RGBDImage &target_dy,
         const Eigen::Matrix3d &intrinsic,
-        const Eigen::Matrix4d &extrinsic,
-        const CorrespondenceSetPixelWise &corresps) const
+        const Eigen::Matrix4d &extrinsic)
 {
     Eigen::Matrix3d R = extrinsic.block<3, 3>(0, 0);
     Eigen::Vector3d t = extrinsic.block<3, 1>(0, 3);
 
-    int32_t u_s = corresps[row](0);
-    int32_t v_s = corresps[row](1);
-    int32_t u_t = corresps[row](2);
-    int32_t v_t = corresps[row](3);
+    int32_t u_s = corresp(0);
+    int32_t v_s = corresp(1);
+    int32_t u_t = corresp(2);
+    int32_t v_t = corresp(3);
     double diff = *PointerAt<float>(target.color_, u_t, v_t) -
             *PointerAt<float>(source.color_, u_s, v_s);
     double dIdx = SOBEL_SCALE * (*PointerAt<float>(target_dx.color_, u_t, v_t));
@@ -81,14 +221,14 @@ void RGBDOdometryJacobianFromColorTerm::ComputeJacobianAndResidual(
     r[0] = diff;
 }
 
-void RGBDOdometryJacobianFromHybridTerm::ComputeJacobianAndResidual(
-        size_t row, std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+void ComputeHybridTermJacobianAndResidual(
+        const Eigen::Vector4i &corresp,
+        std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
         const RGBDImage &source, const RGBDImage &target,
         const Image &source_xyz,
         const RGBDImage &target_dx, const RGBDImage &target_dy,
         const Eigen::Matrix3d &intrinsic,
-        const Eigen::Matrix4d &extrinsic,
-        const CorrespondenceSetPixelWise &corresps) const
+        const Eigen::Matrix4d &extrinsic)
 {
     double sqrt_lamba_dep, sqrt_lambda_img;
     sqrt_lamba_dep = sqrt(LAMBDA_HYBRID_DEPTH);
@@ -99,10 +239,10 @@ void RGBDOdometryJacobianFromHybridTerm::ComputeJacobianAndResidual(
     Eigen::Matrix3d R = extrinsic.block<3, 3>(0, 0);
     Eigen::Vector3d t = extrinsic.block<3, 1>(0, 3);
 
-    int32_t u_s = corresps[row](0);
-    int32_t v_s = corresps[row](1);
-    int32_t u_t = corresps[row](2);
-    int32_t v_t = corresps[row](3);
+    int32_t u_s = corresp(0);
+    int32_t v_s = corresp(1);
+    int32_t u_t = corresp(2);
+    int32_t v_t = corresp(3);
     double diff_photo = (*PointerAt<float>(target.color_, u_t, v_t) -
             *PointerAt<float>(source.color_, u_s, v_s));
     double dIdx = SOBEL_SCALE *
@@ -155,4 +295,212 @@ void RGBDOdometryJacobianFromHybridTerm::ComputeJacobianAndResidual(
     r[1] = r_geo;
 }
 
+}   // unnamed namespace
+
+bool RGBDOdometryJacobian::AccumulateJTJandJTr(
+        const int32_t * /*source_indices*/,
+        const int32_t * /*target_indices*/, int32_t /*count*/,
+        const RGBDImage & /*source*/, const RGBDImage & /*target*/,
+        const Image & /*source_xyz*/,
+        const RGBDImage & /*target_dx*/, const RGBDImage & /*target_dy*/,
+        const Eigen::Matrix3d & /*intrinsic*/,
+        const Eigen::Matrix4d & /*extrinsic*/,
+        Eigen::Matrix6d & /*JTJ*/, Eigen::Vector6d & /*JTr*/,
+        double & /*r2_sum*/) const
+{
+    return false;
+}
+
+void RGBDOdometryJacobian::ComputePixelJacobianAndResidual(
+        const Eigen::Vector4i &corresp,
+        std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic) const
+{
+    CorrespondenceSetPixelWise corresps(1, corresp);
+    ComputeJacobianAndResidual(0, J_r, r, source, target, source_xyz,
+            target_dx, target_dy, intrinsic, extrinsic, corresps);
+}
+
+void RGBDOdometryJacobianFromColorTerm::ComputeJacobianAndResidual(
+        size_t row, std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        const CorrespondenceSetPixelWise &corresps) const
+{
+    ComputeColorTermJacobianAndResidual(corresps[row], J_r, r, source, target,
+            source_xyz, target_dx, target_dy, intrinsic, extrinsic);
+}
+
+void RGBDOdometryJacobianFromColorTerm::ComputePixelJacobianAndResidual(
+        const Eigen::Vector4i &corresp,
+        std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic) const
+{
+    // A subclass may override ComputeJacobianAndResidual() only, so the
+    // kernel is called directly for this exact class alone.
+    if (typeid(*this) != typeid(RGBDOdometryJacobianFromColorTerm)) {
+        RGBDOdometryJacobian::ComputePixelJacobianAndResidual(corresp, J_r, r,
+                source, target, source_xyz, target_dx, target_dy, intrinsic,
+                extrinsic);
+        return;
+    }
+    ComputeColorTermJacobianAndResidual(corresp, J_r, r, source, target,
+            source_xyz, target_dx, target_dy, intrinsic, extrinsic);
+}
+
+bool RGBDOdometryJacobianFromColorTerm::AccumulateJTJandJTr(
+        const int32_t *source_indices, const int32_t *target_indices,
+        int32_t count,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        Eigen::Matrix6d &JTJ, Eigen::Vector6d &JTr, double &r2_sum) const
+{
+    // A subclass may override the row functions, which the batch kernel
+    // would bypass.
+    if (typeid(*this) != typeid(RGBDOdometryJacobianFromColorTerm)) {
+        return false;
+    }
+    // same Jacobian as ComputePixelJacobianAndResidual(), for
+    // JACOBIAN_LANE_NUM correspondences at a time
+    const KernelImages images(source, target, source_xyz, target_dx,
+            target_dy);
+    const Eigen::Matrix3f R = extrinsic.block<3, 3>(0, 0).cast<float>();
+    const Eigen::Vector3f t = extrinsic.block<3, 1>(0, 3).cast<float>();
+    const float fx = static_cast<float>(intrinsic(0, 0));
+    const float fy = static_cast<float>(intrinsic(1, 1));
+    LaneJTJAccumulator accumulator;
+    CorrespondenceLane lane;
+    LaneArrayf J[6];
+    for (int32_t i = 0; i < count; i += JACOBIAN_LANE_NUM) {
+        GatherCorrespondenceLane(source_indices + i, target_indices + i,
+                std::min(JACOBIAN_LANE_NUM, count - i), images, R, t, false,
+                lane);
+        const LaneArrayf invz = lane.z_.inverse();
+        const LaneArrayf c0 = lane.dIdx_ * fx * invz;
+        const LaneArrayf c1 = lane.dIdy_ * fy * invz;
+        const LaneArrayf c2 = -(c0 * lane.x_ + c1 * lane.y_) * invz;
+        J[0] = -lane.z_ * c1 + lane.y_ * c2;
+        J[1] = lane.z_ * c0 - lane.x_ * c2;
+        J[2] = -lane.y_ * c0 + lane.x_ * c1;
+        J[3] = c0;
+        J[4] = c1;
+        J[5] = c2;
+        accumulator.Add(J, lane.diff_photo_);
+    }
+    accumulator.AddTo(JTJ, JTr, r2_sum);
+    return true;
+}
+
+void RGBDOdometryJacobianFromHybridTerm::ComputeJacobianAndResidual(
+        size_t row, std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        const CorrespondenceSetPixelWise &corresps) const
+{
+    ComputeHybridTermJacobianAndResidual(corresps[row], J_r, r, source, target,
+            source_xyz, target_dx, target_dy, intrinsic, extrinsic);
+}
+
+void RGBDOdometryJacobianFromHybridTerm::ComputePixelJacobianAndResidual(
+        const Eigen::Vector4i &corresp,
+        std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic) const
+{
+    // A subclass may override ComputeJacobianAndResidual() only, so the
+    // kernel is called directly for this exact class alone.
+    if (typeid(*this) != typeid(RGBDOdometryJacobianFromHybridTerm)) {
+        RGBDOdometryJacobian::ComputePixelJacobianAndResidual(corresp, J_r, r,
+                source, target, source_xyz, target_dx, target_dy, intrinsic,
+                extrinsic);
+        return;
+    }
+    ComputeHybridTermJacobianAndResidual(corresp, J_r, r, source, target,
+            source_xyz, target_dx, target_dy, intrinsic, extrinsic);
+}
+
+bool RGBDOdometryJacobianFromHybridTerm::AccumulateJTJandJTr(
+        const int32_t *source_indices, const int32_t *target_indices,
+        int32_t count,
+        const RGBDImage &source, const RGBDImage &target,
+        const Image &source_xyz,
+        const RGBDImage &target_dx, const RGBDImage &target_dy,
+        const Eigen::Matrix3d &intrinsic,
+        const Eigen::Matrix4d &extrinsic,
+        Eigen::Matrix6d &JTJ, Eigen::Vector6d &JTr, double &r2_sum) const
+{
+    // A subclass may override the row functions, which the batch kernel
+    // would bypass.
+    if (typeid(*this) != typeid(RGBDOdometryJacobianFromHybridTerm)) {
+        return false;
+    }
+    // same Jacobian as ComputePixelJacobianAndResidual(), for
+    // JACOBIAN_LANE_NUM correspondences at a time
+    const float sqrt_lamba_dep = static_cast<float>(sqrt(LAMBDA_HYBRID_DEPTH));
+    const float sqrt_lambda_img = static_cast<float>(
+            sqrt(1.0 - LAMBDA_HYBRID_DEPTH));
+    const KernelImages images(source, target, source_xyz, target_dx,
+            target_dy);
+    const Eigen::Matrix3f R = extrinsic.block<3, 3>(0, 0).cast<float>();
+    const Eigen::Vector3f t = extrinsic.block<3, 1>(0, 3).cast<float>();
+    const float fx = static_cast<float>(intrinsic(0, 0));
+    const float fy = static_cast<float>(intrinsic(1, 1));
+    LaneJTJAccumulator accumulator;
+    CorrespondenceLane lane;
+    LaneArrayf J[6];
+    for (int32_t i = 0; i < count; i += JACOBIAN_LANE_NUM) {
+        GatherCorrespondenceLane(source_indices + i, target_indices + i,
+                std::min(JACOBIAN_LANE_NUM, count - i), images, R, t, true,
+                lane);
+        const LaneArrayf invz = lane.z_.inverse();
+        const LaneArrayf c0 = lane.dIdx_ * fx * invz;
+        const LaneArrayf c1 = lane.dIdy_ * fy * invz;
+        const LaneArrayf c2 = -(c0 * lane.x_ + c1 * lane.y_) * invz;
+        J[0] = sqrt_lambda_img * (-lane.z_ * c1 + lane.y_ * c2);
+        J[1] = sqrt_lambda_img * (lane.z_ * c0 - lane.x_ * c2);
+        J[2] = sqrt_lambda_img * (-lane.y_ * c0 + lane.x_ * c1);
+        J[3] = sqrt_lambda_img * c0;
+        J[4] = sqrt_lambda_img * c1;
+        J[5] = sqrt_lambda_img * c2;
+        accumulator.Add(J, sqrt_lambda_img * lane.diff_photo_);
+
+        // the constant terms of the depth row are masked for padding lanes
+        const LaneArrayf d0 = lane.dDdx_ * fx * invz;
+        const LaneArrayf d1 = lane.dDdy_ * fy * invz;
+        const LaneArrayf d2 = -(d0 * lane.x_ + d1 * lane.y_) * invz;
+        J[0] = sqrt_lamba_dep *
+                ((-lane.z_ * d1 + lane.y_ * d2) - lane.y_);
+        J[1] = sqrt_lamba_dep *
+                ((lane.z_ * d0 - lane.x_ * d2) + lane.x_);
+        J[2] = sqrt_lamba_dep * (-lane.y_ * d0 + lane.x_ * d1);
+        J[3] = sqrt_lamba_dep * d0;
+        J[4] = sqrt_lamba_dep * d1;
+        J[5] = sqrt_lamba_dep * (d2 - 1.0f) * lane.valid_;
+        accumulator.Add(J, sqrt_lamba_dep * (lane.depth_t_ - lane.z_) *
+                lane.valid_);
+    }
+    accumulator.AddTo(JTJ, JTr, r2_sum);
+    return true;
+}
+
 }   // namespace open3d
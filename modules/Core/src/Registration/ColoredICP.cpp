@@ -40,15 +40,12 @@ namespace open3d {
 
 namespace {
 
-class PointCloudForColoredICP : public PointCloud {
-public:
-    std::vector<Eigen::Vector3d> color_gradient_;
-};
-
 class TransformationEstimationForColoredICP : public TransformationEstimation {
 public:
     TransformationEstimationForColoredICP(
+            const std::vector<Eigen::Vector3d> &target_color_gradients,
             double lambda_geometric = 0.968) :
+            target_color_gradients_(target_color_gradients),
             lambda_geometric_(lambda_geometric) {
         if (lambda_geometric_ < 0 || lambda_geometric_ > 1.0)
             lambda_geometric_ = 0.968;
@@ -61,76 +58,19 @@ public:
     Eigen::Matrix4d ComputeTransformation(
             const PointCloud &source, const PointCloud &target,
             const CorrespondenceSet &corres) const override;
+    size_t GetFusedStatisticsSize() const override { return 42; }
+    void AccumulateFusedStatistics(const PointCloud &source,
+            int32_t source_index, const Eigen::Vector3d &source_point,
+            const PointCloud &target, int32_t target_index,
+            Eigen::VectorXd &statistics) const override;
+    Eigen::Matrix4d ComputeTransformationFromFusedStatistics(
+            const Eigen::VectorXd &statistics) const override;
 
 public:
+    const std::vector<Eigen::Vector3d> &target_color_gradients_;
     double lambda_geometric_;
 };
 
-std::shared_ptr<PointCloudForColoredICP>
-        InitializePointCloudForColoredICP(const PointCloud &target,
-        const KDTreeSearchParamHybrid &search_param)
-{
-    PrintDebug("InitializePointCloudForColoredICP");
-
-    KDTreeFlann tree;
-    tree.SetGeometry(target);
-
-    auto output = std::make_shared<PointCloudForColoredICP>();
-    output->colors_ = target.colors_;
-    output->normals_ = target.normals_;
-    output->points_ = target.points_;
-
-    size_t n_points = output->points_.size();
-    output->color_gradient_.resize(n_points, Eigen::Vector3d::Zero());
-
-    for (size_t k = 0; k < n_points; k++) {
-        const Eigen::Vector3d &vt = output->points_[k];
-        const Eigen::Vector3d &nt = output->normals_[k];
-        double it = (output->colors_[k](0) + output->colors_[k](1)
-                + output->colors_[k](2)) / 3.0;
-
-        std::vector<int32_t> point_idx;
-        std::vector<double> point_squared_distance;
-
-        if (tree.SearchHybrid(vt, search_param.radius_,
-                search_param.max_nn_, point_idx, point_squared_distance) >= 3) {
-            // approximate image gradient of vt's tangential plane
-            size_t nn = point_idx.size();
-            Eigen::MatrixXd A(nn, 3);
-            Eigen::MatrixXd b(nn, 1);
-            A.setZero();
-            b.setZero();
-            for (size_t i = 1; i < nn; i++) {
-                int32_t P_adj_idx = point_idx[i];
-                Eigen::Vector3d vt_adj = output->points_[P_adj_idx];
-                Eigen::Vector3d vt_proj =
-                        vt_adj - (vt_adj - vt).dot(nt) * nt;
-                double it_adj = (output->colors_[P_adj_idx](0)
-                        + output->colors_[P_adj_idx](1)
-                        + output->colors_[P_adj_idx](2)) / 3.0;
-                A(i - 1, 0) = (vt_proj(0) - vt(0));
-                A(i - 1, 1) = (vt_proj(1) - vt(1));
-                A(i - 1, 2) = (vt_proj(2) - vt(2));
-                b(i - 1, 0) = (it_adj - it);
-            }
-            // adds orthogonal constraint
-            A(nn - 1, 0) = (nn - 1) * nt(0);
-            A(nn - 1, 1) = (nn - 1) * nt(1);
-            A(nn - 1, 2) = (nn - 1) * nt(2);
-            b(nn - 1, 0) = 0;
-            // solving linear equation
-            bool is_success;
-            Eigen::MatrixXd x;
-            std::tie(is_success, x) = SolveLinearSystem(
-                A.transpose() * A, A.transpose() * b);
-            if (is_success) {
-                output->color_gradient_[k] = x;
-            }
-        }
-    }
-    return output;
-}
-
 Eigen::Matrix4d TransformationEstimationForColoredICP::ComputeTransformation(
         const PointCloud &source,
         const PointCloud &target,
@@ -144,8 +84,6 @@ Eigen::Matrix4d TransformationEstimationForColoredICP::ComputeTransformation(
     double lambda_photometric = 1.0 - lambda_geometric_;
     double sqrt_lambda_photometric = sqrt(lambda_photometric);
 
-    const auto &target_c = (const PointCloudForColoredICP &)target;
-
     auto compute_jacobian_and_residual = [&]
             (size_t i, std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r)
     {
@@ -168,7 +106,7 @@ Eigen::Matrix4d TransformationEstimationForColoredICP::ComputeTransformation(
                 + source.colors_[cs](2)) / 3.0;
         double it = (target.colors_[ct](0) + target.colors_[ct](1)
                 + target.colors_[ct](2)) / 3.0;
-        const Eigen::Vector3d &dit = target_c.color_gradient_[ct];
+        const Eigen::Vector3d &dit = target_color_gradients_[ct];
         double is0_proj = (dit.dot(vs_proj - vt)) + it;
 
         const Eigen::Matrix3d M = (Eigen::Matrix3d() <<
@@ -195,6 +133,69 @@ Eigen::Matrix4d TransformationEstimationForColoredICP::ComputeTransformation(
     return is_success ? extrinsic : Eigen::Matrix4d::Identity();
 }
 
+// Statistics are JTJ (column major) and JTr, with the same rows as
+// ComputeTransformation().
+void TransformationEstimationForColoredICP::AccumulateFusedStatistics(
+        const PointCloud &source, int32_t source_index,
+        const Eigen::Vector3d &source_point, const PointCloud &target,
+        int32_t target_index, Eigen::VectorXd &statistics) const
+{
+    if (target.HasNormals() == false || target.HasColors() == false ||
+            source.HasColors() == false)
+        return;
+
+    double sqrt_lambda_geometric = sqrt(lambda_geometric_);
+    double sqrt_lambda_photometric = sqrt(1.0 - lambda_geometric_);
+    const Eigen::Vector3d &vs = source_point;
+    const Eigen::Vector3d &vt = target.points_[target_index];
+    const Eigen::Vector3d &nt = target.normals_[target_index];
+    Eigen::Map<Eigen::Matrix6d> JTJ(statistics.data());
+    Eigen::Map<Eigen::Vector6d> JTr(statistics.data() + 36);
+    Eigen::Vector6d J_r;
+    double r;
+
+    J_r.block<3, 1>(0, 0) = sqrt_lambda_geometric * vs.cross(nt);
+    J_r.block<3, 1>(3, 0) = sqrt_lambda_geometric * nt;
+    r = sqrt_lambda_geometric * (vs - vt).dot(nt);
+    JTJ.noalias() += J_r * J_r.transpose();
+    JTr.noalias() += J_r * r;
+
+    Eigen::Vector3d vs_proj = vs - (vs - vt).dot(nt) * nt;
+    double is = (source.colors_[source_index](0) +
+            source.colors_[source_index](1) +
+            source.colors_[source_index](2)) / 3.0;
+    double it = (target.colors_[target_index](0) +
+            target.colors_[target_index](1) +
+            target.colors_[target_index](2)) / 3.0;
+    const Eigen::Vector3d &dit = target_color_gradients_[target_index];
+    double is0_proj = (dit.dot(vs_proj - vt)) + it;
+
+    const Eigen::Matrix3d M = (Eigen::Matrix3d() <<
+            1.0 - nt(0) * nt(0), -nt(0) * nt(1), -nt(0) * nt(2),
+            -nt(0) * nt(1), 1.0 - nt(1) * nt(1), -nt(1) * nt(2),
+            -nt(0) * nt(2), -nt(1) * nt(2), 1.0 - nt(2) * nt(2)).finished();
+
+    const Eigen::Vector3d &ditM = -dit.transpose() * M;
+    J_r.block<3, 1>(0, 0) = sqrt_lambda_photometric * vs.cross(ditM);
+    J_r.block<3, 1>(3, 0) = sqrt_lambda_photometric * ditM;
+    r = sqrt_lambda_photometric * (is - is0_proj);
+    JTJ.noalias() += J_r * J_r.transpose();
+    JTr.noalias() += J_r * r;
+}
+
+Eigen::Matrix4d
+        TransformationEstimationForColoredICP::ComputeTransformationFromFusedStatistics(
+        const Eigen::VectorXd &statistics) const
+{
+    bool is_success;
+    Eigen::Matrix4d extrinsic;
+    std::tie(is_success, extrinsic) =
+            SolveJacobianSystemAndObtainExtrinsicMatrix(
+            Eigen::Map<const Eigen::Matrix6d>(statistics.data()),
+            statistics.segment<6>(36));
+    return is_success ? extrinsic : Eigen::Matrix4d::Identity();
+}
+
 double TransformationEstimationForColoredICP::ComputeRMSE(
         const PointCloud &source, const PointCloud &target,
         const CorrespondenceSet &corres) const {
@@ -202,8 +203,6 @@ double TransformationEstimationForColoredICP::ComputeRMSE(
     double sqrt_lambda_geometric = sqrt(lambda_geometric_);
     double lambda_photometric = 1.0 - lambda_geometric_;
     double sqrt_lambda_photometric = sqrt(lambda_photometric);
-    const auto &target_c = (const PointCloudForColoredICP &)target;
-
     double residual = 0.0;
     for (size_t i = 0; i < corres.size(); i++) {
         uint32_t cs = corres[i][0];
@@ -216,7 +215,7 @@ double TransformationEstimationForColoredICP::ComputeRMSE(
                 + source.colors_[cs](2)) / 3.0;
         double it = (target.colors_[ct](0) + target.colors_[ct](1)
                 + target.colors_[ct](2)) / 3.0;
-        const Eigen::Vector3d &dit = target_c.color_gradient_[ct];
+        const Eigen::Vector3d &dit = target_color_gradients_[ct];
         double is0_proj = (dit.dot(vs_proj - vt)) + it;
         double residual_geometric = sqrt_lambda_geometric * (vs - vt).dot(nt);
         double residual_photometric = sqrt_lambda_photometric * (is - is0_proj);
@@ -234,10 +233,26 @@ RegistrationResult RegistrationColoredICP(const PointCloud &source,
         const ICPConvergenceCriteria &criteria/* = ICPConvergenceCriteria()*/,
         double lambda_geometric/* = 0.968*/)
 {
-    auto target_c = InitializePointCloudForColoredICP(
-            target, KDTreeSearchParamHybrid(max_distance * 2.0, 30));
-    return RegistrationICP(source, *target_c, max_distance, init,
-            TransformationEstimationForColoredICP(lambda_geometric), criteria);
+    RegistrationTarget target_prepared(target);
+    target_prepared.PrepareColorGradients(
+            KDTreeSearchParamHybrid(max_distance * 2.0, 30));
+    return RegistrationColoredICP(source, target_prepared, max_distance, init,
+            criteria, lambda_geometric);
+}
+
+RegistrationResult RegistrationColoredICP(const PointCloud &source,
+        const RegistrationTarget &target, double max_distance,
+        const Eigen::Matrix4d &init/* = Eigen::Matrix4d::Identity()*/,
+        const ICPConvergenceCriteria &criteria/* = ICPConvergenceCriteria()*/,
+        double lambda_geometric/* = 0.968*/)
+{
+    if (target.HasColorGradients() == false) {
+        PrintWarning("[RegistrationColoredICP] Target has no color gradients.\n");
+        return RegistrationResult(init);
+    }
+    return RegistrationICP(source, target, max_distance, init,
+            TransformationEstimationForColoredICP(target.color_gradients_,
+            lambda_geometric), criteria);
 }
 
 }   // namespace open3d
@@ -28,26 +28,58 @@
 #include <Open3D/Core/Registration/FastGlobalRegistration.h>
 
 #include <ctime>
+#include <random>
 
 #include <Open3D/Core/Geometry/PointCloud.h>
 #include <Open3D/Core/Geometry/KDTreeFlann.h>
 #include <Open3D/Core/Registration/Registration.h>
 #include <Open3D/Core/Registration/Feature.h>
 #include <Open3D/Core/Utility/Console.h>
+#include <Open3D/Core/Utility/Eigen.h>
 
 namespace open3d {
 
 namespace {
 
-std::vector<Eigen::Vector3d> Means;
-double GlobalScale;
-double StartScale;
-std::vector<std::shared_ptr<PointCloud>> pointcloud_;
-std::vector<std::shared_ptr<Feature>> features_;
-std::vector<std::pair<size_t, size_t>> corres_;
-Eigen::Matrix4d TransOutput_;
-
-void AdvancedMatching(const FastGlobalRegistrationOption& option)
+/// Class that holds the whole state of one fast global registration.
+/// Every call of FastGlobalRegistration() owns its context, so that
+/// registrations can run concurrently in different threads.
+class FastGlobalRegistrationContext
+{
+public:
+    FastGlobalRegistrationContext(const PointCloud &source,
+            const PointCloud &target, const Feature &source_feature,
+            const Feature &target_feature,
+            const FastGlobalRegistrationOption &option) :
+            option_(option), global_scale_(1.0), start_scale_(1.0),
+            trans_output_(Eigen::Matrix4d::Identity()),
+            random_engine_(static_cast<unsigned long>(std::time(0))) {
+        points_[0] = source.points_;
+        points_[1] = target.points_;
+        features_[0] = &source_feature;
+        features_[1] = &target_feature;
+    }
+    ~FastGlobalRegistrationContext() {}
+
+public:
+    void NormalizePoints();
+    void AdvancedMatching();
+    double OptimizePairwise();
+    Eigen::Matrix4d GetTrans() const;
+
+private:
+    const FastGlobalRegistrationOption &option_;
+    std::vector<Eigen::Vector3d> points_[2];
+    const Feature *features_[2];
+    Eigen::Vector3d means_[2];
+    double global_scale_;
+    double start_scale_;
+    std::vector<std::pair<size_t, size_t>> corres_;
+    Eigen::Matrix4d trans_output_;
+    std::mt19937 random_engine_;
+};
+
+void FastGlobalRegistrationContext::AdvancedMatching()
 {
     int32_t fi = 0;
     int32_t fj = 1;
@@ -55,7 +87,7 @@ void AdvancedMatching(const FastGlobalRegistrationOption& option)
     PrintDebug("Advanced matching : [%d - %d]\n", fi, fj);
     bool swapped = false;
 
-    if (pointcloud_[fj]->points_.size() > pointcloud_[fi]->points_.size())
+    if (points_[fj].size() > points_[fi].size())
     {
         int32_t temp = fi;
         fi = fj;
@@ -63,8 +95,8 @@ void AdvancedMatching(const FastGlobalRegistrationOption& option)
         swapped = true;
     }
 
-    size_t nPti = pointcloud_[fi]->points_.size();
-    size_t nPtj = pointcloud_[fj]->points_.size();
+    size_t nPti = points_[fi].size();
+    size_t nPtj = points_[fj].size();
 
     ///////////////////////////
     /// BUILD FLANNTREE
@@ -178,26 +210,25 @@ void AdvancedMatching(const FastGlobalRegistrationOption& option)
     /// input : corres
     /// output : corres
     ///////////////////////////
-    if (tuple)
+    if (tuple && !corres.empty())
     {
-        std::srand(static_cast<unsigned long>(std::time(0)));
-
         PrintDebug("\t[tuple constraint] ");
         int32_t rand0, rand1, rand2;
         size_t idi0, idi1, idi2;
         size_t idj0, idj1, idj2;
-        double scale = option.tuple_scale_;
+        double scale = option_.tuple_scale_;
         size_t ncorr = corres.size();
         size_t number_of_trial = ncorr * 100;
         std::vector<std::pair<size_t, size_t>> corres_tuple;
+        std::uniform_int_distribution<size_t> rand_corres(0, ncorr - 1);
 
         size_t cnt = 0;
         size_t i;
         for (i = 0; i < number_of_trial; i++)
         {
-            rand0 = rand() % ncorr;
-            rand1 = rand() % ncorr;
-            rand2 = rand() % ncorr;
+            rand0 = rand_corres(random_engine_);
+            rand1 = rand_corres(random_engine_);
+            rand2 = rand_corres(random_engine_);
 
             idi0 = corres[rand0].first;
             idj0 = corres[rand0].second;
@@ -207,18 +238,18 @@ void AdvancedMatching(const FastGlobalRegistrationOption& option)
             idj2 = corres[rand2].second;
 
             // collect 3 points from i-th fragment
-            Eigen::Vector3d pti0 = pointcloud_[fi]->points_[idi0];
-            Eigen::Vector3d pti1 = pointcloud_[fi]->points_[idi1];
-            Eigen::Vector3d pti2 = pointcloud_[fi]->points_[idi2];
+            Eigen::Vector3d pti0 = points_[fi][idi0];
+            Eigen::Vector3d pti1 = points_[fi][idi1];
+            Eigen::Vector3d pti2 = points_[fi][idi2];
 
             double li0 = (pti0 - pti1).norm();
             double li1 = (pti1 - pti2).norm();
             double li2 = (pti2 - pti0).norm();
 
             // collect 3 points from j-th fragment
-            Eigen::Vector3d ptj0 = pointcloud_[fj]->points_[idj0];
-            Eigen::Vector3d ptj1 = pointcloud_[fj]->points_[idj1];
-            Eigen::Vector3d ptj2 = pointcloud_[fj]->points_[idj2];
+            Eigen::Vector3d ptj0 = points_[fj][idj0];
+            Eigen::Vector3d ptj1 = points_[fj][idj1];
+            Eigen::Vector3d ptj2 = points_[fj][idj2];
 
             double lj0 = (ptj0 - ptj1).norm();
             double lj1 = (ptj1 - ptj2).norm();
@@ -234,7 +265,7 @@ void AdvancedMatching(const FastGlobalRegistrationOption& option)
                 cnt++;
             }
 
-            if (cnt >= option.maximum_tuple_count_)
+            if (cnt >= option_.maximum_tuple_count_)
                 break;
         }
 
@@ -261,13 +292,11 @@ void AdvancedMatching(const FastGlobalRegistrationOption& option)
 
 // Normalize scale of points.
 // X' = (X-\mu)/scale
-void NormalizePoints(const FastGlobalRegistrationOption& option)
+void FastGlobalRegistrationContext::NormalizePoints()
 {
     uint8_t num = 2;
     double scale = 0;
 
-    Means.clear();
-
     for (uint8_t i = 0; i < num; ++i)
     {
         double max_scale = 0.0;
@@ -276,25 +305,25 @@ void NormalizePoints(const FastGlobalRegistrationOption& option)
         Eigen::Vector3d mean;
         mean.setZero();
 
-        size_t npti = pointcloud_[i]->points_.size();
+        size_t npti = points_[i].size();
         for (size_t ii = 0; ii < npti; ++ii)
         {
-            mean = mean + pointcloud_[i]->points_[ii];
+            mean = mean + points_[i][ii];
         }
         mean = mean / npti;
-        Means.push_back(mean);
+        means_[i] = mean;
 
         PrintDebug("normalize points :: mean = [%f %f %f]\n", mean(0), mean(1), mean(2));
 
         for (size_t ii = 0; ii < npti; ++ii)
         {
-            pointcloud_[i]->points_[ii] -= mean;
+            points_[i][ii] -= mean;
         }
 
         // compute scale
         for (size_t ii = 0; ii < npti; ++ii)
         {
-            Eigen::Vector3d p(pointcloud_[i]->points_[ii]);
+            Eigen::Vector3d p(points_[i][ii]);
             double temp = p.norm(); // because we extract mean in the previous stage.
             if (temp > max_scale)
                 max_scale = temp;
@@ -305,44 +334,41 @@ void NormalizePoints(const FastGlobalRegistrationOption& option)
     }
 
     // mean of the scale variation
-    if (option.use_absolute_scale_) {
-        GlobalScale = 1.0f;
-        StartScale = scale;
+    if (option_.use_absolute_scale_) {
+        global_scale_ = 1.0f;
+        start_scale_ = scale;
     } else {
-        GlobalScale = scale; // second choice: we keep the maximum scale.
-        StartScale = 1.0f;
+        global_scale_ = scale; // second choice: we keep the maximum scale.
+        start_scale_ = 1.0f;
     }
-    PrintDebug("normalize points :: global scale : %f\n", GlobalScale);
+    PrintDebug("normalize points :: global scale : %f\n", global_scale_);
 
     for (uint8_t i = 0; i < num; ++i)
     {
-        size_t npti = pointcloud_[i]->points_.size();
+        size_t npti = points_[i].size();
         for (size_t ii = 0; ii < npti; ++ii)
         {
-            pointcloud_[i]->points_[ii] /= GlobalScale;
+            points_[i][ii] /= global_scale_;
         }
     }
 }
 
-double OptimizePairwise(const FastGlobalRegistrationOption& option)
+double FastGlobalRegistrationContext::OptimizePairwise()
 {
     PrintDebug("Pairwise rigid pose optimization\n");
 
     double par;
-    size_t numIter = option.iteration_number_;
-    TransOutput_ = Eigen::Matrix4d::Identity();
+    size_t numIter = option_.iteration_number_;
+    trans_output_ = Eigen::Matrix4d::Identity();
 
-    par = StartScale;
+    par = start_scale_;
 
     int32_t i = 0;
     int32_t j = 1;
 
-    // make another copy of pointcloud_[j].
-    std::vector<Eigen::Vector3d> pcj_copy;
-    size_t npcj = pointcloud_[j]->points_.size();
-    pcj_copy.resize(npcj);
-    for (size_t cnt = 0; cnt < npcj; cnt++)
-        pcj_copy[cnt] = pointcloud_[j]->points_[cnt];
+    // make another copy of points_[j].
+    std::vector<Eigen::Vector3d> pcj_copy = points_[j];
+    int32_t npcj = static_cast<int32_t>(pcj_copy.size());
 
     if (corres_.size() < 10)
         return -1;
@@ -355,106 +381,75 @@ double OptimizePairwise(const FastGlobalRegistrationOption& option)
     for (size_t itr = 0; itr < numIter; itr++) {
 
         // graduated non-convexity.
-        if (option.decrease_mu_)
+        if (option_.decrease_mu_)
         {
-            if (itr % 4 == 0 && par > option.maximum_correspondence_distance_) {
-                par /= option.division_factor_;
+            if (itr % 4 == 0 && par > option_.maximum_correspondence_distance_) {
+                par /= option_.division_factor_;
             }
         }
 
-        const int32_t nvariable = 6;    // 3 for rotation and 3 for translation
-        Eigen::MatrixXd JTJ(nvariable, nvariable);
-        Eigen::MatrixXd JTr(nvariable, 1);
-        Eigen::MatrixXd J(nvariable, 1);
-        JTJ.setZero();
-        JTr.setZero();
-
-        double r;
-        double r2 = 0.0;
-
-        for (size_t c = 0; c < corres_.size(); c++) {
-            size_t ii = corres_[c].first;
-            size_t jj = corres_[c].second;
-            Eigen::Vector3d p, q;
-            p = pointcloud_[i]->points_[ii];
-            q = pcj_copy[jj];
+        // Each correspondence contributes three rows (x, y, z) weighted by
+        // the line process s. Weights are folded into the rows as sqrt(s).
+        auto compute_jacobian_and_residual = [&](size_t c,
+                std::vector<Eigen::Vector6d> &J_r, std::vector<double> &r) {
+            J_r.resize(3);
+            r.resize(3);
+            const Eigen::Vector3d &p = points_[i][corres_[c].first];
+            const Eigen::Vector3d &q = pcj_copy[corres_[c].second];
             Eigen::Vector3d rpq = p - q;
-
-            size_t c2 = c;
-
             double temp = par / (rpq.dot(rpq) + par);
-            s[c2] = temp * temp;
-
-            J.setZero();
-            J(1) = -q(2);
-            J(2) = q(1);
-            J(3) = -1;
-            r = rpq(0);
-            JTJ += J * J.transpose() * s[c2];
-            JTr += J * r * s[c2];
-            r2 += r * r * s[c2];
-
-            J.setZero();
-            J(2) = -q(0);
-            J(0) = q(2);
-            J(4) = -1;
-            r = rpq(1);
-            JTJ += J * J.transpose() * s[c2];
-            JTr += J * r * s[c2];
-            r2 += r * r * s[c2];
-
-            J.setZero();
-            J(0) = -q(1);
-            J(1) = q(0);
-            J(5) = -1;
-            r = rpq(2);
-            JTJ += J * J.transpose() * s[c2];
-            JTr += J * r * s[c2];
-            r2 += r * r * s[c2];
-
-            r2 += (par * (1.0 - sqrt(s[c2])) * (1.0 - sqrt(s[c2])));
-        }
-
-        Eigen::MatrixXd result(nvariable, 1);
-        result = -JTJ.llt().solve(JTr);
+            s[c] = temp * temp;
+            double w = temp;    // sqrt(s[c])
+
+            J_r[0] << 0.0, -q(2), q(1), -1.0, 0.0, 0.0;
+            J_r[1] << q(2), 0.0, -q(0), 0.0, -1.0, 0.0;
+            J_r[2] << -q(1), q(0), 0.0, 0.0, 0.0, -1.0;
+            for (int32_t k = 0; k < 3; k++) {
+                J_r[k] *= w;
+                r[k] = rpq(k) * w;
+            }
+        };
 
-        Eigen::Affine3d aff_mat;
-        aff_mat.linear() = (Eigen::Matrix3d) Eigen::AngleAxisd(result(2), Eigen::Vector3d::UnitZ())
-            * Eigen::AngleAxisd(result(1), Eigen::Vector3d::UnitY())
-            * Eigen::AngleAxisd(result(0), Eigen::Vector3d::UnitX());
-        aff_mat.translation() = Eigen::Vector3d(result(3), result(4), result(5));
+        Eigen::Matrix6d JTJ;
+        Eigen::Vector6d JTr;
+        std::tie(JTJ, JTr) = ComputeJTJandJTr<Eigen::Matrix6d, Eigen::Vector6d>(
+                compute_jacobian_and_residual, corres_.size());
 
-        Eigen::Matrix4d delta = aff_mat.matrix().cast<double>();
+        Eigen::Vector6d result = -JTJ.llt().solve(JTr);
+        Eigen::Matrix4d delta = TransformVector6dToMatrix4d(result);
 
         trans = delta * trans;
 
         // transform point clouds
         Eigen::Matrix3d R = delta.block<3, 3>(0, 0);
         Eigen::Vector3d t = delta.block<3, 1>(0, 3);
-        for (size_t cnt = 0; cnt < npcj; cnt++)
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int32_t cnt = 0; cnt < npcj; cnt++)
             pcj_copy[cnt] = R * pcj_copy[cnt] + t;
 
     }
 
-    TransOutput_ = trans * TransOutput_;
+    trans_output_ = trans * trans_output_;
     return par;
 }
 
 // Below line indicates how the transformation matrix aligns two point clouds
-// e.g. T * pointcloud_[1] is aligned with pointcloud_[0].
+// e.g. T * points_[1] is aligned with points_[0].
 // '2' indicates that there are two point cloud fragments.
-Eigen::Matrix4d GetTrans()
+Eigen::Matrix4d FastGlobalRegistrationContext::GetTrans() const
 {
     Eigen::Matrix3d R;
     Eigen::Vector3d t;
-    R = TransOutput_.block<3, 3>(0, 0);
-    t = TransOutput_.block<3, 1>(0, 3);
+    R = trans_output_.block<3, 3>(0, 0);
+    t = trans_output_.block<3, 1>(0, 3);
 
     Eigen::Matrix4d transtemp;
     transtemp.fill(0.0f);
 
     transtemp.block<3, 3>(0, 0) = R;
-    transtemp.block<3, 1>(0, 3) = -R*Means[1] + t*GlobalScale + Means[0];
+    transtemp.block<3, 1>(0, 3) = -R*means_[1] + t*global_scale_ + means_[0];
     transtemp(3, 3) = 1;
 
     return transtemp;
@@ -469,27 +464,15 @@ RegistrationResult FastGlobalRegistration(
         const FastGlobalRegistrationOption &option/* =
         FastGlobalRegistrationOption()*/)
 {
-    std::shared_ptr<PointCloud> source_copy = std::make_shared<PointCloud>();
-    std::shared_ptr<PointCloud> target_copy = std::make_shared<PointCloud>();
-    *source_copy = source;
-    *target_copy = target;
-    pointcloud_.push_back(source_copy);
-    pointcloud_.push_back(target_copy);
-
-    std::shared_ptr<Feature> source_feature_copy = std::make_shared<Feature>();
-    std::shared_ptr<Feature> target_feature_copy = std::make_shared<Feature>();
-    *source_feature_copy = source_feature;
-    *target_feature_copy = target_feature;
-    features_.push_back(source_feature_copy);
-    features_.push_back(target_feature_copy);
-
-    NormalizePoints(option);
-    AdvancedMatching(option);
-    OptimizePairwise(option);
-
-    // as the original code T * pointcloud_[1] is aligned with pointcloud_[0].
+    FastGlobalRegistrationContext context(source, target, source_feature,
+            target_feature, option);
+    context.NormalizePoints();
+    context.AdvancedMatching();
+    context.OptimizePairwise();
+
+    // as the original code T * points_[1] is aligned with points_[0].
     // matrix inverse is applied here.
-    return RegistrationResult(GetTrans().inverse());
+    return RegistrationResult(context.GetTrans().inverse());
 }
 
 }  // namespace open3d
@@ -29,7 +29,15 @@
 
 #include <vector>
 #include <tuple>
+#include <map>
+#include <unordered_map>
+#include <array>
+#include <algorithm>
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <Eigen/OrderingMethods>
+#include <Eigen/StdVector>
 #include <Open3D/Core/Utility/Console.h>
 #include <Open3D/Core/Utility/Timer.h>
 #include <Open3D/Core/Registration/PoseGraph.h>
@@ -78,43 +86,41 @@ inline Eigen::Vector6d GetLinearized6DVector(const Eigen::Matrix4d &input)
     return std::move(output);
 }
 
-inline Eigen::Vector6d GetMisalignmentVector(const Eigen::Matrix4d &X_inv,
-        const Eigen::Matrix4d &Ts, const Eigen::Matrix4d &Tt_inv)
-{
-    Eigen::Matrix4d temp;
-    temp.noalias() = X_inv * Tt_inv * Ts;
-    return GetLinearized6DVector(temp);
-}
+typedef std::vector<Eigen::Matrix4d,
+        Eigen::aligned_allocator<Eigen::Matrix4d>> Matrix4dVector;
+typedef std::vector<Eigen::Matrix6d,
+        Eigen::aligned_allocator<Eigen::Matrix6d>> Matrix6dVector;
+typedef std::vector<Eigen::Vector6d,
+        Eigen::aligned_allocator<Eigen::Vector6d>> Vector6dVector;
 
-inline std::tuple<Eigen::Matrix4d, Eigen::Matrix4d, Eigen::Matrix4d>
-        GetRelativePoses(const PoseGraph &pose_graph, size_t edge_id)
+/// Function to compute X_inv of every edge. Edge transformations do not
+/// change during optimization, so this is done once.
+Matrix4dVector ComputeEdgeInverses(const PoseGraph &pose_graph)
 {
-    const PoseGraphEdge &te = pose_graph.edges_[edge_id];
-    const PoseGraphNode &ts = pose_graph.nodes_[te.source_node_id_];
-    const PoseGraphNode &tt = pose_graph.nodes_[te.target_node_id_];
-    Eigen::Matrix4d X_inv = te.transformation_.inverse();
-    Eigen::Matrix4d Ts = ts.pose_;
-    Eigen::Matrix4d Tt_inv = tt.pose_.inverse();
-    return std::make_tuple(std::move(X_inv), std::move(Ts), std::move(Tt_inv));
+    size_t n_edges = pose_graph.edges_.size();
+    Matrix4dVector edge_inverses(n_edges);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t iter_edge = 0; iter_edge < (int32_t)n_edges; iter_edge++) {
+        edge_inverses[iter_edge] =
+                pose_graph.edges_[iter_edge].transformation_.inverse();
+    }
+    return edge_inverses;
 }
 
-std::tuple<Eigen::Matrix6d, Eigen::Matrix6d> GetJacobian(
-        const Eigen::Matrix4d &X_inv, const Eigen::Matrix4d &Ts,
-        const Eigen::Matrix4d &Tt_inv)
+/// Jacobian of the misalignment vector w.r.t. the source pose. Since the
+/// operators only flip sign for the target pose, Jt is exactly -Js.
+/// relative_pose is X_inv * Tt_inv.
+Eigen::Matrix6d GetJacobian(const Eigen::Matrix4d &relative_pose,
+        const Eigen::Matrix4d &Ts)
 {
-    Eigen::Matrix6d Js = Eigen::Matrix6d::Zero();
+    Eigen::Matrix6d Js;
     for (int32_t i = 0; i < 6; i++) {
-        Eigen::Matrix4d temp = X_inv * Tt_inv *
-                jacobian_operator[i] * Ts;
+        Eigen::Matrix4d temp = relative_pose * jacobian_operator[i] * Ts;
         Js.block<6, 1>(0, i) = GetLinearized6DVector(temp);
     }
-    Eigen::Matrix6d Jt = Eigen::Matrix6d::Zero();
-    for (int32_t i = 0; i < 6; i++) {
-        Eigen::Matrix4d temp = X_inv * Tt_inv *
-                -jacobian_operator[i] * Ts;
-        Jt.block<6, 1>(0, i) = GetLinearized6DVector(temp);
-    }
-    return std::make_tuple(std::move(Js), std::move(Jt));
+    return Js;
 }
 
 /// Function to update line_process value defined in [Choi et al 2015]
@@ -124,9 +130,11 @@ int32_t UpdateConfidence(
         const double line_process_weight,
         const GlobalOptimizationOption &option)
 {
-    size_t n_edges = pose_graph.edges_.size();
-    int32_t valid_edges_num = 0;
-    for (size_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+    int32_t n_edges = (int32_t)pose_graph.edges_.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
         PoseGraphEdge &t = pose_graph.edges_[iter_edge];
         Eigen::Vector6d e = zeta.block<6, 1>(iter_edge * 6, 0);
         double residual_square = e.transpose() * t.information_ * e;
@@ -134,45 +142,82 @@ int32_t UpdateConfidence(
                 (line_process_weight + residual_square);
         double temp2 = temp * temp;
         t.confidence_ = temp2;
-        if (temp2 > option.edge_prune_threshold_)
+    }
+    int32_t valid_edges_num = 0;
+    for (const auto &t : pose_graph.edges_) {
+        if (t.confidence_ > option.edge_prune_threshold_)
             valid_edges_num++;
     }
     return valid_edges_num;
 }
 
 /// Function to compute residual defined in [Choi et al 2015] See Eq (9).
+/// Edge terms are evaluated in parallel and summed in edge order, so the
+/// result does not depend on the number of threads.
 double ComputeResidual(const PoseGraph &pose_graph, const Eigen::VectorXd &zeta,
-        const double line_process_weight,
-        const GlobalOptimizationOption &option)
+        const double line_process_weight)
 {
-    size_t n_edges = pose_graph.edges_.size();
-    double residual = 0.0;
-    for (size_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+    int32_t n_edges = (int32_t)pose_graph.edges_.size();
+    std::vector<double> edge_residuals(n_edges);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
         const PoseGraphEdge &te = pose_graph.edges_[iter_edge];
         double line_process_iter = 1.0;
         if (te.uncertain_)
             line_process_iter = te.confidence_;
         Eigen::Vector6d e = zeta.block<6, 1>(iter_edge * 6, 0);
-        residual += line_process_iter * e.transpose() * te.information_ * e +
+        edge_residuals[iter_edge] =
+                line_process_iter * e.transpose() * te.information_ * e +
                 line_process_weight * pow(sqrt(line_process_iter) - 1, 2.0);
     }
+    double residual = 0.0;
+    for (int32_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+        residual += edge_residuals[iter_edge];
+    }
     return residual;
 }
 
 /// Function to compute residual defined in [Choi et al 2015] See Eq (6).
-Eigen::VectorXd ComputeZeta(const PoseGraph &pose_graph)
+/// It also keeps X_inv * Tt_inv of every edge in relative_poses, so that
+/// PoseGraphLinearSystem::Build can reuse it when the poses are accepted.
+void ComputeZeta(const PoseGraph &pose_graph,
+        const Matrix4dVector &edge_inverses, Eigen::VectorXd &zeta,
+        Matrix4dVector &relative_poses)
 {
-    size_t n_edges = pose_graph.edges_.size();
-    Eigen::VectorXd output(n_edges * 6);
-    for (size_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
-        Eigen::Matrix4d X_inv, Ts, Tt_inv;
-        std::tie(X_inv, Ts, Tt_inv) = GetRelativePoses(pose_graph, iter_edge);
-        Eigen::Vector6d e = GetMisalignmentVector(X_inv, Ts, Tt_inv);
-        output.block<6, 1>(iter_edge * 6, 0) = e;
+    int32_t n_nodes = (int32_t)pose_graph.nodes_.size();
+    int32_t n_edges = (int32_t)pose_graph.edges_.size();
+    Matrix4dVector node_inverses(n_nodes);
+    zeta.resize(n_edges * 6);
+    relative_poses.resize(n_edges);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int32_t iter_node = 0; iter_node < n_nodes; iter_node++) {
+            node_inverses[iter_node] =
+                    pose_graph.nodes_[iter_node].pose_.inverse();
+        }
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int32_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+            const PoseGraphEdge &te = pose_graph.edges_[iter_edge];
+            relative_poses[iter_edge].noalias() = edge_inverses[iter_edge] *
+                    node_inverses[te.target_node_id_];
+            Eigen::Matrix4d temp;
+            temp.noalias() = relative_poses[iter_edge] *
+                    pose_graph.nodes_[te.source_node_id_].pose_;
+            zeta.block<6, 1>(iter_edge * 6, 0) = GetLinearized6DVector(temp);
+        }
     }
-    return std::move(output);
 }
 
+/// Class that holds the linear system H * delta = b of an iteration.
 /// The information matrix used here is consistent with [Choi et al 2015].
 /// It is [p_x | I]^T[p_x | I]. \zeta is [\alpha \beta \gamma a b c]
 /// Another definition of information matrix used for [Kümmerle et al 2011] is
@@ -184,53 +229,319 @@ Eigen::VectorXd ComputeZeta(const PoseGraph &pose_graph)
 /// https ://github.com/RainerKuemmerle/g2o/blob/master/doc/g2o.pdf
 /// Eq (20) and Eq (21). (There is a typo in the equation though. B should be J)
 ///
-/// This function focuses the case that every edge has two nodes (not hyper graph)
+/// This class focuses the case that every edge has two nodes (not hyper graph)
 /// so we have two Jacobian matrices from one constraint.
-std::tuple<Eigen::MatrixXd, Eigen::VectorXd> ComputeLinearSystem(
-        const PoseGraph &pose_graph, const Eigen::VectorXd &zeta)
+/// H is stored as 6x6 blocks: one diagonal block per node and one block per
+/// pair of connected nodes (lower triangle only, as H is symmetric). The block
+/// pattern only depends on the graph topology, so the sparse matrix and its
+/// symbolic factorization are built once and only the values are refilled.
+/// Nodes marked in fixed_nodes are kept out of the optimization: their rows
+/// and columns are replaced by identity so that their increment is zero.
+class PoseGraphLinearSystem
 {
-    size_t n_nodes = pose_graph.nodes_.size();
-    size_t n_edges = pose_graph.edges_.size();
-    Eigen::MatrixXd H(n_nodes * 6, n_nodes * 6);
-    Eigen::VectorXd b(n_nodes * 6);
-    H.setZero();
-    b.setZero();
+public:
+    PoseGraphLinearSystem(const PoseGraph &pose_graph,
+            const GlobalOptimizationOption &option,
+            const std::vector<bool> &fixed_nodes = std::vector<bool>());
+
+public:
+    /// relative_poses are the ones computed by ComputeZeta with zeta
+    void Build(const PoseGraph &pose_graph, const Eigen::VectorXd &zeta,
+            const Matrix4dVector &relative_poses);
+    /// Function to solve (H + lambda * I) * delta = b
+    bool Solve(double lambda, Eigen::VectorXd &delta);
+    double GetMaxDiagonal() const;
+
+private:
+    void FillSparseMatrix(double lambda);
+    bool SolveDense(double lambda, Eigen::VectorXd &delta) const;
+    bool SolveSparseCholesky(double lambda, Eigen::VectorXd &delta);
+    bool SolveConjugateGradient(double lambda, Eigen::VectorXd &delta);
 
+public:
+    Eigen::VectorXd b_;
+
+private:
+    const GlobalOptimizationOption &option_;
+    size_t n_nodes_;
+    std::vector<bool> fixed_nodes_;
+    /// blocks_[i] for i < n_nodes_ is the diagonal block of node i
+    std::vector<std::pair<int32_t, int32_t>> block_coordinates_;
+    Matrix6dVector blocks_;
+    /// Index of the off-diagonal block of every edge, -1 for self loops
+    std::vector<int32_t> edge_blocks_;
+    /// Contribution of every edge, computed in parallel before accumulation
+    Matrix6dVector edge_hessians_;
+    Vector6dVector edge_gradients_;
+    /// Position of the 6 columns of every block in H_.valuePtr()
+    std::vector<std::array<int32_t, 6>> block_value_offsets_;
+    Eigen::SparseMatrix<double> H_;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>, Eigen::Lower,
+            Eigen::AMDOrdering<int>> ldlt_;
+    bool pattern_analyzed_;
+};
+
+PoseGraphLinearSystem::PoseGraphLinearSystem(const PoseGraph &pose_graph,
+        const GlobalOptimizationOption &option,
+        const std::vector<bool> &fixed_nodes) : option_(option),
+        n_nodes_(pose_graph.nodes_.size()), fixed_nodes_(fixed_nodes),
+        pattern_analyzed_(false)
+{
+    fixed_nodes_.resize(n_nodes_, false);
+    for (size_t i = 0; i < n_nodes_; i++) {
+        block_coordinates_.push_back(std::make_pair((int32_t)i, (int32_t)i));
+    }
+    std::map<std::pair<int32_t, int32_t>, int32_t> block_map;
+    size_t n_edges = pose_graph.edges_.size();
+    edge_blocks_.resize(n_edges, -1);
     for (size_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
         const PoseGraphEdge &t = pose_graph.edges_[iter_edge];
-        Eigen::Vector6d e = zeta.block<6, 1>(iter_edge * 6, 0);
+        if (t.source_node_id_ == t.target_node_id_)
+            continue;
+        auto key = std::make_pair(
+                (std::max)(t.source_node_id_, t.target_node_id_),
+                (std::min)(t.source_node_id_, t.target_node_id_));
+        auto it = block_map.find(key);
+        if (it == block_map.end()) {
+            it = block_map.insert(std::make_pair(key,
+                    (int32_t)block_coordinates_.size())).first;
+            block_coordinates_.push_back(key);
+        }
+        edge_blocks_[iter_edge] = it->second;
+    }
+    blocks_.resize(block_coordinates_.size());
+    edge_hessians_.resize(n_edges);
+    edge_gradients_.resize(n_edges);
+    b_.resize(n_nodes_ * 6);
 
-        Eigen::Matrix4d X_inv, Ts, Tt_inv;
-        std::tie(X_inv, Ts, Tt_inv) = GetRelativePoses(pose_graph, iter_edge);
+    // Build the sparse pattern once and locate every block column in it.
+    // Within a column, rows are sorted, so a block starts at the column
+    // offset plus 6 times the number of blocks above it.
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(block_coordinates_.size() * 36);
+    std::vector<std::vector<std::pair<int32_t, int32_t>>> column_blocks(
+            n_nodes_);
+    for (size_t i = 0; i < block_coordinates_.size(); i++) {
+        int32_t row = block_coordinates_[i].first;
+        int32_t col = block_coordinates_[i].second;
+        column_blocks[col].push_back(std::make_pair(row, (int32_t)i));
+        for (int32_t c = 0; c < 6; c++) {
+            for (int32_t r = 0; r < 6; r++) {
+                triplets.push_back(Eigen::Triplet<double>(
+                        row * 6 + r, col * 6 + c, 0.0));
+            }
+        }
+    }
+    H_.resize(n_nodes_ * 6, n_nodes_ * 6);
+    H_.setFromTriplets(triplets.begin(), triplets.end());
+    H_.makeCompressed();
+    block_value_offsets_.resize(block_coordinates_.size());
+    for (size_t col = 0; col < n_nodes_; col++) {
+        std::sort(column_blocks[col].begin(), column_blocks[col].end());
+        for (size_t k = 0; k < column_blocks[col].size(); k++) {
+            int32_t block_id = column_blocks[col][k].second;
+            for (int32_t c = 0; c < 6; c++) {
+                block_value_offsets_[block_id][c] =
+                        H_.outerIndexPtr()[col * 6 + c] + (int32_t)k * 6;
+            }
+        }
+    }
+}
 
-        Eigen::Matrix6d Js, Jt;
-        std::tie(Js, Jt) = GetJacobian(X_inv, Ts, Tt_inv);
+void PoseGraphLinearSystem::Build(const PoseGraph &pose_graph,
+        const Eigen::VectorXd &zeta, const Matrix4dVector &relative_poses)
+{
+    // Linearize every edge in parallel. As Jt = -Js, an edge contributes
+    // H_ss = H_tt = -H_st = Js^T * Info * Js and b_s = -b_t.
+    int32_t n_edges = (int32_t)pose_graph.edges_.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+        const PoseGraphEdge &t = pose_graph.edges_[iter_edge];
+        Eigen::Vector6d e = zeta.block<6, 1>(iter_edge * 6, 0);
+        Eigen::Matrix6d Js = GetJacobian(relative_poses[iter_edge],
+                pose_graph.nodes_[t.source_node_id_].pose_);
         Eigen::Matrix6d JsT_Info =
                 Js.transpose() * t.information_;
-        Eigen::Matrix6d JtT_Info =
-                Jt.transpose() * t.information_;
         Eigen::Vector6d eT_Info = e.transpose() * t.information_;
 
         double line_process_iter = 1.0;
         if (t.uncertain_)
             line_process_iter = t.confidence_;
 
-        int32_t id_i = t.source_node_id_ * 6;
-        int32_t id_j = t.target_node_id_ * 6;
-        H.block<6, 6>(id_i, id_i).noalias() +=
+        edge_hessians_[iter_edge].noalias() =
                 line_process_iter * JsT_Info * Js;
-        H.block<6, 6>(id_i, id_j).noalias() +=
-                line_process_iter * JsT_Info * Jt;
-        H.block<6, 6>(id_j, id_i).noalias() +=
-                line_process_iter * JtT_Info * Js;
-        H.block<6, 6>(id_j, id_j).noalias() +=
-                line_process_iter * JtT_Info * Jt;
-        b.block<6, 1>(id_i, 0).noalias() -=
+        edge_gradients_[iter_edge].noalias() =
                 line_process_iter * eT_Info.transpose() * Js;
-        b.block<6, 1>(id_j, 0).noalias() -=
-                line_process_iter * eT_Info.transpose() * Jt;
     }
-    return std::make_tuple(std::move(H), std::move(b));
+
+    // Accumulate in edge order so that the system does not depend on the
+    // number of threads. Self loops cancel out.
+    for (auto &block : blocks_) {
+        block.setZero();
+    }
+    b_.setZero();
+    for (int32_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+        const PoseGraphEdge &t = pose_graph.edges_[iter_edge];
+        int32_t id_i = t.source_node_id_;
+        int32_t id_j = t.target_node_id_;
+        if (id_i == id_j)
+            continue;
+        blocks_[id_i] += edge_hessians_[iter_edge];
+        blocks_[id_j] += edge_hessians_[iter_edge];
+        blocks_[edge_blocks_[iter_edge]] -= edge_hessians_[iter_edge];
+        b_.block<6, 1>(id_i * 6, 0) -= edge_gradients_[iter_edge];
+        b_.block<6, 1>(id_j * 6, 0) += edge_gradients_[iter_edge];
+    }
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        int32_t row = block_coordinates_[i].first;
+        int32_t col = block_coordinates_[i].second;
+        if (fixed_nodes_[row] || fixed_nodes_[col]) {
+            if (row == col) {
+                blocks_[i].setIdentity();
+                b_.block<6, 1>(row * 6, 0).setZero();
+            } else {
+                blocks_[i].setZero();
+            }
+        }
+    }
+}
+
+double PoseGraphLinearSystem::GetMaxDiagonal() const
+{
+    double max_diagonal = 0.0;
+    for (size_t i = 0; i < n_nodes_; i++) {
+        if (fixed_nodes_[i])
+            continue;
+        max_diagonal = (std::max)(max_diagonal,
+                blocks_[i].diagonal().maxCoeff());
+    }
+    return max_diagonal;
+}
+
+bool PoseGraphLinearSystem::Solve(double lambda, Eigen::VectorXd &delta)
+{
+    switch (option_.linear_solver_) {
+    case GlobalOptimizationOption::LinearSolverType::Dense:
+        return SolveDense(lambda, delta);
+    case GlobalOptimizationOption::LinearSolverType::ConjugateGradient:
+        return SolveConjugateGradient(lambda, delta);
+    case GlobalOptimizationOption::LinearSolverType::SparseCholesky:
+    default:
+        return SolveSparseCholesky(lambda, delta);
+    }
+}
+
+void PoseGraphLinearSystem::FillSparseMatrix(double lambda)
+{
+    double *values = H_.valuePtr();
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        for (int32_t c = 0; c < 6; c++) {
+            Eigen::Map<Eigen::Vector6d>(values +
+                    block_value_offsets_[i][c]) = blocks_[i].col(c);
+        }
+    }
+    for (size_t i = 0; i < n_nodes_; i++) {
+        for (int32_t c = 0; c < 6; c++) {
+            values[block_value_offsets_[i][c] + c] += lambda;
+        }
+    }
+}
+
+bool PoseGraphLinearSystem::SolveDense(double lambda,
+        Eigen::VectorXd &delta) const
+{
+    Eigen::MatrixXd H = Eigen::MatrixXd::Zero(n_nodes_ * 6, n_nodes_ * 6);
+    for (size_t i = 0; i < blocks_.size(); i++) {
+        int32_t row = block_coordinates_[i].first * 6;
+        int32_t col = block_coordinates_[i].second * 6;
+        H.block<6, 6>(row, col) = blocks_[i];
+        if (row != col) {
+            H.block<6, 6>(col, row) = blocks_[i].transpose();
+        }
+    }
+    H.diagonal().array() += lambda;
+    Eigen::LDLT<Eigen::MatrixXd> ldlt(H);
+    if (ldlt.info() != Eigen::Success) {
+        PrintWarning("[GlobalOptimization] Dense LDLT factorization failed.\n");
+        return false;
+    }
+    delta = ldlt.solve(b_);
+    return true;
+}
+
+bool PoseGraphLinearSystem::SolveSparseCholesky(double lambda,
+        Eigen::VectorXd &delta)
+{
+    FillSparseMatrix(lambda);
+    if (!pattern_analyzed_) {
+        ldlt_.analyzePattern(H_);
+        pattern_analyzed_ = true;
+    }
+    ldlt_.factorize(H_);
+    if (ldlt_.info() != Eigen::Success) {
+        PrintWarning("[GlobalOptimization] Sparse LDLT factorization failed.\n");
+        return false;
+    }
+    delta = ldlt_.solve(b_);
+    return true;
+}
+
+/// Conjugate gradient preconditioned with the inverse of the 6x6 diagonal
+/// blocks, which captures the coupling between rotation and translation of
+/// every node.
+bool PoseGraphLinearSystem::SolveConjugateGradient(double lambda,
+        Eigen::VectorXd &delta)
+{
+    Matrix6dVector preconditioner(n_nodes_);
+    for (size_t i = 0; i < n_nodes_; i++) {
+        Eigen::Matrix6d block = blocks_[i] +
+                lambda * Eigen::Matrix6d::Identity();
+        if (block.diagonal().minCoeff() > 0.0) {
+            preconditioner[i] = block.inverse();
+        } else {
+            preconditioner[i].setIdentity();
+        }
+    }
+    FillSparseMatrix(lambda);
+    auto apply_preconditioner = [&](const Eigen::VectorXd &r,
+            Eigen::VectorXd &z) {
+        for (size_t i = 0; i < n_nodes_; i++) {
+            z.block<6, 1>(i * 6, 0).noalias() =
+                    preconditioner[i] * r.block<6, 1>(i * 6, 0);
+        }
+    };
+
+    size_t n = n_nodes_ * 6;
+    delta = Eigen::VectorXd::Zero(n);
+    Eigen::VectorXd r = b_, z(n), p(n), Ap(n);
+    double threshold = option_.relative_tolerance_cg_ *
+            option_.relative_tolerance_cg_ * b_.squaredNorm();
+    if (r.squaredNorm() <= threshold)
+        return true;
+    apply_preconditioner(r, z);
+    p = z;
+    double rz = r.dot(z);
+    uint32_t iter;
+    for (iter = 0; iter < option_.max_iteration_cg_; iter++) {
+        Ap.noalias() = H_.selfadjointView<Eigen::Lower>() * p;
+        double pAp = p.dot(Ap);
+        if (pAp <= 0.0)
+            break;
+        double alpha = rz / pAp;
+        delta += alpha * p;
+        r -= alpha * Ap;
+        if (r.squaredNorm() <= threshold)
+            break;
+        apply_preconditioner(r, z);
+        double rz_new = r.dot(z);
+        p = z + (rz_new / rz) * p;
+        rz = rz_new;
+    }
+    PrintDebug("[GlobalOptimization] Conjugate gradient : %d iterations, relative residual %e\n",
+            iter, std::sqrt(r.squaredNorm() / (b_.squaredNorm() + 1e-300)));
+    return true;
 }
 
 Eigen::VectorXd UpdatePoseVector(const PoseGraph &pose_graph)
@@ -374,62 +685,48 @@ void CompensateReferencePoseGraphNode(PoseGraph &pose_graph_new,
     }
 }
 
-}   // unnamed namespace
-
-std::shared_ptr<PoseGraph> CreatePoseGraphWithoutInvalidEdges(
-        const PoseGraph &pose_graph,
-        const GlobalOptimizationOption &option)
-{
-    std::shared_ptr<PoseGraph> pose_graph_pruned =
-            std::make_shared<PoseGraph>();
-
-    size_t n_nodes = pose_graph.nodes_.size();
-    for (size_t iter_node = 0; iter_node < n_nodes; iter_node++) {
-        const PoseGraphNode &t = pose_graph.nodes_[iter_node];
-        pose_graph_pruned->nodes_.push_back(t);
-    }
-    size_t n_edges = pose_graph.edges_.size();
-    for (size_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
-        const PoseGraphEdge &t = pose_graph.edges_[iter_edge];
-        if (t.uncertain_) {
-            if (t.confidence_ > option.edge_prune_threshold_) {
-                pose_graph_pruned->edges_.push_back(t);
-            }
-        } else {
-            pose_graph_pruned->edges_.push_back(t);
-        }
-    }
-    return pose_graph_pruned;
-}
-
-void GlobalOptimizationGaussNewton::
-        OptimizePoseGraph(PoseGraph &pose_graph,
+void OptimizePoseGraphGaussNewton(PoseGraph &pose_graph,
         const GlobalOptimizationConvergenceCriteria &criteria,
-        const GlobalOptimizationOption &option) const
+        const GlobalOptimizationOption &option, double line_process_weight,
+        const std::vector<bool> &fixed_nodes)
 {
     size_t n_nodes = pose_graph.nodes_.size();
     size_t n_edges = pose_graph.edges_.size();
-    double line_process_weight = ComputeLineProcessWeight(pose_graph, option);
 
     PrintDebug("[GlobalOptimizationGaussNewton] Optimizing PoseGraph having %d nodes and %d edges. \n",
             n_nodes, n_edges);
     PrintDebug("Line process weight : %f\n", line_process_weight);
 
-    Eigen::VectorXd zeta = ComputeZeta(pose_graph);
+    Matrix4dVector edge_inverses = ComputeEdgeInverses(pose_graph);
+    Eigen::VectorXd zeta;
+    Matrix4dVector relative_poses;
+    ComputeZeta(pose_graph, edge_inverses, zeta, relative_poses);
     double current_residual, new_residual;
     new_residual = ComputeResidual(pose_graph, zeta,
-            line_process_weight, option);
+            line_process_weight);
     current_residual = new_residual;
 
     int32_t valid_edges_num;
     valid_edges_num = UpdateConfidence(pose_graph, zeta,
             line_process_weight, option);
 
-    Eigen::MatrixXd H;
-    Eigen::VectorXd b;
+    // Without damping, H is singular unless the gauge freedom is removed, so
+    // the reference node is pinned when no node is fixed by the caller.
+    std::vector<bool> gauge_fixed_nodes(fixed_nodes);
+    gauge_fixed_nodes.resize(n_nodes, false);
+    if (n_nodes > 0 && std::find(gauge_fixed_nodes.begin(),
+            gauge_fixed_nodes.end(), true) == gauge_fixed_nodes.end()) {
+        int32_t reference_node = option.reference_node_;
+        if (reference_node < 0 || (size_t)reference_node >= n_nodes)
+            reference_node = 0;
+        gauge_fixed_nodes[reference_node] = true;
+    }
+    PoseGraphLinearSystem linear_system(pose_graph, option,
+            gauge_fixed_nodes);
+    const Eigen::VectorXd &b = linear_system.b_;
     Eigen::VectorXd x = UpdatePoseVector(pose_graph);
 
-    std::tie(H, b) = ComputeLinearSystem(pose_graph, zeta);
+    linear_system.Build(pose_graph, zeta, relative_poses);
 
     PrintDebug("[Initial     ] residual : %e\n", current_residual);
 
@@ -444,7 +741,9 @@ void GlobalOptimizationGaussNewton::
         Timer timer_iter;
         timer_iter.Start();
 
-        Eigen::VectorXd delta = H.ldlt().solve(b);
+        Eigen::VectorXd delta;
+        if (!linear_system.Solve(0.0, delta))
+            break;
 
         stop = stop || CheckRelativeIncrement(delta, x, criteria);
         if (stop) {
@@ -454,21 +753,24 @@ void GlobalOptimizationGaussNewton::
                 UpdatePoseGraph(pose_graph, delta);
 
             Eigen::VectorXd zeta_new;
-            zeta_new = ComputeZeta(*pose_graph_new);
+            Matrix4dVector relative_poses_new;
+            ComputeZeta(*pose_graph_new, edge_inverses, zeta_new,
+                    relative_poses_new);
             new_residual = ComputeResidual(pose_graph, zeta_new,
-                    line_process_weight, option);
+                    line_process_weight);
             stop = stop || CheckRelativeResidualIncrement(
                     current_residual, new_residual, criteria);
             if (stop)
                 break;
             current_residual = new_residual;
 
-            zeta = zeta_new;
+            zeta.swap(zeta_new);
+            relative_poses.swap(relative_poses_new);
             pose_graph = *pose_graph_new;
             x = UpdatePoseVector(pose_graph);
             valid_edges_num = UpdateConfidence(pose_graph, zeta,
                     line_process_weight, option);
-            std::tie(H, b) = ComputeLinearSystem(pose_graph, zeta);
+            linear_system.Build(pose_graph, zeta, relative_poses);
 
             stop = stop || CheckRightTerm(b, criteria);
             if (stop)
@@ -486,38 +788,39 @@ void GlobalOptimizationGaussNewton::
             timer_overall.GetDuration() / 1000.0);
 }
 
-void GlobalOptimizationLevenbergMarquardt::
-        OptimizePoseGraph(PoseGraph &pose_graph,
+void OptimizePoseGraphLevenbergMarquardt(PoseGraph &pose_graph,
         const GlobalOptimizationConvergenceCriteria &criteria,
-        const GlobalOptimizationOption &option) const
+        const GlobalOptimizationOption &option, double line_process_weight,
+        const std::vector<bool> &fixed_nodes)
 {
     size_t n_nodes = pose_graph.nodes_.size();
     size_t n_edges = pose_graph.edges_.size();
-    double line_process_weight = ComputeLineProcessWeight(pose_graph, option);
 
     PrintDebug("[GlobalOptimizationLM] Optimizing PoseGraph having %d nodes and %d edges. \n",
             n_nodes, n_edges);
     PrintDebug("Line process weight : %f\n", line_process_weight);
 
-    Eigen::VectorXd zeta = ComputeZeta(pose_graph);
+    Matrix4dVector edge_inverses = ComputeEdgeInverses(pose_graph);
+    Eigen::VectorXd zeta;
+    Matrix4dVector relative_poses;
+    ComputeZeta(pose_graph, edge_inverses, zeta, relative_poses);
     double current_residual, new_residual;
     new_residual = ComputeResidual(pose_graph, zeta,
-            line_process_weight, option);
+            line_process_weight);
     current_residual = new_residual;
 
     int32_t valid_edges_num = UpdateConfidence(pose_graph, zeta,
             line_process_weight, option);
 
-    Eigen::MatrixXd H_I = Eigen::MatrixXd::Identity(n_nodes * 6, n_nodes * 6);
-    Eigen::MatrixXd H;
-    Eigen::VectorXd b;
+    PoseGraphLinearSystem linear_system(pose_graph, option,
+            fixed_nodes);
+    const Eigen::VectorXd &b = linear_system.b_;
     Eigen::VectorXd x = UpdatePoseVector(pose_graph);
 
-    std::tie(H, b) = ComputeLinearSystem(pose_graph, zeta);
+    linear_system.Build(pose_graph, zeta, relative_poses);
 
-    Eigen::VectorXd H_diag = H.diagonal();
     double tau = 1e-5;
-    double current_lambda = tau * H_diag.maxCoeff();
+    double current_lambda = tau * linear_system.GetMaxDiagonal();
     double ni = 2.0;
     double rho = 0.0;
 
@@ -536,8 +839,11 @@ void GlobalOptimizationLevenbergMarquardt::
         timer_iter.Start();
         int32_t lm_count = 0;
         do {
-            Eigen::MatrixXd H_LM = H + current_lambda * H_I;
-            Eigen::VectorXd delta = H_LM.ldlt().solve(b);
+            Eigen::VectorXd delta;
+            if (!linear_system.Solve(current_lambda, delta)) {
+                stop = true;
+                break;
+            }
 
             stop = stop || CheckRelativeIncrement(delta, x, criteria);
             if (!stop) {
@@ -545,9 +851,11 @@ void GlobalOptimizationLevenbergMarquardt::
                         UpdatePoseGraph(pose_graph, delta);
 
                 Eigen::VectorXd zeta_new;
-                zeta_new = ComputeZeta(*pose_graph_new);
+                Matrix4dVector relative_poses_new;
+                ComputeZeta(*pose_graph_new, edge_inverses, zeta_new,
+                        relative_poses_new);
                 new_residual = ComputeResidual(pose_graph, zeta_new,
-                        line_process_weight, option);
+                        line_process_weight);
                 rho = (current_residual - new_residual) /
                         (delta.dot(current_lambda * delta + b) + 1e-3);
                 if (rho > 0) {
@@ -563,12 +871,13 @@ void GlobalOptimizationLevenbergMarquardt::
                     ni = 2;
                     current_residual = new_residual;
 
-                    zeta = zeta_new;
+                    zeta.swap(zeta_new);
+                    relative_poses.swap(relative_poses_new);
                     pose_graph = *pose_graph_new;
                     x = UpdatePoseVector(pose_graph);
                     valid_edges_num = UpdateConfidence(pose_graph, zeta,
                             line_process_weight, option);
-                    std::tie(H, b) = ComputeLinearSystem(pose_graph, zeta);
+                    linear_system.Build(pose_graph, zeta, relative_poses);
 
                     stop = stop || CheckRightTerm(b, criteria);
                     if (stop)
@@ -595,6 +904,162 @@ void GlobalOptimizationLevenbergMarquardt::
             timer_overall.GetDuration() / 1000.0);
 }
 
+}   // unnamed namespace
+
+std::shared_ptr<PoseGraph> CreatePoseGraphWithoutInvalidEdges(
+        const PoseGraph &pose_graph,
+        const GlobalOptimizationOption &option)
+{
+    std::shared_ptr<PoseGraph> pose_graph_pruned =
+            std::make_shared<PoseGraph>();
+
+    size_t n_nodes = pose_graph.nodes_.size();
+    for (size_t iter_node = 0; iter_node < n_nodes; iter_node++) {
+        const PoseGraphNode &t = pose_graph.nodes_[iter_node];
+        pose_graph_pruned->nodes_.push_back(t);
+    }
+    size_t n_edges = pose_graph.edges_.size();
+    for (size_t iter_edge = 0; iter_edge < n_edges; iter_edge++) {
+        const PoseGraphEdge &t = pose_graph.edges_[iter_edge];
+        if (t.uncertain_) {
+            if (t.confidence_ > option.edge_prune_threshold_) {
+                pose_graph_pruned->edges_.push_back(t);
+            }
+        } else {
+            pose_graph_pruned->edges_.push_back(t);
+        }
+    }
+    return pose_graph_pruned;
+}
+
+void GlobalOptimizationGaussNewton::
+        OptimizePoseGraph(PoseGraph &pose_graph,
+        const GlobalOptimizationConvergenceCriteria &criteria,
+        const GlobalOptimizationOption &option) const
+{
+    OptimizePoseGraphGaussNewton(pose_graph, criteria, option,
+            ComputeLineProcessWeight(pose_graph, option), std::vector<bool>());
+}
+
+void GlobalOptimizationLevenbergMarquardt::
+        OptimizePoseGraph(PoseGraph &pose_graph,
+        const GlobalOptimizationConvergenceCriteria &criteria,
+        const GlobalOptimizationOption &option) const
+{
+    OptimizePoseGraphLevenbergMarquardt(pose_graph, criteria, option,
+            ComputeLineProcessWeight(pose_graph, option), std::vector<bool>());
+}
+
+void GlobalOptimizationHierarchical::
+        OptimizePoseGraph(PoseGraph &pose_graph,
+        const GlobalOptimizationConvergenceCriteria &criteria,
+        const GlobalOptimizationOption &option) const
+{
+    int32_t n_nodes = (int32_t)pose_graph.nodes_.size();
+    int32_t n_edges = (int32_t)pose_graph.edges_.size();
+    // The line process weight of the whole graph is used at every level.
+    double line_process_weight = ComputeLineProcessWeight(pose_graph, option);
+    if (submap_size_ <= 1 || n_nodes <= submap_size_) {
+        OptimizePoseGraphLevenbergMarquardt(pose_graph, criteria, option,
+                line_process_weight, std::vector<bool>());
+        return;
+    }
+    int32_t n_submaps = (n_nodes + submap_size_ - 1) / submap_size_;
+    PrintDebug("[GlobalOptimizationHierarchical] Optimizing PoseGraph having %d nodes and %d edges in %d submaps.\n",
+            n_nodes, n_edges, n_submaps);
+
+    std::vector<PoseGraph> submaps(n_submaps);
+    std::vector<std::vector<int32_t>> submap_edges(n_submaps);
+    std::vector<int32_t> coarse_edges;
+    for (int32_t i = 0; i < n_nodes; i++) {
+        submaps[i / submap_size_].nodes_.push_back(pose_graph.nodes_[i]);
+    }
+    for (int32_t i = 0; i < n_edges; i++) {
+        PoseGraphEdge edge = pose_graph.edges_[i];
+        int32_t submap_id = edge.source_node_id_ / submap_size_;
+        if (submap_id == edge.target_node_id_ / submap_size_) {
+            edge.source_node_id_ -= submap_id * submap_size_;
+            edge.target_node_id_ -= submap_id * submap_size_;
+            submaps[submap_id].edges_.push_back(edge);
+            submap_edges[submap_id].push_back(i);
+        } else {
+            coarse_edges.push_back(i);
+        }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t k = 0; k < n_submaps; k++) {
+        if (submaps[k].edges_.empty())
+            continue;
+        std::vector<bool> fixed_nodes(submaps[k].nodes_.size(), false);
+        fixed_nodes[0] = true;
+        OptimizePoseGraphLevenbergMarquardt(submaps[k], criteria, option,
+                line_process_weight, fixed_nodes);
+    }
+
+    // Every node is expressed in the frame of its anchor: T_i = A_k * L_i.
+    // An edge with X ~ T_t^-1 * T_s becomes A_b^-1 * A_a ~ L_t * X * L_s^-1
+    // between the anchors. Its misalignment vector is the original one
+    // transformed by the adjoint of L_s, so the information matrix is
+    // transformed by the inverse adjoint.
+    Matrix4dVector local_poses(n_nodes);
+    PoseGraph coarse_graph;
+    for (int32_t k = 0; k < n_submaps; k++) {
+        Eigen::Matrix4d anchor_inverse = submaps[k].nodes_[0].pose_.inverse();
+        for (size_t j = 0; j < submaps[k].nodes_.size(); j++) {
+            local_poses[k * submap_size_ + j] =
+                    anchor_inverse * submaps[k].nodes_[j].pose_;
+        }
+        coarse_graph.nodes_.push_back(submaps[k].nodes_[0]);
+        for (size_t j = 0; j < submap_edges[k].size(); j++) {
+            pose_graph.edges_[submap_edges[k][j]].confidence_ =
+                    submaps[k].edges_[j].confidence_;
+        }
+    }
+    for (int32_t edge_id : coarse_edges) {
+        PoseGraphEdge edge = pose_graph.edges_[edge_id];
+        const Eigen::Matrix4d &Ls = local_poses[edge.source_node_id_];
+        const Eigen::Matrix4d &Lt = local_poses[edge.target_node_id_];
+        Eigen::Matrix3d R = Ls.block<3, 3>(0, 0);
+        Eigen::Vector3d t = Ls.block<3, 1>(0, 3);
+        Eigen::Matrix3d t_hat;
+        t_hat << 0, -t(2), t(1), t(2), 0, -t(0), -t(1), t(0), 0;
+        Eigen::Matrix6d adjoint_inverse = Eigen::Matrix6d::Zero();
+        adjoint_inverse.block<3, 3>(0, 0) = R.transpose();
+        adjoint_inverse.block<3, 3>(3, 3) = R.transpose();
+        adjoint_inverse.block<3, 3>(3, 0) = -R.transpose() * t_hat;
+        edge.transformation_ = Lt * edge.transformation_ * Ls.inverse();
+        edge.information_ = adjoint_inverse.transpose() * edge.information_ *
+                adjoint_inverse;
+        edge.source_node_id_ /= submap_size_;
+        edge.target_node_id_ /= submap_size_;
+        coarse_graph.edges_.push_back(edge);
+    }
+    if (!coarse_graph.edges_.empty()) {
+        OptimizePoseGraphLevenbergMarquardt(coarse_graph, criteria, option,
+                line_process_weight, std::vector<bool>());
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t i = 0; i < n_nodes; i++) {
+        pose_graph.nodes_[i].pose_ =
+                coarse_graph.nodes_[i / submap_size_].pose_ * local_poses[i];
+    }
+    for (size_t j = 0; j < coarse_edges.size(); j++) {
+        pose_graph.edges_[coarse_edges[j]].confidence_ =
+                coarse_graph.edges_[j].confidence_;
+    }
+
+    if (global_refinement_) {
+        OptimizePoseGraphLevenbergMarquardt(pose_graph, criteria, option,
+                line_process_weight, std::vector<bool>());
+    }
+}
+
 void GlobalOptimization(
         PoseGraph &pose_graph,
         const GlobalOptimizationMethod &method
@@ -616,4 +1081,129 @@ void GlobalOptimization(
     pose_graph = *pose_graph_pruned;
 }
 
+IncrementalGlobalOptimization::IncrementalGlobalOptimization(
+        const GlobalOptimizationConvergenceCriteria &criteria
+        /* = GlobalOptimizationConvergenceCriteria() */,
+        const GlobalOptimizationOption &option
+        /* = GlobalOptimizationOption() */,
+        double max_affected_ratio/* = 0.5*/) :
+        criteria_(criteria), option_(option),
+        max_affected_ratio_(max_affected_ratio), first_affected_node_(-1),
+        information_sum_(0.0)
+{
+}
+
+IncrementalGlobalOptimization::~IncrementalGlobalOptimization()
+{
+}
+
+void IncrementalGlobalOptimization::AddNode(const PoseGraphNode &node)
+{
+    pose_graph_.nodes_.push_back(node);
+    node_edges_.push_back(std::vector<int32_t>());
+    if (first_affected_node_ < 0) {
+        first_affected_node_ = (int32_t)pose_graph_.nodes_.size() - 1;
+    }
+}
+
+bool IncrementalGlobalOptimization::AddEdge(const PoseGraphEdge &edge)
+{
+    int32_t n_nodes = (int32_t)pose_graph_.nodes_.size();
+    if (edge.source_node_id_ < 0 || edge.source_node_id_ >= n_nodes ||
+            edge.target_node_id_ < 0 || edge.target_node_id_ >= n_nodes) {
+        PrintWarning("[IncrementalGlobalOptimization] Edge (%d, %d) refers to a node that has not been added.\n",
+                edge.source_node_id_, edge.target_node_id_);
+        return false;
+    }
+    int32_t edge_id = (int32_t)pose_graph_.edges_.size();
+    pose_graph_.edges_.push_back(edge);
+    node_edges_[edge.source_node_id_].push_back(edge_id);
+    if (edge.target_node_id_ != edge.source_node_id_) {
+        node_edges_[edge.target_node_id_].push_back(edge_id);
+    }
+    information_sum_ += edge.information_(0, 0);
+    int32_t first_node = (std::min)(edge.source_node_id_,
+            edge.target_node_id_);
+    if (first_affected_node_ < 0 || first_node < first_affected_node_) {
+        first_affected_node_ = first_node;
+    }
+    return true;
+}
+
+void IncrementalGlobalOptimization::Update()
+{
+    if (first_affected_node_ < 0)
+        return;
+    int32_t n_nodes = (int32_t)pose_graph_.nodes_.size();
+    int32_t n_edges = (int32_t)pose_graph_.edges_.size();
+    int32_t reference_node = option_.reference_node_;
+    if (reference_node < 0 || reference_node >= n_nodes)
+        reference_node = 0;
+    int32_t first_node = first_affected_node_;
+    first_affected_node_ = -1;
+    if (n_edges == 0)
+        return;
+    if ((double)(n_nodes - first_node) > max_affected_ratio_ * n_nodes) {
+        PrintDebug("[IncrementalGlobalOptimization] %d of %d nodes affected, relinearizing the whole graph.\n",
+                n_nodes - first_node, n_nodes);
+        first_node = 0;
+    }
+    // see Section 5 in [Choi et al 2015]
+    double line_process_weight = 2.0 *
+            pow(option_.max_correspondence_distance_, 2) *
+            information_sum_ / (double)n_edges;
+
+    // Affected nodes come first, followed by the older nodes they are
+    // connected to, which are kept fixed.
+    PoseGraph pose_graph_affected;
+    std::vector<bool> fixed_nodes;
+    for (int32_t i = first_node; i < n_nodes; i++) {
+        pose_graph_affected.nodes_.push_back(pose_graph_.nodes_[i]);
+        fixed_nodes.push_back(i == reference_node);
+    }
+    std::unordered_map<int32_t, int32_t> boundary_node_map;
+    std::vector<int32_t> affected_edges;
+    for (int32_t i = first_node; i < n_nodes; i++) {
+        for (int32_t edge_id : node_edges_[i]) {
+            PoseGraphEdge edge = pose_graph_.edges_[edge_id];
+            int32_t other_node = edge.source_node_id_ == i ?
+                    edge.target_node_id_ : edge.source_node_id_;
+            // an edge between two affected nodes is added by the later one
+            if (other_node >= first_node && other_node > i)
+                continue;
+            for (int32_t *node_id : {&edge.source_node_id_,
+                    &edge.target_node_id_}) {
+                if (*node_id >= first_node) {
+                    *node_id -= first_node;
+                    continue;
+                }
+                auto it = boundary_node_map.find(*node_id);
+                if (it == boundary_node_map.end()) {
+                    it = boundary_node_map.insert(std::make_pair(*node_id,
+                            (int32_t)pose_graph_affected.nodes_.size())).first;
+                    pose_graph_affected.nodes_.push_back(
+                            pose_graph_.nodes_[*node_id]);
+                    fixed_nodes.push_back(true);
+                }
+                *node_id = it->second;
+            }
+            pose_graph_affected.edges_.push_back(edge);
+            affected_edges.push_back(edge_id);
+        }
+    }
+    if (pose_graph_affected.edges_.empty())
+        return;
+
+    OptimizePoseGraphLevenbergMarquardt(pose_graph_affected, criteria_,
+            option_, line_process_weight, fixed_nodes);
+
+    for (int32_t i = first_node; i < n_nodes; i++) {
+        pose_graph_.nodes_[i] = pose_graph_affected.nodes_[i - first_node];
+    }
+    for (size_t i = 0; i < affected_edges.size(); i++) {
+        pose_graph_.edges_[affected_edges[i]].confidence_ =
+                pose_graph_affected.edges_[i].confidence_;
+    }
+}
+
 }   // namespace open3d
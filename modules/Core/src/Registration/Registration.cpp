@@ -27,8 +27,10 @@
 
 #include <Open3D/Core/Registration/Registration.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <random>
 
 #include <Open3D/Core/Utility/Console.h>
 #include <Open3D/Core/Geometry/PointCloud.h>
@@ -39,61 +41,122 @@ namespace open3d {
 
 namespace {
 
-RegistrationResult GetRegistrationResultAndCorrespondences(
-        const PointCloud &source, const PointCloud &target,
-        const KDTreeFlann &target_kdtree, double max_correspondence_distance,
-        const Eigen::Matrix4d &transformation)
+/// Function to build a correspondence set from the target index found for
+/// every source point (-1 if there is no correspondence)
+void MaterializeCorrespondenceSet(const std::vector<int32_t> &target_indices,
+        CorrespondenceSet &correspondence_set)
 {
-    RegistrationResult result(transformation);
-    if (max_correspondence_distance <= 0.0) {
-        return std::move(result);
+    correspondence_set.clear();
+    for (size_t i = 0; i < target_indices.size(); i++) {
+        if (target_indices[i] >= 0) {
+            correspondence_set.push_back(Eigen::Vector2i(static_cast<int32_t>(i),
+                    target_indices[i]));
+        }
     }
+}
 
+/// Function to search the correspondence of every source point transformed
+/// by transformation, and to evaluate fitness and rmse. Every thread writes
+/// into its own slots of target_indices, and the statistics of the estimation
+/// (if any) are reduced per thread, so no lock is taken per point.
+RegistrationResult ComputeRegistrationResultFused(const PointCloud &source,
+        const PointCloud &target, const KDTreeFlann &target_kdtree,
+        double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation,
+        const TransformationEstimation *estimation,
+        std::vector<int32_t> &target_indices, Eigen::VectorXd &statistics)
+{
+    RegistrationResult result(transformation);
+    size_t statistics_size = estimation == nullptr ? 0 :
+            estimation->GetFusedStatisticsSize();
+    statistics = Eigen::VectorXd::Zero(statistics_size);
+    target_indices.resize(source.points_.size());
+    const bool is_identity = transformation.isIdentity();
+    const Eigen::Matrix3d rotation = transformation.block<3, 3>(0, 0);
+    const Eigen::Vector3d translation = transformation.block<3, 1>(0, 3);
     double error2 = 0.0;
+    int32_t corres_number = 0;
 
 #ifdef _OPENMP
 #pragma omp parallel
     {
 #endif
+        std::vector<int32_t> indices(1);
+        std::vector<double> dists(1);
+        Eigen::VectorXd statistics_private =
+                Eigen::VectorXd::Zero(statistics_size);
         double error2_private = 0.0;
-        CorrespondenceSet correspondence_set_private;
+        int32_t corres_number_private = 0;
 #ifdef _OPENMP
 #pragma omp for nowait
 #endif
         for (int32_t i = 0; i < static_cast<int32_t>(source.points_.size()); i++) {
-            std::vector<int32_t> indices(1);
-            std::vector<double> dists(1);
-            const auto &point = source.points_[i];
-            if (target_kdtree.SearchHybrid(point, max_correspondence_distance, 1,
-                    indices, dists) > 0) {
+            const Eigen::Vector3d point = is_identity ? source.points_[i] :
+                    Eigen::Vector3d(rotation * source.points_[i] + translation);
+            if (target_kdtree.SearchHybrid(point, max_correspondence_distance,
+                    1, indices, dists) > 0) {
+                target_indices[i] = indices[0];
                 error2_private += dists[0];
-                correspondence_set_private.push_back(
-                        Eigen::Vector2i(i, indices[0]));
+                corres_number_private++;
+                if (statistics_size > 0) {
+                    estimation->AccumulateFusedStatistics(source, i, point,
+                            target, indices[0], statistics_private);
+                }
+            } else {
+                target_indices[i] = -1;
             }
         }
 #ifdef _OPENMP
 #pragma omp critical
 #endif
         {
-            for (size_t i = 0; i < correspondence_set_private.size(); i++) {
-                result.correspondence_set_.push_back(
-                        correspondence_set_private[i]);
-            }
             error2 += error2_private;
+            corres_number += corres_number_private;
+            statistics += statistics_private;
         }
 #ifdef _OPENMP
     }
 #endif
 
-    if (result.correspondence_set_.empty()) {
+    if (corres_number == 0) {
         result.fitness_ = 0.0;
         result.inlier_rmse_ = 0.0;
     } else {
-        size_t corres_number = result.correspondence_set_.size();
         result.fitness_ = (double)corres_number / (double)source.points_.size();
         result.inlier_rmse_ = std::sqrt(error2 / (double)corres_number);
     }
-    return std::move(result);
+    return result;
+}
+
+/// Function to evaluate a registration, source is not transformed
+RegistrationResult EvaluateRegistrationWithKDTree(const PointCloud &source,
+        const PointCloud &target, const KDTreeFlann &target_kdtree,
+        double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation)
+{
+    if (max_correspondence_distance <= 0.0) {
+        return RegistrationResult(transformation);
+    }
+    std::vector<int32_t> target_indices;
+    Eigen::VectorXd statistics;
+    RegistrationResult result = ComputeRegistrationResultFused(source, target,
+            target_kdtree, max_correspondence_distance, transformation,
+            nullptr, target_indices, statistics);
+    MaterializeCorrespondenceSet(target_indices, result.correspondence_set_);
+    return result;
+}
+
+/// Function to evaluate a registration, source is already transformed
+RegistrationResult GetRegistrationResultAndCorrespondences(
+        const PointCloud &source, const PointCloud &target,
+        const KDTreeFlann &target_kdtree, double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation)
+{
+    RegistrationResult result = EvaluateRegistrationWithKDTree(source, target,
+            target_kdtree, max_correspondence_distance,
+            Eigen::Matrix4d::Identity());
+    result.transformation_ = transformation;
+    return result;
 }
 
 RegistrationResult EvaluateRANSACBasedOnCorrespondence(const PointCloud &source,
@@ -101,13 +164,17 @@ RegistrationResult EvaluateRANSACBasedOnCorrespondence(const PointCloud &source,
         double max_correspondence_distance,
         const Eigen::Matrix4d &transformation)
 {
+    // source is not transformed; the transformation is applied on the fly to
+    // the corresponding points only, avoiding a copy of the whole point cloud
     RegistrationResult result(transformation);
     double error2 = 0.0;
     int32_t good = 0;
     double max_dis2 = max_correspondence_distance * max_correspondence_distance;
+    const Eigen::Matrix3d rotation = transformation.block<3, 3>(0, 0);
+    const Eigen::Vector3d translation = transformation.block<3, 1>(0, 3);
     for (const auto &c : corres) {
-        double dis2 =
-                (source.points_[c[0]] - target.points_[c[1]]).squaredNorm();
+        double dis2 = (rotation * source.points_[c[0]] + translation -
+                target.points_[c[1]]).squaredNorm();
         if (dis2 < max_dis2) {
             good++;
             error2 += dis2;
@@ -123,35 +190,97 @@ RegistrationResult EvaluateRANSACBasedOnCorrespondence(const PointCloud &source,
     return result;
 }
 
-}   // unnamed namespace
+/// Function to draw sample_num distinct indices out of [0, num) with a partial
+/// Fisher-Yates shuffle. All indices are returned if sample_num is 0 or not
+/// smaller than num.
+std::vector<int32_t> SampleIndices(size_t num, size_t sample_num,
+        std::mt19937 &generator)
+{
+    std::vector<int32_t> indices(num);
+    for (size_t i = 0; i < num; i++) {
+        indices[i] = static_cast<int32_t>(i);
+    }
+    if (sample_num > 0 && sample_num < num) {
+        for (size_t i = 0; i < sample_num; i++) {
+            std::uniform_int_distribution<size_t> distribution(i, num - 1);
+            std::swap(indices[i], indices[distribution(generator)]);
+        }
+        indices.resize(sample_num);
+    }
+    return indices;
+}
 
-RegistrationResult EvaluateRegistration(const PointCloud &source,
-        const PointCloud &target, double max_correspondence_distance,
-        const Eigen::Matrix4d &transformation/* = Eigen::Matrix4d::Identity()*/)
+bool IsBetterRegistrationResult(const RegistrationResult &a,
+        const RegistrationResult &b)
 {
-    KDTreeFlann kdtree;
-    kdtree.SetGeometry(target);
-    PointCloud pcd = source;
-    if (transformation.isIdentity() == false) {
-        pcd.Transform(transformation);
+    return a.fitness_ > b.fitness_ || (a.fitness_ == b.fitness_ &&
+            a.inlier_rmse_ < b.inlier_rmse_);
+}
+
+/// Keeps candidates sorted from best to worst, with at most max_size entries
+void InsertRegistrationCandidate(std::vector<RegistrationResult> &candidates,
+        const RegistrationResult &candidate, size_t max_size)
+{
+    if (max_size == 0 || (candidates.size() >= max_size &&
+            !IsBetterRegistrationResult(candidate, candidates.back()))) {
+        return;
+    }
+    candidates.insert(std::upper_bound(candidates.begin(), candidates.end(),
+            candidate, IsBetterRegistrationResult), candidate);
+    if (candidates.size() > max_size) {
+        candidates.pop_back();
     }
-    return GetRegistrationResultAndCorrespondences(pcd, target,
-            kdtree, max_correspondence_distance, transformation);
 }
 
-RegistrationResult RegistrationICP(const PointCloud &source,
-        const PointCloud &target, double max_correspondence_distance,
-        const Eigen::Matrix4d &init/* = Eigen::Matrix4d::Identity()*/,
-        const TransformationEstimation &estimation
-        /* = TransformationEstimationPointToPoint(false)*/,
-        const ICPConvergenceCriteria &criteria/* = ICPConvergenceCriteria()*/)
+/// ICP in which every iteration is a single pass over the source: the
+/// correspondence search also accumulates the statistics of the estimation.
+/// The correspondence set is only materialized for the final result.
+RegistrationResult RegistrationICPFused(const PointCloud &source,
+        const PointCloud &target, const KDTreeFlann &kdtree,
+        double max_correspondence_distance, const Eigen::Matrix4d &init,
+        const TransformationEstimation &estimation,
+        const ICPConvergenceCriteria &criteria)
+{
+    Eigen::Matrix4d transformation = init;
+    std::vector<int32_t> target_indices;
+    Eigen::VectorXd statistics;
+    RegistrationResult result = ComputeRegistrationResultFused(source, target,
+            kdtree, max_correspondence_distance, transformation, &estimation,
+            target_indices, statistics);
+    for (uint32_t i = 0; i < criteria.max_iteration_; i++) {
+        PrintDebug("ICP Iteration #%d: Fitness %.4f, RMSE %.4f\n", i,
+                result.fitness_, result.inlier_rmse_);
+        Eigen::Matrix4d update =
+                estimation.ComputeTransformationFromFusedStatistics(statistics);
+        transformation = update * transformation;
+        RegistrationResult backup = result;
+        result = ComputeRegistrationResultFused(source, target, kdtree,
+                max_correspondence_distance, transformation, &estimation,
+                target_indices, statistics);
+        if (std::abs(backup.fitness_ - result.fitness_) <
+                criteria.relative_fitness_ && std::abs(backup.inlier_rmse_ -
+                result.inlier_rmse_) < criteria.relative_rmse_) {
+            break;
+        }
+    }
+    MaterializeCorrespondenceSet(target_indices, result.correspondence_set_);
+    return result;
+}
+
+RegistrationResult RegistrationICPWithKDTree(const PointCloud &source,
+        const PointCloud &target, const KDTreeFlann &kdtree,
+        double max_correspondence_distance, const Eigen::Matrix4d &init,
+        const TransformationEstimation &estimation,
+        const ICPConvergenceCriteria &criteria)
 {
     if (max_correspondence_distance <= 0.0) {
         return RegistrationResult(init);
     }
+    if (estimation.GetFusedStatisticsSize() > 0) {
+        return RegistrationICPFused(source, target, kdtree,
+                max_correspondence_distance, init, estimation, criteria);
+    }
     Eigen::Matrix4d transformation = init;
-    KDTreeFlann kdtree;
-    kdtree.SetGeometry(target);
     PointCloud pcd = source;
     if (init.isIdentity() == false) {
         pcd.Transform(init);
@@ -178,6 +307,272 @@ RegistrationResult RegistrationICP(const PointCloud &source,
     return result;
 }
 
+Eigen::Matrix6d GetInformationMatrixWithKDTree(
+        const PointCloud &source, const PointCloud &target,
+        const KDTreeFlann &target_kdtree, double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation)
+{
+    RegistrationResult result;
+    result = GetRegistrationResultAndCorrespondences(source, target,
+            target_kdtree, max_correspondence_distance, transformation);
+
+    // write q^*
+    // see http://redwood-data.org/indoor/registration.html
+    // note: I comes first in this implementation
+    Eigen::Matrix6d GTG = Eigen::Matrix6d::Identity();
+#ifdef _OPENMP
+#pragma omp parallel
+    {
+#endif
+        Eigen::Matrix6d GTG_private = Eigen::Matrix6d::Identity();
+        Eigen::Vector6d G_r_private = Eigen::Vector6d::Zero();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int32_t c = 0; c < static_cast<int32_t>(result.correspondence_set_.size()); c++) {
+            int32_t t = result.correspondence_set_[c](1);
+            double x = target.points_[t](0);
+            double y = target.points_[t](1);
+            double z = target.points_[t](2);
+            G_r_private.setZero();
+            G_r_private(0) = 1.0;
+            G_r_private(4) = z;
+            G_r_private(5) = -y;
+            GTG_private.noalias() += G_r_private * G_r_private.transpose();
+            G_r_private.setZero();
+            G_r_private(1) = 1.0;
+            G_r_private(3) = -z;
+            G_r_private(5) = x;
+            GTG_private.noalias() += G_r_private * G_r_private.transpose();
+            G_r_private.setZero();
+            G_r_private(2) = 1.0;
+            G_r_private(3) = y;
+            G_r_private(4) = -x;
+            GTG_private.noalias() += G_r_private * G_r_private.transpose();
+        }
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+        {
+            GTG += GTG_private;
+        }
+#ifdef _OPENMP
+    }
+#endif
+    return std::move(GTG);
+}
+
+}   // unnamed namespace
+
+RegistrationResult EvaluateRegistration(const PointCloud &source,
+        const PointCloud &target, double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation/* = Eigen::Matrix4d::Identity()*/)
+{
+    KDTreeFlann kdtree;
+    kdtree.SetGeometry(target);
+    return EvaluateRegistrationWithKDTree(source, target, kdtree,
+            max_correspondence_distance, transformation);
+}
+
+RegistrationResult EvaluateRegistration(const PointCloud &source,
+        const RegistrationTarget &target, double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation/* = Eigen::Matrix4d::Identity()*/)
+{
+    return EvaluateRegistrationWithKDTree(source, *target.pointcloud_,
+            *target.kdtree_, max_correspondence_distance, transformation);
+}
+
+RegistrationResult RegistrationICP(const PointCloud &source,
+        const PointCloud &target, double max_correspondence_distance,
+        const Eigen::Matrix4d &init/* = Eigen::Matrix4d::Identity()*/,
+        const TransformationEstimation &estimation
+        /* = TransformationEstimationPointToPoint(false)*/,
+        const ICPConvergenceCriteria &criteria/* = ICPConvergenceCriteria()*/)
+{
+    if (max_correspondence_distance <= 0.0) {
+        return RegistrationResult(init);
+    }
+    KDTreeFlann kdtree;
+    kdtree.SetGeometry(target);
+    return RegistrationICPWithKDTree(source, target, kdtree,
+            max_correspondence_distance, init, estimation, criteria);
+}
+
+RegistrationResult RegistrationICP(const PointCloud &source,
+        const RegistrationTarget &target, double max_correspondence_distance,
+        const Eigen::Matrix4d &init/* = Eigen::Matrix4d::Identity()*/,
+        const TransformationEstimation &estimation
+        /* = TransformationEstimationPointToPoint(false)*/,
+        const ICPConvergenceCriteria &criteria/* = ICPConvergenceCriteria()*/)
+{
+    return RegistrationICPWithKDTree(source, *target.pointcloud_,
+            *target.kdtree_, max_correspondence_distance, init, estimation,
+            criteria);
+}
+
+RegistrationTarget::RegistrationTarget(const PointCloud &target) :
+        pointcloud_(std::make_shared<PointCloud>(target)),
+        kdtree_(std::make_shared<KDTreeFlann>(*pointcloud_))
+{
+}
+
+RegistrationTarget::~RegistrationTarget()
+{
+}
+
+bool RegistrationTarget::PrepareNormals(const KDTreeSearchParam &search_param
+        /* = KDTreeSearchParamKNN()*/)
+{
+    if (pointcloud_->HasNormals()) {
+        return true;
+    }
+    return EstimateNormals(*pointcloud_, search_param);
+}
+
+bool RegistrationTarget::PrepareColorGradients(
+        const KDTreeSearchParamHybrid &search_param)
+{
+    const PointCloud &target = *pointcloud_;
+    if (target.HasNormals() == false || target.HasColors() == false) {
+        PrintWarning("[RegistrationTarget] Color gradients require normals and colors.\n");
+        return false;
+    }
+
+    size_t n_points = target.points_.size();
+    color_gradients_.resize(n_points);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int32_t k = 0; k < static_cast<int32_t>(n_points); k++) {
+        const Eigen::Vector3d &vt = target.points_[k];
+        const Eigen::Vector3d &nt = target.normals_[k];
+        double it = (target.colors_[k](0) + target.colors_[k](1)
+                + target.colors_[k](2)) / 3.0;
+        color_gradients_[k].setZero();
+
+        std::vector<int32_t> point_idx;
+        std::vector<double> point_squared_distance;
+
+        if (kdtree_->SearchHybrid(vt, search_param.radius_,
+                search_param.max_nn_, point_idx, point_squared_distance) >= 3) {
+            // approximate image gradient of vt's tangential plane
+            size_t nn = point_idx.size();
+            Eigen::MatrixXd A(nn, 3);
+            Eigen::MatrixXd b(nn, 1);
+            A.setZero();
+            b.setZero();
+            for (size_t i = 1; i < nn; i++) {
+                int32_t P_adj_idx = point_idx[i];
+                Eigen::Vector3d vt_adj = target.points_[P_adj_idx];
+                Eigen::Vector3d vt_proj =
+                        vt_adj - (vt_adj - vt).dot(nt) * nt;
+                double it_adj = (target.colors_[P_adj_idx](0)
+                        + target.colors_[P_adj_idx](1)
+                        + target.colors_[P_adj_idx](2)) / 3.0;
+                A(i - 1, 0) = (vt_proj(0) - vt(0));
+                A(i - 1, 1) = (vt_proj(1) - vt(1));
+                A(i - 1, 2) = (vt_proj(2) - vt(2));
+                b(i - 1, 0) = (it_adj - it);
+            }
+            // adds orthogonal constraint
+            A(nn - 1, 0) = (nn - 1) * nt(0);
+            A(nn - 1, 1) = (nn - 1) * nt(1);
+            A(nn - 1, 2) = (nn - 1) * nt(2);
+            b(nn - 1, 0) = 0;
+            // solving linear equation
+            bool is_success;
+            Eigen::MatrixXd x;
+            std::tie(is_success, x) = SolveLinearSystem(
+                A.transpose() * A, A.transpose() * b);
+            if (is_success) {
+                color_gradients_[k] = x;
+            }
+        }
+    }
+    return true;
+}
+
+bool RegistrationTarget::HasColorGradients() const
+{
+    return pointcloud_->points_.size() > 0 &&
+            color_gradients_.size() == pointcloud_->points_.size();
+}
+
+MultiScaleICPTarget::MultiScaleICPTarget(const PointCloud &target,
+        const std::vector<double> &voxel_sizes) : voxel_sizes_(voxel_sizes),
+        levels_(voxel_sizes.size())
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t i = 0; i < static_cast<int32_t>(voxel_sizes_.size()); i++) {
+        if (voxel_sizes_[i] > 0.0) {
+            levels_[i] = std::make_shared<RegistrationTarget>(
+                    *VoxelDownSample(target, voxel_sizes_[i]));
+        } else {
+            levels_[i] = std::make_shared<RegistrationTarget>(target);
+        }
+    }
+}
+
+MultiScaleICPTarget::~MultiScaleICPTarget()
+{
+}
+
+RegistrationResult RegistrationMultiScaleICP(const PointCloud &source,
+        const MultiScaleICPTarget &target,
+        const std::vector<double> &max_correspondence_distances,
+        const Eigen::Matrix4d &init/* = Eigen::Matrix4d::Identity()*/,
+        const TransformationEstimation &estimation
+        /* = TransformationEstimationPointToPoint(false)*/,
+        const std::vector<ICPConvergenceCriteria> &criteria/* = {}*/)
+{
+    size_t num_levels = target.NumberOfLevels();
+    if (num_levels == 0 ||
+            max_correspondence_distances.size() != num_levels ||
+            (!criteria.empty() && criteria.size() != num_levels)) {
+        PrintWarning("[RegistrationMultiScaleICP] Number of levels does not match.\n");
+        return RegistrationResult(init);
+    }
+
+    std::vector<std::shared_ptr<PointCloud>> source_levels(num_levels);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (int32_t i = 0; i < static_cast<int32_t>(num_levels); i++) {
+        if (target.voxel_sizes_[i] > 0.0) {
+            source_levels[i] = VoxelDownSample(source, target.voxel_sizes_[i]);
+        }
+    }
+
+    RegistrationResult result(init);
+    for (size_t i = 0; i < num_levels; i++) {
+        PrintDebug("Multi-scale ICP level #%d: voxel size %.4f\n", (int)i,
+                target.voxel_sizes_[i]);
+        const PointCloud &source_level = source_levels[i] ?
+                *source_levels[i] : source;
+        result = RegistrationICP(source_level, *target.levels_[i],
+                max_correspondence_distances[i], result.transformation_,
+                estimation, criteria.empty() ? ICPConvergenceCriteria() :
+                criteria[i]);
+    }
+    return result;
+}
+
+RegistrationResult RegistrationMultiScaleICP(const PointCloud &source,
+        const PointCloud &target, const std::vector<double> &voxel_sizes,
+        const std::vector<double> &max_correspondence_distances,
+        const Eigen::Matrix4d &init/* = Eigen::Matrix4d::Identity()*/,
+        const TransformationEstimation &estimation
+        /* = TransformationEstimationPointToPoint(false)*/,
+        const std::vector<ICPConvergenceCriteria> &criteria/* = {}*/)
+{
+    MultiScaleICPTarget target_levels(target, voxel_sizes);
+    return RegistrationMultiScaleICP(source, target_levels,
+            max_correspondence_distances, init, estimation, criteria);
+}
+
 RegistrationResult RegistrationRANSACBasedOnCorrespondence(
         const PointCloud &source, const PointCloud &target,
         const CorrespondenceSet &corres, double max_correspondence_distance,
@@ -201,9 +596,7 @@ RegistrationResult RegistrationRANSACBasedOnCorrespondence(
         }
         transformation = estimation.ComputeTransformation(source,
                 target, ransac_corres);
-        PointCloud pcd = source;
-        pcd.Transform(transformation);
-        auto this_result = EvaluateRANSACBasedOnCorrespondence(pcd, target,
+        auto this_result = EvaluateRANSACBasedOnCorrespondence(source, target,
                 corres, max_correspondence_distance, transformation);
         if (this_result.fitness_ > result.fitness_ ||
                 (this_result.fitness_ == result.fitness_ &&
@@ -225,9 +618,12 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
         size_t ransac_n/* = 4*/, const std::vector<std::reference_wrapper<const
         CorrespondenceChecker>> &checkers/* = {}*/,
         const RANSACConvergenceCriteria &criteria
-        /* = RANSACConvergenceCriteria()*/)
+        /* = RANSACConvergenceCriteria()*/,
+        const RANSACValidationOption &validation
+        /* = RANSACValidationOption()*/)
 {
-    if (ransac_n < 3 || max_correspondence_distance <= 0.0) {
+    if (ransac_n < 3 || max_correspondence_distance <= 0.0 ||
+            source.points_.empty()) {
         return RegistrationResult();
     }
 
@@ -236,24 +632,55 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
     bool finished_validation = false;
     int32_t num_similar_features = 1;
     std::vector<std::vector<int32_t>> similar_features(source.points_.size());
+    KDTreeFlann kdtree(target);
+    KDTreeFlann kdtree_feature(target_feature);
+
+    // In staged validation mode, hypotheses are prescored against a set of
+    // feature correspondences, and only the best candidates are validated
+    // against the whole point cloud.
+    CorrespondenceSet prescore_corres;
+    std::vector<RegistrationResult> candidates;
+    const uint32_t seed = validation.seed_ < 0 ?
+            static_cast<uint32_t>(std::time(0)) :
+            static_cast<uint32_t>(validation.seed_);
+    if (validation.staged_validation_) {
+        std::mt19937 generator(seed);
+        std::vector<int32_t> samples = SampleIndices(source.points_.size(),
+                validation.prescore_sample_size_, generator);
+        prescore_corres.resize(samples.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int32_t i = 0; i < static_cast<int32_t>(samples.size()); i++) {
+            std::vector<int32_t> indices(num_similar_features);
+            std::vector<double> dists(num_similar_features);
+            kdtree_feature.SearchKNN(Eigen::VectorXd(
+                    source_feature.data_.col(samples[i])),
+                    num_similar_features, indices, dists);
+            prescore_corres[i] = Eigen::Vector2i(samples[i], indices[0]);
+            // each sample is a distinct source point, no race here
+            similar_features[samples[i]] = indices;
+        }
+    }
 
 #ifdef _OPENMP
 #pragma omp parallel
 {
 #endif
     CorrespondenceSet ransac_corres(ransac_n);
-    KDTreeFlann kdtree(target);
-    KDTreeFlann kdtree_feature(target_feature);
     RegistrationResult result_private;
-    uint32_t seed_number;
+    std::vector<RegistrationResult> candidates_private;
+    uint32_t thread_num = 0;
 #ifdef _OPENMP
-        // each thread has different seed_number
-    seed_number = static_cast<unsigned long>(std::time(0)) *
-            (omp_get_thread_num() + 1);
-#else
-    seed_number = static_cast<unsigned long>(std::time(0));
+    thread_num = static_cast<uint32_t>(omp_get_thread_num());
 #endif
-    std::srand(seed_number);
+    // each thread has its own generator
+    std::seed_seq seed_sequence{seed, thread_num};
+    std::mt19937 generator(seed_sequence);
+    std::uniform_int_distribution<int32_t> source_distribution(0,
+            static_cast<int32_t>(source.points_.size()) - 1);
+    std::uniform_int_distribution<int32_t> feature_distribution(0,
+            num_similar_features - 1);
 
 #ifdef _OPENMP
 #pragma omp for nowait
@@ -264,7 +691,7 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
             std::vector<double> dists(num_similar_features);
             Eigen::Matrix4d transformation;
             for (size_t j = 0; j < ransac_n; j++) {
-                uint32_t source_sample_id = std::rand() % source.points_.size();
+                int32_t source_sample_id = source_distribution(generator);
                 if (similar_features[source_sample_id].empty()) {
                     std::vector<int32_t> indices(num_similar_features);
                     kdtree_feature.SearchKNN(Eigen::VectorXd(
@@ -282,7 +709,7 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
                     ransac_corres[j](1) = similar_features[source_sample_id][0];
                 else
                     ransac_corres[j](1) = similar_features[source_sample_id]
-                            [std::rand() % num_similar_features];
+                            [feature_distribution(generator)];
             }
             bool check = true;
             for (const auto &checker : checkers) {
@@ -306,15 +733,19 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
                 }
             }
             if (check == false) continue;
-            PointCloud pcd = source;
-            pcd.Transform(transformation);
-            auto this_result = GetRegistrationResultAndCorrespondences(
-                    pcd, target, kdtree, max_correspondence_distance,
-                    transformation);
-            if (this_result.fitness_ > result_private.fitness_ ||
-                    (this_result.fitness_ == result_private.fitness_ &&
-                    this_result.inlier_rmse_ < result_private.inlier_rmse_)) {
-                result_private = this_result;
+            if (validation.staged_validation_) {
+                auto this_result = EvaluateRANSACBasedOnCorrespondence(source,
+                        target, prescore_corres, max_correspondence_distance,
+                        transformation);
+                InsertRegistrationCandidate(candidates_private, this_result,
+                        validation.max_dense_validation_);
+            } else {
+                auto this_result = EvaluateRegistrationWithKDTree(source,
+                        target, kdtree, max_correspondence_distance,
+                        transformation);
+                if (IsBetterRegistrationResult(this_result, result_private)) {
+                    result_private = this_result;
+                }
             }
 #ifdef _OPENMP
 #pragma omp critical
@@ -330,16 +761,48 @@ RegistrationResult RegistrationRANSACBasedOnFeatureMatching(
 #pragma omp critical
 #endif
     {
-        if (result_private.fitness_ > result.fitness_ ||
-            (result_private.fitness_ == result.fitness_ &&
-                result_private.inlier_rmse_ < result.inlier_rmse_)) {
+        if (IsBetterRegistrationResult(result_private, result)) {
             result = result_private;
         }
+        for (const auto &candidate : candidates_private) {
+            InsertRegistrationCandidate(candidates, candidate,
+                    validation.max_dense_validation_);
+        }
     }
 #ifdef _OPENMP
 }
 #endif
     PrintDebug("total_validation : %d\n", total_validation);
+
+    if (validation.staged_validation_ && !candidates.empty()) {
+        PrintDebug("RANSAC prescore: Fitness %.4f, RMSE %.4f\n",
+                candidates[0].fitness_, candidates[0].inlier_rmse_);
+        for (const auto &candidate : candidates) {
+            auto this_result = EvaluateRegistrationWithKDTree(source,
+                    target, kdtree, max_correspondence_distance,
+                    candidate.transformation_);
+            if (IsBetterRegistrationResult(this_result, result)) {
+                result = this_result;
+            }
+        }
+        PrintDebug("total_dense_validation : %d\n", (int)candidates.size());
+        if (result.fitness_ > 0.0 && validation.refine_iteration_ > 0) {
+            PointCloud pcd = source;
+            pcd.Transform(result.transformation_);
+            for (uint32_t i = 0; i < validation.refine_iteration_; i++) {
+                Eigen::Matrix4d update = estimation.ComputeTransformation(
+                        pcd, target, result.correspondence_set_);
+                pcd.Transform(update);
+                auto this_result = GetRegistrationResultAndCorrespondences(
+                        pcd, target, kdtree, max_correspondence_distance,
+                        update * result.transformation_);
+                if (!IsBetterRegistrationResult(this_result, result)) {
+                    break;
+                }
+                result = this_result;
+            }
+        }
+    }
     PrintDebug("RANSAC: Fitness %.4f, RMSE %.4f\n", result.fitness_,
             result.inlier_rmse_);
     return result;
@@ -350,55 +813,18 @@ Eigen::Matrix6d GetInformationMatrixFromPointClouds(
         double max_correspondence_distance,
         const Eigen::Matrix4d &transformation)
 {
-    RegistrationResult result;
     KDTreeFlann target_kdtree(target);
-    result = GetRegistrationResultAndCorrespondences(source, target,
-            target_kdtree, max_correspondence_distance, transformation);
+    return GetInformationMatrixWithKDTree(source, target, target_kdtree,
+            max_correspondence_distance, transformation);
+}
 
-    // write q^*
-    // see http://redwood-data.org/indoor/registration.html
-    // note: I comes first in this implementation
-    Eigen::Matrix6d GTG = Eigen::Matrix6d::Identity();
-#ifdef _OPENMP
-#pragma omp parallel
-    {
-#endif
-        Eigen::Matrix6d GTG_private = Eigen::Matrix6d::Identity();
-        Eigen::Vector6d G_r_private = Eigen::Vector6d::Zero();
-#ifdef _OPENMP
-#pragma omp parallel for schedule(static)
-#endif
-        for (int32_t c = 0; c < static_cast<int32_t>(result.correspondence_set_.size()); c++) {
-            int32_t t = result.correspondence_set_[c](1);
-            double x = target.points_[t](0);
-            double y = target.points_[t](1);
-            double z = target.points_[t](2);
-            G_r_private.setZero();
-            G_r_private(0) = 1.0;
-            G_r_private(4) = z;
-            G_r_private(5) = -y;
-            GTG_private.noalias() += G_r_private * G_r_private.transpose();
-            G_r_private.setZero();
-            G_r_private(1) = 1.0;
-            G_r_private(3) = -z;
-            G_r_private(5) = x;
-            GTG_private.noalias() += G_r_private * G_r_private.transpose();
-            G_r_private.setZero();
-            G_r_private(2) = 1.0;
-            G_r_private(3) = y;
-            G_r_private(4) = -x;
-            GTG_private.noalias() += G_r_private * G_r_private.transpose();
-        }
-#ifdef _OPENMP
-#pragma omp critical
-#endif
-        {
-            GTG += GTG_private;
-        }
-#ifdef _OPENMP
-    }
-#endif
-    return std::move(GTG);
+Eigen::Matrix6d GetInformationMatrixFromPointClouds(
+        const PointCloud &source, const RegistrationTarget &target,
+        double max_correspondence_distance,
+        const Eigen::Matrix4d &transformation)
+{
+    return GetInformationMatrixWithKDTree(source, *target.pointcloud_,
+            *target.kdtree_, max_correspondence_distance, transformation);
 }
 
 }   // namespace open3d
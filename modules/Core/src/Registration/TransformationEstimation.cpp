@@ -28,6 +28,7 @@
 #include <Open3D/Core/Registration/TransformationEstimation.h>
 
 #include <Eigen/Geometry>
+#include <Eigen/SVD>
 #include <Open3D/Core/Geometry/PointCloud.h>
 #include <Open3D/Core/Utility/Eigen.h>
 
@@ -59,6 +60,64 @@ Eigen::Matrix4d TransformationEstimationPointToPoint::ComputeTransformation(
     return Eigen::umeyama(source_mat, target_mat, with_scaling_);
 }
 
+// Statistics of point to point estimation: number of correspondences, sum of
+// source points, sum of target points, sum of target * source^T (column
+// major), and sum of squared norms of source points. They are the moments
+// needed by the Umeyama method.
+size_t TransformationEstimationPointToPoint::GetFusedStatisticsSize() const
+{
+    return 17;
+}
+
+void TransformationEstimationPointToPoint::AccumulateFusedStatistics(
+        const PointCloud &/*source*/, int32_t /*source_index*/,
+        const Eigen::Vector3d &source_point, const PointCloud &target,
+        int32_t target_index, Eigen::VectorXd &statistics) const
+{
+    const Eigen::Vector3d &target_point = target.points_[target_index];
+    statistics(0) += 1.0;
+    statistics.segment<3>(1) += source_point;
+    statistics.segment<3>(4) += target_point;
+    Eigen::Map<Eigen::Matrix3d>(statistics.data() + 7).noalias() +=
+            target_point * source_point.transpose();
+    statistics(16) += source_point.squaredNorm();
+}
+
+Eigen::Matrix4d
+        TransformationEstimationPointToPoint::ComputeTransformationFromFusedStatistics(
+        const Eigen::VectorXd &statistics) const
+{
+    if (statistics(0) <= 0.0) return Eigen::Matrix4d::Identity();
+    double one_over_n = 1.0 / statistics(0);
+    const Eigen::Vector3d source_mean = statistics.segment<3>(1) * one_over_n;
+    const Eigen::Vector3d target_mean = statistics.segment<3>(4) * one_over_n;
+    const Eigen::Matrix3d sigma = Eigen::Map<const Eigen::Matrix3d>(
+            statistics.data() + 7) * one_over_n -
+            target_mean * source_mean.transpose();
+
+    // same as Eigen::umeyama(), written with the accumulated moments
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(sigma,
+            Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::Vector3d S = Eigen::Vector3d::Ones();
+    if (svd.matrixU().determinant() * svd.matrixV().determinant() < 0) {
+        S(2) = -1;
+    }
+    Eigen::Matrix4d transformation = Eigen::Matrix4d::Identity();
+    Eigen::Matrix3d R = svd.matrixU() * S.asDiagonal() *
+            svd.matrixV().transpose();
+    if (with_scaling_) {
+        double source_var = statistics(16) * one_over_n -
+                source_mean.squaredNorm();
+        double c = 1.0 / source_var * svd.singularValues().dot(S);
+        transformation.block<3, 1>(0, 3) = target_mean - c * R * source_mean;
+        transformation.block<3, 3>(0, 0) = c * R;
+    } else {
+        transformation.block<3, 1>(0, 3) = target_mean - R * source_mean;
+        transformation.block<3, 3>(0, 0) = R;
+    }
+    return transformation;
+}
+
 double TransformationEstimationPointToPlane::ComputeRMSE(
         const PointCloud &source, const PointCloud &target,
         const CorrespondenceSet &corres) const
@@ -103,4 +162,40 @@ Eigen::Matrix4d TransformationEstimationPointToPlane::ComputeTransformation(
     return is_success ? extrinsic : Eigen::Matrix4d::Identity();
 }
 
+// Statistics of point to plane estimation: JTJ (column major) and JTr.
+size_t TransformationEstimationPointToPlane::GetFusedStatisticsSize() const
+{
+    return 42;
+}
+
+void TransformationEstimationPointToPlane::AccumulateFusedStatistics(
+        const PointCloud &/*source*/, int32_t /*source_index*/,
+        const Eigen::Vector3d &source_point, const PointCloud &target,
+        int32_t target_index, Eigen::VectorXd &statistics) const
+{
+    if (target.HasNormals() == false) return;
+    const Eigen::Vector3d &vt = target.points_[target_index];
+    const Eigen::Vector3d &nt = target.normals_[target_index];
+    Eigen::Vector6d J_r;
+    double r = (source_point - vt).dot(nt);
+    J_r.block<3, 1>(0, 0) = source_point.cross(nt);
+    J_r.block<3, 1>(3, 0) = nt;
+    Eigen::Map<Eigen::Matrix6d>(statistics.data()).noalias() +=
+            J_r * J_r.transpose();
+    statistics.segment<6>(36) += J_r * r;
+}
+
+Eigen::Matrix4d
+        TransformationEstimationPointToPlane::ComputeTransformationFromFusedStatistics(
+        const Eigen::VectorXd &statistics) const
+{
+    bool is_success;
+    Eigen::Matrix4d extrinsic;
+    std::tie(is_success, extrinsic) =
+            SolveJacobianSystemAndObtainExtrinsicMatrix(
+            Eigen::Map<const Eigen::Matrix6d>(statistics.data()),
+            statistics.segment<6>(36));
+    return is_success ? extrinsic : Eigen::Matrix4d::Identity();
+}
+
 }   // namespace open3d
@@ -175,6 +175,24 @@ bool RemoveFile(const std::string &filename)
     return (std::remove(filename.c_str()) == 0);
 }
 
+bool SeekFile(std::FILE *file, int64_t offset)
+{
+#ifdef WINDOWS
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+int64_t TellFile(std::FILE *file)
+{
+#ifdef WINDOWS
+    return _ftelli64(file);
+#else
+    return static_cast<int64_t>(ftello(file));
+#endif
+}
+
 bool ListFilesInDirectory(const std::string &directory,
     std::vector<std::string> &filenames)
 {
@@ -56,4 +56,15 @@ bool ReadPinholeCameraTrajectoryFromLOG(const std::string &filename,
 bool WritePinholeCameraTrajectoryToLOG(const std::string &filename,
         const PinholeCameraTrajectory &trajectory);
 
+bool ReadPinholeCameraTrajectoryFromBIN(const std::string &filename,
+        PinholeCameraTrajectory &trajectory);
+
+bool WritePinholeCameraTrajectoryToBIN(const std::string &filename,
+        const PinholeCameraTrajectory &trajectory);
+
+/// Function to append the extrinsics of trajectory to a BIN file
+/// The file is created with the intrinsic of trajectory if it does not exist.
+bool AppendPinholeCameraTrajectoryToBIN(const std::string &filename,
+        const PinholeCameraTrajectory &trajectory);
+
 }   // namespace open3d
@@ -48,4 +48,15 @@ bool ReadPoseGraph(const std::string &filename, PoseGraph &pose_graph);
 /// \return return true if the write function is successful, false otherwise.
 bool WritePoseGraph(const std::string &filename, const PoseGraph &pose_graph);
 
+bool ReadPoseGraphFromBIN(const std::string &filename, PoseGraph &pose_graph);
+
+bool WritePoseGraphToBIN(const std::string &filename,
+        const PoseGraph &pose_graph);
+
+/// Function to append the nodes and edges of pose_graph to a BIN file
+/// The file is created if it does not exist. Node ids in the edges refer to
+/// the whole graph stored in the file.
+bool AppendPoseGraphToBIN(const std::string &filename,
+        const PoseGraph &pose_graph);
+
 }   // namespace open3d
@@ -0,0 +1,74 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <Open3D/Core/Integration/UniformTSDFVolume.h>
+#include <Open3D/Core/Integration/ScalableTSDFVolume.h>
+
+namespace open3d {
+
+/// Factory function to create a UniformTSDFVolume from a file
+/// \return return NULL if the file cannot be read.
+std::shared_ptr<UniformTSDFVolume> CreateUniformTSDFVolumeFromFile(
+        const std::string &filename);
+
+/// Factory function to create a ScalableTSDFVolume from a file
+/// The volume holds all volume units in memory and does not stream.
+/// \return return NULL if the file cannot be read.
+std::shared_ptr<ScalableTSDFVolume> CreateScalableTSDFVolumeFromFile(
+        const std::string &filename);
+
+/// The general entrance for writing a UniformTSDFVolume to a file
+/// The file is replaced only after it is completely written, so that a
+/// failed checkpoint leaves the previous one intact.
+/// \return If the write function is successful.
+bool WriteUniformTSDFVolume(const std::string &filename,
+        const UniformTSDFVolume &volume);
+
+/// The general entrance for writing a ScalableTSDFVolume to a file
+/// The units in the block store of a streaming volume are written as well.
+/// \return If the write function is successful.
+bool WriteScalableTSDFVolume(const std::string &filename,
+        const ScalableTSDFVolume &volume);
+
+std::shared_ptr<UniformTSDFVolume> CreateUniformTSDFVolumeFromBIN(
+        const std::string &filename);
+
+bool WriteUniformTSDFVolumeToBIN(const std::string &filename,
+        const UniformTSDFVolume &volume);
+
+std::shared_ptr<ScalableTSDFVolume> CreateScalableTSDFVolumeFromBIN(
+        const std::string &filename);
+
+bool WriteScalableTSDFVolumeToBIN(const std::string &filename,
+        const ScalableTSDFVolume &volume);
+
+}   // namespace open3d
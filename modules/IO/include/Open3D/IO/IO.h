@@ -34,3 +34,4 @@
 #include "ClassIO/IJsonConvertibleIO.h"
 #include "ClassIO/FeatureIO.h"
 #include "ClassIO/PoseGraphIO.h"
+#include "ClassIO/TSDFVolumeIO.h"
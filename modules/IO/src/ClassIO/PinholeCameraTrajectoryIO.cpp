@@ -53,6 +53,7 @@ static const std::unordered_map<std::string,
         file_extension_to_trajectory_read_function
         {{"log", ReadPinholeCameraTrajectoryFromLOG},
         {"json", ReadPinholeCameraTrajectoryFromJSON},
+        {"bin", ReadPinholeCameraTrajectoryFromBIN},
         };
 
 static const std::unordered_map<std::string,
@@ -61,6 +62,7 @@ static const std::unordered_map<std::string,
         file_extension_to_trajectory_write_function
         {{"log", WritePinholeCameraTrajectoryToLOG},
         {"json", WritePinholeCameraTrajectoryToJSON},
+        {"bin", WritePinholeCameraTrajectoryToBIN},
         };
 
 }   // unnamed namespace
@@ -52,6 +52,7 @@ static const std::unordered_map<std::string,
         std::function<bool(const std::string &, PoseGraph &)>>
         file_extension_to_pose_graph_read_function
         {{"json", ReadPoseGraphFromJSON},
+        {"bin", ReadPoseGraphFromBIN},
         };
 
 static const std::unordered_map<std::string,
@@ -59,6 +60,7 @@ static const std::unordered_map<std::string,
         const PoseGraph &)>>
         file_extension_to_pose_graph_write_function
         {{"json", WritePoseGraphToJSON},
+        {"bin", WritePoseGraphToBIN},
         };
 
 }   // unnamed namespace
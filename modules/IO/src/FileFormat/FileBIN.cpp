@@ -26,10 +26,69 @@
 // ----------------------------------------------------------------------------
 
 #include <Open3D/IO/ClassIO/FeatureIO.h>
+#include <Open3D/IO/ClassIO/PoseGraphIO.h>
+#include <Open3D/IO/ClassIO/PinholeCameraTrajectoryIO.h>
+#include <Open3D/IO/ClassIO/TSDFVolumeIO.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <memory>
+#include <vector>
+#include <functional>
+#ifndef WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+#include <liblzf/lzf.h>
 #include <Open3D/Core/Utility/Console.h>
+#include <Open3D/Core/Utility/FileSystem.h>
+
+// The BIN format of PoseGraph and PinholeCameraTrajectory is little-endian.
+// A 16-byte header (8-byte magic, uint32 version, uint32 reserved) is followed
+// by any number of chunks. A chunk has a 16-byte header (uint32 type, uint32
+// record size, uint64 record count) followed by fixed-size records, so that
+// records can be appended as new chunks and read directly from a memory map.
+// Readers skip unknown chunk types, and only read the known prefix of records
+// that are larger than expected.
+//
+// PoseGraph, magic "O3DPGRPH":
+//     chunk 1, nodes (128 bytes): pose, 16 doubles in column-major order
+//     chunk 2, edges (440 bytes): int32 source_node_id, int32 target_node_id,
+//         int32 uncertain, int32 reserved, transformation (16 doubles),
+//         information (36 doubles), double confidence
+// PinholeCameraTrajectory, magic "O3DTRAJC":
+//     chunk 1, intrinsic (80 bytes): int32 width, int32 height,
+//         intrinsic matrix (9 doubles); the last one read is used
+//     chunk 2, extrinsics (128 bytes): 16 doubles in column-major order
+//
+// The TSDF volumes are stored as blocks of block_bytes raw bytes, each
+// compressed with LZF on its own, so that a reader can map the file and
+// decompress any block in place. A block that does not compress is stored
+// raw, i.e. with size block_bytes. The data of every block starts at an
+// 8-byte aligned offset.
+// UniformTSDFVolume, magic "O3DUTSDF":
+//     chunk 1, parameters (64 bytes): double length, double sdf_trunc,
+//         origin (3 doubles), uint32 resolution, int32 with_color,
+//         uint64 block_bytes
+//     chunk 2, block table (24 bytes): int32 x, int32 reserved (2),
+//         uint32 size, uint64 offset from the start of chunk 3
+//     chunk 3, block data (1 byte)
+//     Block x holds the voxels of slice x: resolution^2 tsdf floats, as many
+//     weight floats, and 3 * resolution^2 color floats if with_color.
+// ScalableTSDFVolume, magic "O3DSTSDF":
+//     chunk 1, parameters (64 bytes): double voxel_length, double sdf_trunc,
+//         int32 with_color, int32 volume_unit_resolution,
+//         int32 depth_sampling_stride, int32 voxel_format, uint64 block_bytes
+//     chunk 2, block table (24 bytes): volume unit index (3 int32),
+//         uint32 size, uint64 offset from the start of chunk 3
+//     chunk 3, block data (1 byte)
+//     A block holds the voxels of a volume unit in the layout of
+//     ScalableTSDFVolume::volume_units_.
 
 namespace open3d {
 
@@ -54,6 +113,365 @@ bool ReadMatrixXdFromBINFile(FILE *file, Eigen::MatrixXd &mat)
     return true;
 }
 
+const uint32_t BIN_VERSION = 1;
+const size_t BIN_HEADER_SIZE = 16;
+const size_t BIN_CHUNK_HEADER_SIZE = 16;
+const char POSE_GRAPH_BIN_MAGIC[8] = {'O', '3', 'D', 'P', 'G', 'R', 'P', 'H'};
+const char TRAJECTORY_BIN_MAGIC[8] = {'O', '3', 'D', 'T', 'R', 'A', 'J', 'C'};
+const uint32_t POSE_GRAPH_NODE_CHUNK = 1;
+const uint32_t POSE_GRAPH_EDGE_CHUNK = 2;
+const uint32_t POSE_GRAPH_NODE_RECORD_SIZE = 128;
+const uint32_t POSE_GRAPH_EDGE_RECORD_SIZE = 440;
+const uint32_t TRAJECTORY_INTRINSIC_CHUNK = 1;
+const uint32_t TRAJECTORY_EXTRINSIC_CHUNK = 2;
+const uint32_t TRAJECTORY_INTRINSIC_RECORD_SIZE = 80;
+const uint32_t TRAJECTORY_EXTRINSIC_RECORD_SIZE = 128;
+const char UNIFORM_TSDF_BIN_MAGIC[8] = {'O', '3', 'D', 'U', 'T', 'S', 'D', 'F'};
+const char SCALABLE_TSDF_BIN_MAGIC[8] = {'O', '3', 'D', 'S', 'T', 'S', 'D', 'F'};
+const uint32_t TSDF_PARAMETER_CHUNK = 1;
+const uint32_t TSDF_BLOCK_TABLE_CHUNK = 2;
+const uint32_t TSDF_BLOCK_DATA_CHUNK = 3;
+const uint32_t TSDF_PARAMETER_RECORD_SIZE = 64;
+const uint32_t TSDF_BLOCK_TABLE_RECORD_SIZE = 24;
+// Raw bytes of the blocks compressed in parallel before they are written
+const size_t TSDF_WRITE_BATCH_BYTES = 64 * 1024 * 1024;
+
+bool IsLittleEndianHost()
+{
+    const uint32_t one = 1;
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+bool TruncateBINFile(FILE *file, uint64_t size)
+{
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef WINDOWS
+    return _chsize_s(_fileno(file), static_cast<int64_t>(size)) == 0;
+#else
+    return ftruncate(fileno(file), static_cast<off_t>(size)) == 0;
+#endif
+}
+
+/// Read-only view of a whole file. The file is memory-mapped when the
+/// platform supports it, and read into a buffer otherwise.
+class BINFileView
+{
+public:
+    BINFileView() : data_(NULL), size_(0), mapped_(false) {}
+    ~BINFileView() {
+#ifndef WINDOWS
+        if (mapped_) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+#endif
+    }
+    BINFileView(const BINFileView &) = delete;
+    BINFileView &operator=(const BINFileView &) = delete;
+
+public:
+    bool Open(const std::string &filename) {
+#ifndef WINDOWS
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+                    fd, 0);
+            if (ptr != MAP_FAILED) {
+                data_ = static_cast<const char *>(ptr);
+                size_ = (size_t)st.st_size;
+                mapped_ = true;
+                close(fd);
+                return true;
+            }
+        }
+        close(fd);
+#endif
+        FILE *file = fopen(filename.c_str(), "rb");
+        if (file == NULL) {
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        int64_t size = filesystem::TellFile(file);
+        filesystem::SeekFile(file, 0);
+        buffer_.resize(size > 0 ? (size_t)size : 0);
+        size_t read_size = fread(buffer_.data(), 1, buffer_.size(), file);
+        fclose(file);
+        data_ = buffer_.data();
+        size_ = read_size;
+        return true;
+    }
+
+public:
+    const char *data_;
+    size_t size_;
+
+private:
+    bool mapped_;
+    std::vector<char> buffer_;
+};
+
+bool CheckBINHeader(const char *data, size_t size, const char *magic)
+{
+    if (size < BIN_HEADER_SIZE || memcmp(data, magic, 8) != 0) {
+        return false;
+    }
+    uint32_t version;
+    memcpy(&version, data + 8, sizeof(uint32_t));
+    if (version > BIN_VERSION) {
+        PrintWarning("Read BIN: file version %d is newer than %d, reading known fields only.\n",
+                version, BIN_VERSION);
+    }
+    return true;
+}
+
+/// Function to visit every chunk of a BIN file
+/// The callback receives the chunk type, the record size, the number of
+/// complete records and a pointer to the first record.
+bool ReadBINChunks(const std::string &filename, const char *magic,
+        const std::function<bool(uint32_t, uint32_t, uint64_t,
+        const char *)> &callback)
+{
+    if (!IsLittleEndianHost()) {
+        PrintWarning("Read BIN failed: big-endian hosts are not supported.\n");
+        return false;
+    }
+    BINFileView view;
+    if (!view.Open(filename)) {
+        PrintWarning("Read BIN failed: unable to open file: %s\n",
+                filename.c_str());
+        return false;
+    }
+    if (!CheckBINHeader(view.data_, view.size_, magic)) {
+        PrintWarning("Read BIN failed: unrecognized file header.\n");
+        return false;
+    }
+    size_t offset = BIN_HEADER_SIZE;
+    while (offset + BIN_CHUNK_HEADER_SIZE <= view.size_) {
+        uint32_t type, record_size;
+        uint64_t count;
+        memcpy(&type, view.data_ + offset, sizeof(uint32_t));
+        memcpy(&record_size, view.data_ + offset + 4, sizeof(uint32_t));
+        memcpy(&count, view.data_ + offset + 8, sizeof(uint64_t));
+        offset += BIN_CHUNK_HEADER_SIZE;
+        if (record_size == 0) {
+            PrintWarning("Read BIN failed: corrupted chunk.\n");
+            return false;
+        }
+        uint64_t available = (view.size_ - offset) / record_size;
+        if (count > available) {
+            // The last chunk of an interrupted append
+            PrintWarning("Read BIN: file is truncated, %d of %d records read.\n",
+                    (int)available, (int)count);
+            return callback(type, record_size, available,
+                    view.data_ + offset);
+        }
+        if (!callback(type, record_size, count, view.data_ + offset)) {
+            return false;
+        }
+        offset += count * record_size;
+    }
+    return true;
+}
+
+/// Function to cut the last chunk of an interrupted append back to its
+/// complete records, so that chunks appended later are not read as part of it
+bool RepairBINFileTail(const std::string &filename)
+{
+    uint64_t end, count_offset = 0, complete_count = 0;
+    {
+        BINFileView view;
+        if (!view.Open(filename)) {
+            PrintWarning("Write BIN failed: unable to open file: %s\n",
+                    filename.c_str());
+            return false;
+        }
+        size_t offset = BIN_HEADER_SIZE;
+        end = view.size_;
+        while (offset < view.size_) {
+            if (offset + BIN_CHUNK_HEADER_SIZE > view.size_) {
+                end = offset;
+                break;
+            }
+            uint32_t record_size;
+            uint64_t count;
+            memcpy(&record_size, view.data_ + offset + 4, sizeof(uint32_t));
+            memcpy(&count, view.data_ + offset + 8, sizeof(uint64_t));
+            if (record_size == 0) {
+                PrintWarning("Write BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            uint64_t available = (view.size_ - offset -
+                    BIN_CHUNK_HEADER_SIZE) / record_size;
+            if (count > available) {
+                if (available == 0) {
+                    end = offset;
+                } else {
+                    count_offset = offset + 8;
+                    complete_count = available;
+                    end = offset + BIN_CHUNK_HEADER_SIZE +
+                            available * record_size;
+                }
+                break;
+            }
+            offset += BIN_CHUNK_HEADER_SIZE + count * record_size;
+        }
+        if (end == view.size_) {
+            return true;
+        }
+    }
+    PrintWarning("Write BIN: %s is truncated, cutting back its incomplete last chunk.\n",
+            filename.c_str());
+    FILE *file = fopen(filename.c_str(), "r+b");
+    if (file == NULL) {
+        PrintWarning("Write BIN failed: unable to open file: %s\n",
+                filename.c_str());
+        return false;
+    }
+    bool success = true;
+    if (complete_count > 0) {
+        success = filesystem::SeekFile(file, (int64_t)count_offset) &&
+                fwrite(&complete_count, sizeof(uint64_t), 1, file) == 1;
+    }
+    success = success && TruncateBINFile(file, end);
+    if (fclose(file) != 0) {
+        success = false;
+    }
+    if (!success) {
+        PrintWarning("Write BIN failed: unexpected error.\n");
+    }
+    return success;
+}
+
+/// Function to open a BIN file for appending chunks
+/// A new file with a header is created if the file does not exist. An
+/// incomplete last chunk of an existing file is cut back first.
+/// \param created is set to true if a new file is created.
+FILE *OpenBINFileForAppend(const std::string &filename, const char *magic,
+        bool truncate, bool &created)
+{
+    if (!IsLittleEndianHost()) {
+        PrintWarning("Write BIN failed: big-endian hosts are not supported.\n");
+        return NULL;
+    }
+    created = truncate;
+    if (!truncate) {
+        FILE *file = fopen(filename.c_str(), "rb");
+        if (file == NULL) {
+            created = true;
+        } else {
+            char header[BIN_HEADER_SIZE];
+            bool valid = fread(header, 1, BIN_HEADER_SIZE, file) ==
+                    BIN_HEADER_SIZE && memcmp(header, magic, 8) == 0;
+            fclose(file);
+            if (!valid) {
+                PrintWarning("Write BIN failed: %s is not a BIN file of this type.\n",
+                        filename.c_str());
+                return NULL;
+            }
+            if (!RepairBINFileTail(filename)) {
+                return NULL;
+            }
+        }
+    }
+    FILE *file = fopen(filename.c_str(), created ? "wb" : "ab");
+    if (file == NULL) {
+        PrintWarning("Write BIN failed: unable to open file: %s\n",
+                filename.c_str());
+        return NULL;
+    }
+    if (created) {
+        char header[BIN_HEADER_SIZE];
+        memset(header, 0, BIN_HEADER_SIZE);
+        memcpy(header, magic, 8);
+        memcpy(header + 8, &BIN_VERSION, sizeof(uint32_t));
+        if (fwrite(header, 1, BIN_HEADER_SIZE, file) < BIN_HEADER_SIZE) {
+            PrintWarning("Write BIN failed: unexpected error.\n");
+            fclose(file);
+            return NULL;
+        }
+    }
+    return file;
+}
+
+bool WriteBINChunk(FILE *file, uint32_t type, uint32_t record_size,
+        uint64_t count, const std::vector<char> &records)
+{
+    if (count == 0) {
+        return true;
+    }
+    char header[BIN_CHUNK_HEADER_SIZE];
+    memcpy(header, &type, sizeof(uint32_t));
+    memcpy(header + 4, &record_size, sizeof(uint32_t));
+    memcpy(header + 8, &count, sizeof(uint64_t));
+    if (fwrite(header, 1, BIN_CHUNK_HEADER_SIZE, file) <
+            BIN_CHUNK_HEADER_SIZE || fwrite(records.data(), 1,
+            records.size(), file) < records.size()) {
+        PrintWarning("Write BIN failed: unexpected error.\n");
+        return false;
+    }
+    return true;
+}
+
+bool WritePoseGraphChunksToBINFile(FILE *file, const PoseGraph &pose_graph)
+{
+    std::vector<char> records(pose_graph.nodes_.size() *
+            POSE_GRAPH_NODE_RECORD_SIZE);
+    for (size_t i = 0; i < pose_graph.nodes_.size(); i++) {
+        memcpy(records.data() + i * POSE_GRAPH_NODE_RECORD_SIZE,
+                pose_graph.nodes_[i].pose_.data(), 16 * sizeof(double));
+    }
+    if (!WriteBINChunk(file, POSE_GRAPH_NODE_CHUNK,
+            POSE_GRAPH_NODE_RECORD_SIZE, pose_graph.nodes_.size(), records)) {
+        return false;
+    }
+    records.assign(pose_graph.edges_.size() * POSE_GRAPH_EDGE_RECORD_SIZE, 0);
+    for (size_t i = 0; i < pose_graph.edges_.size(); i++) {
+        const PoseGraphEdge &edge = pose_graph.edges_[i];
+        char *record = records.data() + i * POSE_GRAPH_EDGE_RECORD_SIZE;
+        int32_t ids[4] = {edge.source_node_id_, edge.target_node_id_,
+                edge.uncertain_ ? 1 : 0, 0};
+        memcpy(record, ids, 16);
+        memcpy(record + 16, edge.transformation_.data(), 16 * sizeof(double));
+        memcpy(record + 144, edge.information_.data(), 36 * sizeof(double));
+        memcpy(record + 432, &edge.confidence_, sizeof(double));
+    }
+    return WriteBINChunk(file, POSE_GRAPH_EDGE_CHUNK,
+            POSE_GRAPH_EDGE_RECORD_SIZE, pose_graph.edges_.size(), records);
+}
+
+bool WriteTrajectoryChunksToBINFile(FILE *file,
+        const PinholeCameraTrajectory &trajectory, bool write_intrinsic)
+{
+    std::vector<char> records;
+    if (write_intrinsic) {
+        records.resize(TRAJECTORY_INTRINSIC_RECORD_SIZE);
+        int32_t size[2] = {trajectory.intrinsic_.width_,
+                trajectory.intrinsic_.height_};
+        memcpy(records.data(), size, 8);
+        memcpy(records.data() + 8,
+                trajectory.intrinsic_.intrinsic_matrix_.data(),
+                9 * sizeof(double));
+        if (!WriteBINChunk(file, TRAJECTORY_INTRINSIC_CHUNK,
+                TRAJECTORY_INTRINSIC_RECORD_SIZE, 1, records)) {
+            return false;
+        }
+    }
+    records.resize(trajectory.extrinsic_.size() *
+            TRAJECTORY_EXTRINSIC_RECORD_SIZE);
+    for (size_t i = 0; i < trajectory.extrinsic_.size(); i++) {
+        memcpy(records.data() + i * TRAJECTORY_EXTRINSIC_RECORD_SIZE,
+                trajectory.extrinsic_[i].data(), 16 * sizeof(double));
+    }
+    return WriteBINChunk(file, TRAJECTORY_EXTRINSIC_CHUNK,
+            TRAJECTORY_EXTRINSIC_RECORD_SIZE, trajectory.extrinsic_.size(),
+            records);
+}
+
 bool WriteMatrixXdToBINFile(FILE *file, const Eigen::MatrixXd &mat)
 {
     size_t rows = static_cast<size_t>(mat.rows());
@@ -73,6 +491,210 @@ bool WriteMatrixXdToBINFile(FILE *file, const Eigen::MatrixXd &mat)
     return true;
 }
 
+struct TSDFBlockRecord
+{
+    Eigen::Vector3i index_;
+    uint32_t size_;
+    uint64_t offset_;
+};
+
+/// Function to write the block table and the block data chunks of a TSDF
+/// volume. get_block(i, data) fills the block_bytes raw bytes of block i. It
+/// is called from multiple threads.
+bool WriteTSDFBlockChunksToBINFile(FILE *file,
+        const std::vector<Eigen::Vector3i> &indices, size_t block_bytes,
+        const std::function<bool(size_t, uint8_t *)> &get_block)
+{
+    const size_t block_num = indices.size();
+    std::vector<TSDFBlockRecord> table(block_num);
+    std::vector<char> records(block_num * TSDF_BLOCK_TABLE_RECORD_SIZE, 0);
+    int64_t table_offset = filesystem::TellFile(file);
+    if (table_offset < 0 || !WriteBINChunk(file, TSDF_BLOCK_TABLE_CHUNK,
+            TSDF_BLOCK_TABLE_RECORD_SIZE, block_num, records)) {
+        return false;
+    }
+    // The size of the data chunk is written once it is known.
+    int64_t data_offset = filesystem::TellFile(file);
+    if (data_offset < 0) {
+        PrintWarning("Write BIN failed: unexpected error.\n");
+        return false;
+    }
+    char header[BIN_CHUNK_HEADER_SIZE] = {0};
+    if (fwrite(header, 1, BIN_CHUNK_HEADER_SIZE, file) <
+            BIN_CHUNK_HEADER_SIZE) {
+        PrintWarning("Write BIN failed: unexpected error.\n");
+        return false;
+    }
+
+    const size_t batch_num = std::max(TSDF_WRITE_BATCH_BYTES /
+            std::max(block_bytes, size_t(1)), size_t(1));
+    std::vector<std::vector<uint8_t>> raw_buffers(batch_num);
+    std::vector<std::vector<uint8_t>> buffers(batch_num);
+    std::vector<uint32_t> sizes(batch_num);
+    const char padding[8] = {0};
+    uint64_t offset = 0;
+    bool success = true;
+    for (size_t begin = 0; begin < block_num && success;
+            begin += batch_num) {
+        const int32_t num = static_cast<int32_t>(
+                std::min(batch_num, block_num - begin));
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int32_t i = 0; i < num; i++) {
+            raw_buffers[i].resize(block_bytes);
+            buffers[i].resize(block_bytes);
+            if (!get_block(begin + i, raw_buffers[i].data())) {
+                sizes[i] = 0;
+                continue;
+            }
+            sizes[i] = lzf_compress(raw_buffers[i].data(),
+                    (unsigned int)block_bytes, buffers[i].data(),
+                    (unsigned int)block_bytes - 1);
+            if (sizes[i] == 0) {
+                buffers[i].swap(raw_buffers[i]);
+                sizes[i] = (uint32_t)block_bytes;
+            }
+        }
+        for (int32_t i = 0; i < num; i++) {
+            if (sizes[i] == 0) {
+                PrintWarning("Write BIN failed: unable to read a volume block.\n");
+                success = false;
+                break;
+            }
+            TSDFBlockRecord &record = table[begin + i];
+            record.index_ = indices[begin + i];
+            record.size_ = sizes[i];
+            record.offset_ = offset;
+            size_t padding_size = (8 - sizes[i] % 8) % 8;
+            if (fwrite(buffers[i].data(), 1, sizes[i], file) < sizes[i] ||
+                    fwrite(padding, 1, padding_size, file) < padding_size) {
+                PrintWarning("Write BIN failed: unexpected error.\n");
+                success = false;
+                break;
+            }
+            offset += sizes[i] + padding_size;
+        }
+    }
+    if (!success) {
+        return false;
+    }
+
+    for (size_t i = 0; i < block_num; i++) {
+        char *record = records.data() + i * TSDF_BLOCK_TABLE_RECORD_SIZE;
+        memcpy(record, table[i].index_.data(), 3 * sizeof(int32_t));
+        memcpy(record + 12, &table[i].size_, sizeof(uint32_t));
+        memcpy(record + 16, &table[i].offset_, sizeof(uint64_t));
+    }
+    uint32_t type = TSDF_BLOCK_DATA_CHUNK;
+    uint32_t record_size = 1;
+    memcpy(header, &type, sizeof(uint32_t));
+    memcpy(header + 4, &record_size, sizeof(uint32_t));
+    memcpy(header + 8, &offset, sizeof(uint64_t));
+    if (!filesystem::SeekFile(file, table_offset) ||
+            !WriteBINChunk(file, TSDF_BLOCK_TABLE_CHUNK,
+            TSDF_BLOCK_TABLE_RECORD_SIZE, block_num, records) ||
+            !filesystem::SeekFile(file, data_offset) ||
+            fwrite(header, 1, BIN_CHUNK_HEADER_SIZE, file) <
+            BIN_CHUNK_HEADER_SIZE) {
+        PrintWarning("Write BIN failed: unexpected error.\n");
+        return false;
+    }
+    return true;
+}
+
+bool ReadTSDFBlockTable(uint32_t record_size, uint64_t count,
+        const char *data, std::vector<TSDFBlockRecord> &table)
+{
+    if (record_size < TSDF_BLOCK_TABLE_RECORD_SIZE) {
+        PrintWarning("Read BIN failed: corrupted chunk.\n");
+        return false;
+    }
+    table.resize(count);
+    for (uint64_t i = 0; i < count; i++) {
+        const char *record = data + i * record_size;
+        memcpy(table[i].index_.data(), record, 3 * sizeof(int32_t));
+        memcpy(&table[i].size_, record + 12, sizeof(uint32_t));
+        memcpy(&table[i].offset_, record + 16, sizeof(uint64_t));
+    }
+    return true;
+}
+
+/// Function to decompress the blocks of the block data chunk. set_block(i,
+/// data) receives the block_bytes raw bytes of block i. It is called from
+/// multiple threads.
+bool ReadTSDFBlockData(const std::vector<TSDFBlockRecord> &table,
+        uint64_t count, const char *data, size_t block_bytes,
+        const std::function<void(size_t, const uint8_t *)> &set_block)
+{
+    int64_t failed_num = 0;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        std::vector<uint8_t> buffer(block_bytes);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic) reduction(+:failed_num)
+#endif
+        for (int64_t i = 0; i < static_cast<int64_t>(table.size()); i++) {
+            const TSDFBlockRecord &record = table[i];
+            if (record.size_ > block_bytes ||
+                    record.offset_ + record.size_ > count) {
+                failed_num++;
+                continue;
+            }
+            const uint8_t *block = reinterpret_cast<const uint8_t *>(data +
+                    record.offset_);
+            if (record.size_ < block_bytes) {
+                if (lzf_decompress(block, record.size_, buffer.data(),
+                        (unsigned int)block_bytes) != block_bytes) {
+                    failed_num++;
+                    continue;
+                }
+                block = buffer.data();
+            }
+            set_block(i, block);
+        }
+    }
+    if (failed_num > 0) {
+        PrintWarning("Read BIN failed: %d corrupted volume blocks.\n",
+                (int)failed_num);
+        return false;
+    }
+    return true;
+}
+
+/// Function to write a file through a temporary file that replaces filename
+/// only after it is completely written
+bool WriteBINFileReplacing(const std::string &filename, const char *magic,
+        const std::function<bool(FILE *)> &write_chunks)
+{
+    const std::string tmp_filename = filename + ".tmp";
+    bool created;
+    FILE *file = OpenBINFileForAppend(tmp_filename, magic, true, created);
+    if (file == NULL) {
+        return false;
+    }
+    bool success = write_chunks(file);
+    if (fclose(file) != 0) {
+        success = false;
+    }
+    if (!success) {
+        std::remove(tmp_filename.c_str());
+        return false;
+    }
+#ifdef WINDOWS
+    std::remove(filename.c_str());
+#endif
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        PrintWarning("Write BIN failed: unable to replace file: %s\n",
+                filename.c_str());
+        std::remove(tmp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
 }   // unnamed namespace
 
 bool ReadFeatureFromBIN(const std::string &filename, Feature &feature)
@@ -99,4 +721,358 @@ bool WriteFeatureToBIN(const std::string &filename, const Feature &feature)
     return success;
 }
 
+bool ReadPoseGraphFromBIN(const std::string &filename, PoseGraph &pose_graph)
+{
+    pose_graph.nodes_.clear();
+    pose_graph.edges_.clear();
+    return ReadBINChunks(filename, POSE_GRAPH_BIN_MAGIC, [&](uint32_t type,
+            uint32_t record_size, uint64_t count, const char *data) {
+        if (type == POSE_GRAPH_NODE_CHUNK) {
+            if (record_size < POSE_GRAPH_NODE_RECORD_SIZE) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            size_t offset = pose_graph.nodes_.size();
+            pose_graph.nodes_.resize(offset + count);
+            for (uint64_t i = 0; i < count; i++) {
+                memcpy(pose_graph.nodes_[offset + i].pose_.data(),
+                        data + i * record_size, 16 * sizeof(double));
+            }
+        } else if (type == POSE_GRAPH_EDGE_CHUNK) {
+            if (record_size < POSE_GRAPH_EDGE_RECORD_SIZE) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            size_t offset = pose_graph.edges_.size();
+            pose_graph.edges_.resize(offset + count);
+            for (uint64_t i = 0; i < count; i++) {
+                PoseGraphEdge &edge = pose_graph.edges_[offset + i];
+                const char *record = data + i * record_size;
+                int32_t ids[3];
+                memcpy(ids, record, 12);
+                edge.source_node_id_ = ids[0];
+                edge.target_node_id_ = ids[1];
+                edge.uncertain_ = ids[2] != 0;
+                memcpy(edge.transformation_.data(), record + 16,
+                        16 * sizeof(double));
+                memcpy(edge.information_.data(), record + 144,
+                        36 * sizeof(double));
+                memcpy(&edge.confidence_, record + 432, sizeof(double));
+            }
+        }
+        return true;
+    });
+}
+
+bool WritePoseGraphToBIN(const std::string &filename,
+        const PoseGraph &pose_graph)
+{
+    return WriteBINFileReplacing(filename, POSE_GRAPH_BIN_MAGIC,
+            [&](FILE *file) {
+        return WritePoseGraphChunksToBINFile(file, pose_graph);
+    });
+}
+
+bool AppendPoseGraphToBIN(const std::string &filename,
+        const PoseGraph &pose_graph)
+{
+    bool created;
+    FILE *file = OpenBINFileForAppend(filename, POSE_GRAPH_BIN_MAGIC, false,
+            created);
+    if (file == NULL) {
+        return false;
+    }
+    bool success = WritePoseGraphChunksToBINFile(file, pose_graph);
+    fclose(file);
+    return success;
+}
+
+bool ReadPinholeCameraTrajectoryFromBIN(const std::string &filename,
+        PinholeCameraTrajectory &trajectory)
+{
+    trajectory.extrinsic_.clear();
+    return ReadBINChunks(filename, TRAJECTORY_BIN_MAGIC, [&](uint32_t type,
+            uint32_t record_size, uint64_t count, const char *data) {
+        if (type == TRAJECTORY_INTRINSIC_CHUNK) {
+            if (record_size < TRAJECTORY_INTRINSIC_RECORD_SIZE) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            if (count > 0) {
+                const char *record = data + (count - 1) * record_size;
+                int32_t size[2];
+                memcpy(size, record, 8);
+                trajectory.intrinsic_.width_ = size[0];
+                trajectory.intrinsic_.height_ = size[1];
+                memcpy(trajectory.intrinsic_.intrinsic_matrix_.data(),
+                        record + 8, 9 * sizeof(double));
+            }
+        } else if (type == TRAJECTORY_EXTRINSIC_CHUNK) {
+            if (record_size < TRAJECTORY_EXTRINSIC_RECORD_SIZE) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            size_t offset = trajectory.extrinsic_.size();
+            trajectory.extrinsic_.resize(offset + count);
+            for (uint64_t i = 0; i < count; i++) {
+                memcpy(trajectory.extrinsic_[offset + i].data(),
+                        data + i * record_size, 16 * sizeof(double));
+            }
+        }
+        return true;
+    });
+}
+
+bool WritePinholeCameraTrajectoryToBIN(const std::string &filename,
+        const PinholeCameraTrajectory &trajectory)
+{
+    return WriteBINFileReplacing(filename, TRAJECTORY_BIN_MAGIC,
+            [&](FILE *file) {
+        return WriteTrajectoryChunksToBINFile(file, trajectory, true);
+    });
+}
+
+bool AppendPinholeCameraTrajectoryToBIN(const std::string &filename,
+        const PinholeCameraTrajectory &trajectory)
+{
+    bool created;
+    FILE *file = OpenBINFileForAppend(filename, TRAJECTORY_BIN_MAGIC, false,
+            created);
+    if (file == NULL) {
+        return false;
+    }
+    bool success = WriteTrajectoryChunksToBINFile(file, trajectory, created);
+    fclose(file);
+    return success;
+}
+
+std::shared_ptr<UniformTSDFVolume> CreateUniformTSDFVolumeFromBIN(
+        const std::string &filename)
+{
+    std::shared_ptr<UniformTSDFVolume> volume;
+    std::vector<TSDFBlockRecord> table;
+    double params[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    uint32_t resolution = 0;
+    int32_t with_color = 0;
+    size_t block_bytes = 0;
+    bool success = ReadBINChunks(filename, UNIFORM_TSDF_BIN_MAGIC, [&](
+            uint32_t type, uint32_t record_size, uint64_t count,
+            const char *data) {
+        if (type == TSDF_PARAMETER_CHUNK) {
+            if (record_size < TSDF_PARAMETER_RECORD_SIZE || count < 1) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            uint64_t bytes;
+            memcpy(params, data, 5 * sizeof(double));
+            memcpy(&resolution, data + 40, sizeof(uint32_t));
+            memcpy(&with_color, data + 44, sizeof(int32_t));
+            memcpy(&bytes, data + 48, sizeof(uint64_t));
+            // The voxel count of the volume must fit in uint32_t.
+            const uint64_t voxel_num = (uint64_t)resolution * resolution *
+                    resolution;
+            if (resolution == 0 || voxel_num > 0xffffffffull ||
+                    !(params[0] > 0.0) || !(params[1] > 0.0)) {
+                PrintWarning("Read BIN failed: invalid volume parameters.\n");
+                return false;
+            }
+            block_bytes = (size_t)resolution * resolution *
+                    (with_color != 0 ? 5 : 2) * sizeof(float);
+            if (bytes != block_bytes) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+        } else if (type == TSDF_BLOCK_TABLE_CHUNK) {
+            return ReadTSDFBlockTable(record_size, count, data, table);
+        } else if (type == TSDF_BLOCK_DATA_CHUNK) {
+            if (resolution == 0) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            // Every slice must be stored exactly once, so that the volume is
+            // only allocated for a file that covers all of it.
+            if (table.size() != resolution) {
+                PrintWarning("Read BIN failed: %d of %d volume slices stored.\n",
+                        (int)table.size(), (int)resolution);
+                return false;
+            }
+            std::vector<bool> covered(resolution, false);
+            for (const auto &record : table) {
+                if (record.index_(0) < 0 ||
+                        record.index_(0) >= (int32_t)resolution ||
+                        covered[record.index_(0)]) {
+                    PrintWarning("Read BIN failed: corrupted chunk.\n");
+                    return false;
+                }
+                covered[record.index_(0)] = true;
+            }
+            volume = std::make_shared<UniformTSDFVolume>(params[0],
+                    resolution, params[1], with_color != 0,
+                    Eigen::Vector3d(params[2], params[3], params[4]));
+            const size_t slice_size = (size_t)resolution * resolution;
+            return ReadTSDFBlockData(table, count, data, block_bytes,
+                    [&](size_t i, const uint8_t *block) {
+                const size_t offset = (size_t)table[i].index_(0) * slice_size;
+                const float *values = reinterpret_cast<const float *>(block);
+                memcpy(volume->tsdf_.data() + offset, values,
+                        slice_size * sizeof(float));
+                memcpy(volume->weight_.data() + offset, values + slice_size,
+                        slice_size * sizeof(float));
+                if (volume->with_color_) {
+                    memcpy(volume->color_[offset].data(),
+                            values + 2 * slice_size,
+                            3 * slice_size * sizeof(float));
+                }
+            });
+        }
+        return true;
+    });
+    if (!success || volume == NULL) {
+        return NULL;
+    }
+    return volume;
+}
+
+bool WriteUniformTSDFVolumeToBIN(const std::string &filename,
+        const UniformTSDFVolume &volume)
+{
+    const int32_t resolution = (int32_t)volume.resolution_;
+    const size_t slice_size = (size_t)resolution * resolution;
+    const size_t block_bytes = slice_size * (volume.with_color_ ? 5 : 2) *
+            sizeof(float);
+    return WriteBINFileReplacing(filename, UNIFORM_TSDF_BIN_MAGIC,
+            [&](FILE *file) {
+        std::vector<char> records(TSDF_PARAMETER_RECORD_SIZE, 0);
+        double params[5] = {volume.length_, volume.sdf_trunc_,
+                volume.origin_(0), volume.origin_(1), volume.origin_(2)};
+        int32_t with_color = volume.with_color_ ? 1 : 0;
+        uint64_t bytes = block_bytes;
+        memcpy(records.data(), params, 5 * sizeof(double));
+        memcpy(records.data() + 40, &volume.resolution_, sizeof(uint32_t));
+        memcpy(records.data() + 44, &with_color, sizeof(int32_t));
+        memcpy(records.data() + 48, &bytes, sizeof(uint64_t));
+        if (!WriteBINChunk(file, TSDF_PARAMETER_CHUNK,
+                TSDF_PARAMETER_RECORD_SIZE, 1, records)) {
+            return false;
+        }
+        std::vector<Eigen::Vector3i> indices(resolution);
+        for (int32_t x = 0; x < resolution; x++) {
+            indices[x] = Eigen::Vector3i(x, 0, 0);
+        }
+        return WriteTSDFBlockChunksToBINFile(file, indices, block_bytes,
+                [&](size_t i, uint8_t *block) {
+            const size_t offset = i * slice_size;
+            float *values = reinterpret_cast<float *>(block);
+            memcpy(values, volume.tsdf_.data() + offset,
+                    slice_size * sizeof(float));
+            memcpy(values + slice_size, volume.weight_.data() + offset,
+                    slice_size * sizeof(float));
+            if (volume.with_color_) {
+                memcpy(values + 2 * slice_size, volume.color_[offset].data(),
+                        3 * slice_size * sizeof(float));
+            }
+            return true;
+        });
+    });
+}
+
+std::shared_ptr<ScalableTSDFVolume> CreateScalableTSDFVolumeFromBIN(
+        const std::string &filename)
+{
+    std::shared_ptr<ScalableTSDFVolume> volume;
+    std::vector<TSDFBlockRecord> table;
+    bool success = ReadBINChunks(filename, SCALABLE_TSDF_BIN_MAGIC, [&](
+            uint32_t type, uint32_t record_size, uint64_t count,
+            const char *data) {
+        if (type == TSDF_PARAMETER_CHUNK) {
+            if (record_size < TSDF_PARAMETER_RECORD_SIZE || count < 1) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            double params[2];
+            int32_t ints[4];
+            uint64_t bytes;
+            memcpy(params, data, 2 * sizeof(double));
+            memcpy(ints, data + 16, 4 * sizeof(int32_t));
+            memcpy(&bytes, data + 32, sizeof(uint64_t));
+            // The voxel count of a volume unit must fit in int32_t.
+            const uint64_t voxel_num = (uint64_t)std::max(ints[1], 0) *
+                    ints[1] * ints[1];
+            if (ints[1] <= 0 || voxel_num > 0x7fffffffull || ints[2] <= 0 ||
+                    ints[3] < 0 || ints[3] > 2 || !(params[0] > 0.0) ||
+                    !(params[1] > 0.0)) {
+                PrintWarning("Read BIN failed: invalid volume parameters.\n");
+                return false;
+            }
+            if (bytes == 0 || bytes % voxel_num != 0) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            volume = std::make_shared<ScalableTSDFVolume>(params[0],
+                    params[1], ints[0] != 0, ints[1], ints[2],
+                    static_cast<ScalableTSDFVolume::VoxelFormat>(ints[3]));
+            if (bytes != volume->volume_units_.BlockBytes()) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+        } else if (type == TSDF_BLOCK_TABLE_CHUNK) {
+            return ReadTSDFBlockTable(record_size, count, data, table);
+        } else if (type == TSDF_BLOCK_DATA_CHUNK) {
+            if (volume == NULL) {
+                PrintWarning("Read BIN failed: corrupted chunk.\n");
+                return false;
+            }
+            VoxelBlockPool &volume_units = volume->volume_units_;
+            volume_units.Reserve(table.size());
+            std::vector<int32_t> block_ids(table.size());
+            for (size_t i = 0; i < table.size(); i++) {
+                block_ids[i] = volume->ActivateVolumeUnit(table[i].index_);
+            }
+            if (volume_units.NumberOfBlocks() != table.size()) {
+                PrintWarning("Read BIN failed: duplicated volume units.\n");
+                return false;
+            }
+            return ReadTSDFBlockData(table, count, data,
+                    volume_units.BlockBytes(),
+                    [&](size_t i, const uint8_t *block) {
+                memcpy(volume_units.GetBlockData(block_ids[i]), block,
+                        volume_units.BlockBytes());
+            });
+        }
+        return true;
+    });
+    if (!success || volume == NULL) {
+        return NULL;
+    }
+    return volume;
+}
+
+bool WriteScalableTSDFVolumeToBIN(const std::string &filename,
+        const ScalableTSDFVolume &volume)
+{
+    const size_t block_bytes = volume.volume_units_.BlockBytes();
+    return WriteBINFileReplacing(filename, SCALABLE_TSDF_BIN_MAGIC,
+            [&](FILE *file) {
+        std::vector<char> records(TSDF_PARAMETER_RECORD_SIZE, 0);
+        double params[2] = {volume.voxel_length_, volume.sdf_trunc_};
+        int32_t ints[4] = {volume.with_color_ ? 1 : 0,
+                volume.volume_unit_resolution_, volume.depth_sampling_stride_,
+                static_cast<int32_t>(volume.voxel_format_)};
+        uint64_t bytes = block_bytes;
+        memcpy(records.data(), params, 2 * sizeof(double));
+        memcpy(records.data() + 16, ints, 4 * sizeof(int32_t));
+        memcpy(records.data() + 32, &bytes, sizeof(uint64_t));
+        if (!WriteBINChunk(file, TSDF_PARAMETER_CHUNK,
+                TSDF_PARAMETER_RECORD_SIZE, 1, records)) {
+            return false;
+        }
+        const std::vector<Eigen::Vector3i> indices =
+                volume.GetVolumeUnitIndices();
+        return WriteTSDFBlockChunksToBINFile(file, indices, block_bytes,
+                [&](size_t i, uint8_t *block) {
+            return volume.CopyVolumeUnit(indices[i], block);
+        });
+    });
+}
+
 }   // namespace open3d
@@ -98,4 +98,10 @@ void pybind_camera_methods(py::module &m)
         return WritePinholeCameraTrajectory(filename, trajectory);
     }, "Function to write PinholeCameraTrajectory to file", "filename"_a,
             "trajectory"_a);
+    m.def("append_pinhole_camera_trajectory_to_bin", [](
+            const std::string &filename,
+            const PinholeCameraTrajectory &trajectory) {
+        return AppendPinholeCameraTrajectoryToBIN(filename, trajectory);
+    }, "Function to append the extrinsics of PinholeCameraTrajectory to a "
+            "BIN file", "filename"_a, "trajectory"_a);
 }
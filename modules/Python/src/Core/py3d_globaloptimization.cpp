@@ -143,6 +143,29 @@ void pybind_globaloptimization(py::module &m)
             return std::string("GlobalOptimizationGaussNewton");
     });
 
+    py::class_<GlobalOptimizationHierarchical,
+            PyGlobalOptimizationMethod<GlobalOptimizationHierarchical>,
+            GlobalOptimizationMethod> global_optimization_method_hierarchical(
+            m, "GlobalOptimizationHierarchical");
+    py::detail::bind_default_constructor<GlobalOptimizationHierarchical>
+            (global_optimization_method_hierarchical);
+    py::detail::bind_copy_functions<GlobalOptimizationHierarchical>(
+            global_optimization_method_hierarchical);
+    global_optimization_method_hierarchical
+            .def(py::init([](int32_t submap_size, bool global_refinement) {
+                return std::unique_ptr<GlobalOptimizationHierarchical>(
+                        new GlobalOptimizationHierarchical(submap_size,
+                        global_refinement));
+            }), "submap_size"_a = 100, "global_refinement"_a = false)
+            .def_readwrite("submap_size",
+                    &GlobalOptimizationHierarchical::submap_size_)
+            .def_readwrite("global_refinement",
+                    &GlobalOptimizationHierarchical::global_refinement_)
+            .def("__repr__", [](const GlobalOptimizationHierarchical &te) {
+            return std::string("GlobalOptimizationHierarchical with submap_size ") +
+                    std::to_string(te.submap_size_);
+    });
+
     py::class_<GlobalOptimizationConvergenceCriteria> criteria
             (m, "GlobalOptimizationConvergenceCriteria");
     py::detail::bind_default_constructor
@@ -193,6 +216,14 @@ void pybind_globaloptimization(py::module &m)
             <GlobalOptimizationOption>(option);
     py::detail::bind_copy_functions
             <GlobalOptimizationOption>(option);
+    py::enum_<GlobalOptimizationOption::LinearSolverType>(option,
+            "LinearSolverType")
+        .value("Dense", GlobalOptimizationOption::LinearSolverType::Dense)
+        .value("SparseCholesky",
+                GlobalOptimizationOption::LinearSolverType::SparseCholesky)
+        .value("ConjugateGradient",
+                GlobalOptimizationOption::LinearSolverType::ConjugateGradient)
+        .export_values();
     option
         .def_readwrite("max_correspondence_distance",
                 &GlobalOptimizationOption::
@@ -201,12 +232,25 @@ void pybind_globaloptimization(py::module &m)
                 &GlobalOptimizationOption::edge_prune_threshold_)
         .def_readwrite("reference_node",
                 &GlobalOptimizationOption::reference_node_)
+        .def_readwrite("linear_solver",
+                &GlobalOptimizationOption::linear_solver_)
+        .def_readwrite("max_iteration_cg",
+                &GlobalOptimizationOption::max_iteration_cg_)
+        .def_readwrite("relative_tolerance_cg",
+                &GlobalOptimizationOption::relative_tolerance_cg_)
         .def(py::init([](double max_correspondence_distance,
-                double edge_prune_threshold, int32_t reference_node) {
+                double edge_prune_threshold, int32_t reference_node,
+                GlobalOptimizationOption::LinearSolverType linear_solver,
+                uint32_t max_iteration_cg, double relative_tolerance_cg) {
             return std::unique_ptr<GlobalOptimizationOption>(new GlobalOptimizationOption(max_correspondence_distance,
-                edge_prune_threshold, reference_node));
+                edge_prune_threshold, reference_node, linear_solver,
+                max_iteration_cg, relative_tolerance_cg));
         }), "max_correspondence_distance"_a = 0.03,
-                "edge_prune_threshold"_a = 0.25, "reference_node"_a = -1)
+                "edge_prune_threshold"_a = 0.25, "reference_node"_a = -1,
+                "linear_solver"_a = GlobalOptimizationOption::
+                LinearSolverType::SparseCholesky,
+                "max_iteration_cg"_a = 1000,
+                "relative_tolerance_cg"_a = 1e-8)
         .def("__repr__", [](const GlobalOptimizationOption &goo) {
             return std::string("GlobalOptimizationOption") +
                 std::string("\n> max_correspondence_distance : ") +
@@ -214,7 +258,45 @@ void pybind_globaloptimization(py::module &m)
                 std::string("\n> edge_prune_threshold : ") +
                 std::to_string(goo.edge_prune_threshold_) +
                 std::string("\n> reference_node : ") +
-                std::to_string(goo.reference_node_);
+                std::to_string(goo.reference_node_) +
+                std::string("\n> linear_solver : ") +
+                std::to_string((int)goo.linear_solver_) +
+                std::string("\n> max_iteration_cg : ") +
+                std::to_string(goo.max_iteration_cg_) +
+                std::string("\n> relative_tolerance_cg : ") +
+                std::to_string(goo.relative_tolerance_cg_);
+    });
+
+    py::class_<IncrementalGlobalOptimization> incremental_optimization(m,
+            "IncrementalGlobalOptimization");
+    incremental_optimization
+        .def(py::init([](const GlobalOptimizationConvergenceCriteria &criteria,
+                const GlobalOptimizationOption &option,
+                double max_affected_ratio) {
+            return std::unique_ptr<IncrementalGlobalOptimization>(
+                    new IncrementalGlobalOptimization(criteria, option,
+                    max_affected_ratio));
+        }), "criteria"_a = GlobalOptimizationConvergenceCriteria(),
+                "option"_a = GlobalOptimizationOption(),
+                "max_affected_ratio"_a = 0.5)
+        .def("add_node", &IncrementalGlobalOptimization::AddNode,
+                "Function to append a node", "node"_a)
+        .def("add_edge", &IncrementalGlobalOptimization::AddEdge,
+                "Function to append an edge between added nodes", "edge"_a)
+        .def("update", &IncrementalGlobalOptimization::Update,
+                "Function to optimize the nodes affected since the last update")
+        .def("get_pose_graph", &IncrementalGlobalOptimization::GetPoseGraph,
+                "Function to get the optimized PoseGraph")
+        .def_readwrite("criteria", &IncrementalGlobalOptimization::criteria_)
+        .def_readwrite("option", &IncrementalGlobalOptimization::option_)
+        .def_readwrite("max_affected_ratio",
+                &IncrementalGlobalOptimization::max_affected_ratio_)
+        .def("__repr__", [](const IncrementalGlobalOptimization &igo) {
+            return std::string("IncrementalGlobalOptimization with ") +
+                std::to_string(igo.GetPoseGraph().nodes_.size()) +
+                std::string(" nodes and ") +
+                std::to_string(igo.GetPoseGraph().edges_.size()) +
+                std::string(" edges.");
     });
 }
 
@@ -230,6 +312,11 @@ void pybind_globaloptimization_methods(py::module &m)
             WritePoseGraph(filename, pose_graph);
             }, "Function to write PoseGraph to file",
                     "filename"_a, "pose_graph"_a);
+    m.def("append_pose_graph_to_bin", [](const std::string &filename,
+            const PoseGraph &pose_graph) {
+            return AppendPoseGraphToBIN(filename, pose_graph);
+            }, "Function to append the nodes and edges of PoseGraph to a BIN "
+                    "file", "filename"_a, "pose_graph"_a);
     m.def("global_optimization", [](PoseGraph &pose_graph,
             const GlobalOptimizationMethod &method,
             const GlobalOptimizationConvergenceCriteria &criteria,
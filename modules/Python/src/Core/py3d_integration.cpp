@@ -31,6 +31,7 @@
 #include <Open3D/Core/Integration/TSDFVolume.h>
 #include <Open3D/Core/Integration/UniformTSDFVolume.h>
 #include <Open3D/Core/Integration/ScalableTSDFVolume.h>
+#include <Open3D/IO/ClassIO/TSDFVolumeIO.h>
 
 using namespace open3d;
 
@@ -54,12 +55,28 @@ public:
     std::shared_ptr<TriangleMesh> ExtractTriangleMesh() override {
         PYBIND11_OVERLOAD_PURE(std::shared_ptr<TriangleMesh>, TSDFVolumeBase, );
     }
+    std::shared_ptr<TSDFRaycastImage> Raycast(
+            const PinholeCameraIntrinsic &intrinsic,
+            const Eigen::Matrix4d &extrinsic, double depth_min,
+            double depth_max) override {
+        PYBIND11_OVERLOAD_PURE(std::shared_ptr<TSDFRaycastImage>,
+                TSDFVolumeBase, intrinsic, extrinsic, depth_min, depth_max);
+    }
 };
 
 void pybind_integration(py::module &m)
 {
-    py::class_<TSDFVolume, PyTSDFVolume<TSDFVolume>>
-            tsdfvolume(m, "TSDFVolume");
+    py::class_<TSDFRaycastImage, std::shared_ptr<TSDFRaycastImage>>
+            raycast_image(m, "TSDFRaycastImage");
+    py::detail::bind_default_constructor<TSDFRaycastImage>(raycast_image);
+    raycast_image
+        .def_readwrite("depth", &TSDFRaycastImage::depth_)
+        .def_readwrite("vertex", &TSDFRaycastImage::vertex_)
+        .def_readwrite("normal", &TSDFRaycastImage::normal_)
+        .def_readwrite("color", &TSDFRaycastImage::color_);
+
+    py::class_<TSDFVolume, PyTSDFVolume<TSDFVolume>,
+            std::shared_ptr<TSDFVolume>> tsdfvolume(m, "TSDFVolume");
     tsdfvolume
         .def("reset", &TSDFVolume::Reset, "Function to reset the TSDFVolume")
         .def("integrate", &TSDFVolume::Integrate,
@@ -69,19 +86,53 @@ void pybind_integration(py::module &m)
                 "Function to extract a point cloud with normals")
         .def("extract_triangle_mesh", &TSDFVolume::ExtractTriangleMesh,
                 "Function to extract a triangle mesh")
+        .def("raycast", &TSDFVolume::Raycast,
+                "Function to render depth, vertex, normal and color images "
+                "of the volume by raycasting", "intrinsic"_a, "extrinsic"_a,
+                "depth_min"_a = 0.1, "depth_max"_a = 3.0)
+        .def("integrate_sequence", [](TSDFVolume &volume,
+                const PinholeCameraIntrinsic &intrinsic, int32_t frame_num,
+                py::function load_frame, int32_t prefetch_num) {
+            // load_frame(i) returns a tuple (image, extrinsic), or None to end
+            // the sequence. It is called from the loader thread, so its errors
+            // are passed on without references to Python objects.
+            py::gil_scoped_release release;
+            return volume.IntegrateSequence(intrinsic, frame_num,
+                    [&](int32_t i, RGBDImage &image,
+                    Eigen::Matrix4d &extrinsic) {
+                py::gil_scoped_acquire acquire;
+                try {
+                    py::object frame = load_frame(i);
+                    if (frame.is_none()) {
+                        return false;
+                    }
+                    auto tuple = frame.cast<py::tuple>();
+                    image = tuple[0].cast<RGBDImage>();
+                    extrinsic = tuple[1].cast<Eigen::Matrix4d>();
+                } catch (const std::exception &e) {
+                    throw std::runtime_error(e.what());
+                }
+                return true;
+            });
+        }, "Function to integrate a sequence of RGB-D images, loading the "
+                "next frames while integrating. load_frame(i) returns a tuple "
+                "(image, extrinsic), or None to end the sequence.",
+                "intrinsic"_a, "frame_num"_a, "load_frame"_a,
+                "prefetch_num"_a = 2)
         .def_readwrite("voxel_length", &TSDFVolume::voxel_length_)
         .def_readwrite("sdf_trunc", &TSDFVolume::sdf_trunc_)
         .def_readwrite("with_color", &TSDFVolume::with_color_);
 
-    py::class_<UniformTSDFVolume, PyTSDFVolume<UniformTSDFVolume>, TSDFVolume>
+    py::class_<UniformTSDFVolume, PyTSDFVolume<UniformTSDFVolume>,
+            std::shared_ptr<UniformTSDFVolume>, TSDFVolume>
             uniform_tsdfvolume(m, "UniformTSDFVolume");
     py::detail::bind_copy_functions<UniformTSDFVolume>(
             uniform_tsdfvolume);
     uniform_tsdfvolume
         .def(py::init([](double length, uint32_t resolution,
                 double sdf_trunc, bool with_color) {
-            return std::unique_ptr<UniformTSDFVolume>(new UniformTSDFVolume(
-                    length, resolution, sdf_trunc, with_color));
+            return std::make_shared<UniformTSDFVolume>(length, resolution,
+                    sdf_trunc, with_color);
         }), "length"_a, "resolution"_a, "sdf_trunc"_a, "with_color"_a)
         .def("__repr__", [](const UniformTSDFVolume &vol) {
             return std::string("UniformTSDFVolume ") +
@@ -92,26 +143,76 @@ void pybind_integration(py::module &m)
         .def_readwrite("length", &UniformTSDFVolume::length_)
         .def_readwrite("resolution", &UniformTSDFVolume::resolution_);
 
-    py::class_<ScalableTSDFVolume, PyTSDFVolume<ScalableTSDFVolume>, TSDFVolume>
+    py::class_<ScalableTSDFVolume, PyTSDFVolume<ScalableTSDFVolume>,
+            std::shared_ptr<ScalableTSDFVolume>, TSDFVolume>
             scalable_tsdfvolume(m, "ScalableTSDFVolume");
     py::detail::bind_copy_functions<ScalableTSDFVolume>(
             scalable_tsdfvolume);
+    py::enum_<ScalableTSDFVolume::VoxelFormat>(scalable_tsdfvolume,
+            "VoxelFormat")
+        .value("Float", ScalableTSDFVolume::VoxelFormat::Float)
+        .value("Compact16", ScalableTSDFVolume::VoxelFormat::Compact16)
+        .value("Compact8", ScalableTSDFVolume::VoxelFormat::Compact8)
+        .export_values();
     scalable_tsdfvolume
         .def(py::init([](double voxel_length, double sdf_trunc, bool with_color,
-                int32_t volume_unit_resolution, int32_t depth_sampling_stride) {
-            return std::unique_ptr<ScalableTSDFVolume>(new ScalableTSDFVolume(voxel_length, sdf_trunc,
-                with_color, volume_unit_resolution, depth_sampling_stride));
+                int32_t volume_unit_resolution, int32_t depth_sampling_stride,
+                ScalableTSDFVolume::VoxelFormat voxel_format) {
+            return std::make_shared<ScalableTSDFVolume>(voxel_length,
+                    sdf_trunc, with_color, volume_unit_resolution,
+                    depth_sampling_stride, voxel_format);
         }), "voxel_length"_a, "sdf_trunc"_a, "with_color"_a,
-                "volume_unit_resolution"_a = 16, "depth_sampling_stride"_a = 4)
+                "volume_unit_resolution"_a = 16, "depth_sampling_stride"_a = 4,
+                "voxel_format"_a = ScalableTSDFVolume::VoxelFormat::Float)
         .def("__repr__", [](const ScalableTSDFVolume &vol) {
             return std::string("ScalableTSDFVolume ") +
                     (vol.with_color_ ? std::string("with color.") :
                     std::string("without color."));
     })
         .def("extract_voxel_point_cloud",
-                &ScalableTSDFVolume::ExtractVoxelPointCloud);
+                &ScalableTSDFVolume::ExtractVoxelPointCloud)
+        .def("extract_triangle_mesh_incremental",
+                &ScalableTSDFVolume::ExtractTriangleMeshIncremental,
+                "Function to extract a triangle mesh, meshing again only the "
+                "volume units modified since the previous incremental "
+                "extraction")
+        .def("extract_triangle_mesh_delta",
+                &ScalableTSDFVolume::ExtractTriangleMeshDelta,
+                "Function to return the volume unit meshes changed since the "
+                "previous incremental extraction")
+        .def("enable_streaming", &ScalableTSDFVolume::EnableStreaming,
+                "Function to move the volume units farther than "
+                "streaming_radius from the camera into a block store on disk",
+                "block_store_path"_a, "streaming_radius"_a)
+        .def("disable_streaming", &ScalableTSDFVolume::DisableStreaming,
+                "Function to load all stored volume units and stop streaming")
+        .def("is_streaming", &ScalableTSDFVolume::IsStreaming)
+        .def("number_of_volume_units",
+                &ScalableTSDFVolume::NumberOfVolumeUnits);
+
+    py::class_<ScalableTSDFVolume::MeshDelta> mesh_delta(scalable_tsdfvolume,
+            "MeshDelta");
+    mesh_delta
+        .def_readonly("removed_units",
+                &ScalableTSDFVolume::MeshDelta::removed_units_)
+        .def_readonly("added_units",
+                &ScalableTSDFVolume::MeshDelta::added_units_)
+        .def_readonly("added_meshes",
+                &ScalableTSDFVolume::MeshDelta::added_meshes_);
 }
 
 void pybind_integration_methods(py::module &m)
 {
+    m.def("read_uniform_tsdf_volume", &CreateUniformTSDFVolumeFromFile,
+            "Function to read UniformTSDFVolume from file, None if the file "
+            "cannot be read", "filename"_a);
+    m.def("write_uniform_tsdf_volume", &WriteUniformTSDFVolume,
+            "Function to write UniformTSDFVolume to file",
+            "filename"_a, "volume"_a);
+    m.def("read_scalable_tsdf_volume", &CreateScalableTSDFVolumeFromFile,
+            "Function to read ScalableTSDFVolume from file, None if the file "
+            "cannot be read", "filename"_a);
+    m.def("write_scalable_tsdf_volume", &WriteScalableTSDFVolume,
+            "Function to write ScalableTSDFVolume to file",
+            "filename"_a, "volume"_a);
 }
@@ -100,6 +100,22 @@ void pybind_odometry(py::module &m)
                 std::to_string(c.max_depth_);
         });
 
+    py::class_<OdometryFrame, std::shared_ptr<OdometryFrame>>
+            odometry_frame(m, "OdometryFrame");
+    odometry_frame
+        .def(py::init<const RGBDImage &, const PinholeCameraIntrinsic &,
+                const OdometryOption &>(), "rgbd_image"_a,
+                "pinhole_camera_intrinsic"_a = PinholeCameraIntrinsic(),
+                "option"_a = OdometryOption())
+        .def("is_empty", &OdometryFrame::IsEmpty)
+        .def("number_of_levels", &OdometryFrame::NumberOfLevels)
+        .def_readonly("intrinsic", &OdometryFrame::intrinsic_)
+        .def("__repr__", [](const OdometryFrame &f) {
+            return std::string("OdometryFrame with ") +
+                    std::to_string(f.NumberOfLevels()) +
+                    std::string(" levels.");
+        });
+
     py::class_<RGBDOdometryJacobian,
             PyRGBDOdometryJacobian<RGBDOdometryJacobian>>
             jacobian(m, "RGBDOdometryJacobian");
@@ -136,11 +152,24 @@ void pybind_odometry(py::module &m)
 
 void pybind_odometry_methods(py::module &m)
 {
-    m.def("compute_rgbd_odometry", &ComputeRGBDOdometry,
+    m.def("compute_rgbd_odometry", (std::tuple<bool, Eigen::Matrix4d,
+            Eigen::Matrix6d> (*)(const RGBDImage &, const RGBDImage &,
+            const PinholeCameraIntrinsic &, const Eigen::Matrix4d &,
+            const RGBDOdometryJacobian &, const OdometryOption &))
+            &ComputeRGBDOdometry,
             "Function to estimate 6D rigid motion from two RGBD image pairs",
             "rgbd_source"_a, "rgbd_target"_a,
             "pinhole_camera_intrinsic"_a = PinholeCameraIntrinsic(),
             "odo_init"_a = Eigen::Matrix4d::Identity(),
             "jacobian"_a = RGBDOdometryJacobianFromHybridTerm(),
             "option"_a = OdometryOption());
+    m.def("compute_rgbd_odometry", (std::tuple<bool, Eigen::Matrix4d,
+            Eigen::Matrix6d> (*)(const OdometryFrame &, const OdometryFrame &,
+            const Eigen::Matrix4d &, const RGBDOdometryJacobian &,
+            const OdometryOption &))&ComputeRGBDOdometry,
+            "Function to estimate 6D rigid motion from two preprocessed frames",
+            "source"_a, "target"_a,
+            "odo_init"_a = Eigen::Matrix4d::Identity(),
+            "jacobian"_a = RGBDOdometryJacobianFromHybridTerm(),
+            "option"_a = OdometryOption());
 }
@@ -114,6 +114,42 @@ void pybind_registration(py::module &m)
                     std::to_string(c.max_validation_));
         });
 
+    py::class_<RANSACValidationOption> ransac_validation(m,
+            "RANSACValidationOption");
+    py::detail::bind_copy_functions<RANSACValidationOption>(
+            ransac_validation);
+    ransac_validation
+        .def(py::init([](bool staged_validation, uint32_t prescore_sample_size,
+                uint32_t max_dense_validation, uint32_t refine_iteration,
+                int32_t seed) {
+            return std::unique_ptr<RANSACValidationOption>(new RANSACValidationOption(staged_validation, prescore_sample_size,
+                    max_dense_validation, refine_iteration, seed));
+        }), "staged_validation"_a = false, "prescore_sample_size"_a = 0,
+                "max_dense_validation"_a = 10, "refine_iteration"_a = 30,
+                "seed"_a = -1)
+        .def_readwrite("staged_validation",
+                &RANSACValidationOption::staged_validation_)
+        .def_readwrite("prescore_sample_size",
+                &RANSACValidationOption::prescore_sample_size_)
+        .def_readwrite("max_dense_validation",
+                &RANSACValidationOption::max_dense_validation_)
+        .def_readwrite("refine_iteration",
+                &RANSACValidationOption::refine_iteration_)
+        .def_readwrite("seed", &RANSACValidationOption::seed_)
+        .def("__repr__", [](const RANSACValidationOption &c) {
+            return std::string("RANSACValidationOption class with ") +
+                    std::string("staged_validation = ") +
+                    std::to_string(c.staged_validation_) +
+                    std::string(", prescore_sample_size = ") +
+                    std::to_string(c.prescore_sample_size_) +
+                    std::string(", max_dense_validation = ") +
+                    std::to_string(c.max_dense_validation_) +
+                    std::string(", refine_iteration = ") +
+                    std::to_string(c.refine_iteration_) +
+                    std::string(", and seed = ") +
+                    std::to_string(c.seed_);
+        });
+
     py::class_<TransformationEstimation,
             PyTransformationEstimation<TransformationEstimation>>
             te(m, "TransformationEstimation");
@@ -263,6 +299,38 @@ void pybind_registration(py::module &m)
                     std::to_string(c.maximum_tuple_count_);
         });
 
+    py::class_<RegistrationTarget, std::shared_ptr<RegistrationTarget>>
+            registration_target(m, "RegistrationTarget");
+    registration_target
+        .def(py::init<const PointCloud &>(), "target"_a)
+        .def("prepare_normals", &RegistrationTarget::PrepareNormals,
+                "Function to estimate normals if the target has none",
+                "search_param"_a = KDTreeSearchParamKNN())
+        .def("prepare_color_gradients",
+                &RegistrationTarget::PrepareColorGradients,
+                "Function to compute the color gradients used by colored ICP",
+                "search_param"_a)
+        .def("has_color_gradients", &RegistrationTarget::HasColorGradients)
+        .def_readonly("point_cloud", &RegistrationTarget::pointcloud_)
+        .def("__repr__", [](const RegistrationTarget &t) {
+            return std::string("RegistrationTarget with ") +
+                    std::to_string(t.pointcloud_->points_.size()) +
+                    std::string(" points.");
+        });
+
+    py::class_<MultiScaleICPTarget, std::shared_ptr<MultiScaleICPTarget>>
+            multi_scale_target(m, "MultiScaleICPTarget");
+    multi_scale_target
+        .def(py::init<const PointCloud &, const std::vector<double> &>(),
+                "target"_a, "voxel_sizes"_a)
+        .def("number_of_levels", &MultiScaleICPTarget::NumberOfLevels)
+        .def_readonly("voxel_sizes", &MultiScaleICPTarget::voxel_sizes_)
+        .def("__repr__", [](const MultiScaleICPTarget &t) {
+            return std::string("MultiScaleICPTarget with ") +
+                    std::to_string(t.NumberOfLevels()) +
+                    std::string(" levels.");
+        });
+
     py::class_<RegistrationResult> registration_result(m, "RegistrationResult");
     py::detail::bind_default_constructor<RegistrationResult>(
             registration_result);
@@ -286,22 +354,77 @@ void pybind_registration(py::module &m)
 
 void pybind_registration_methods(py::module &m)
 {
-    m.def("evaluate_registration", &EvaluateRegistration,
+    m.def("evaluate_registration", (RegistrationResult (*)(
+            const PointCloud &, const PointCloud &, double,
+            const Eigen::Matrix4d &))&EvaluateRegistration,
             "Function for evaluating registration between point clouds",
             "source"_a, "target"_a, "max_correspondence_distance"_a,
             "transformation"_a = Eigen::Matrix4d::Identity());
-    m.def("registration_icp", &RegistrationICP,
+    m.def("evaluate_registration", (RegistrationResult (*)(
+            const PointCloud &, const RegistrationTarget &, double,
+            const Eigen::Matrix4d &))&EvaluateRegistration,
+            "Function for evaluating registration with a prepared target",
+            "source"_a, "target"_a, "max_correspondence_distance"_a,
+            "transformation"_a = Eigen::Matrix4d::Identity());
+    m.def("registration_icp", (RegistrationResult (*)(
+            const PointCloud &, const PointCloud &, double,
+            const Eigen::Matrix4d &, const TransformationEstimation &,
+            const ICPConvergenceCriteria &))&RegistrationICP,
             "Function for ICP registration",
             "source"_a, "target"_a, "max_correspondence_distance"_a,
             "init"_a = Eigen::Matrix4d::Identity(), "estimation_method"_a =
             TransformationEstimationPointToPoint(false), "criteria"_a =
             ICPConvergenceCriteria());
-    m.def("registration_colored_icp", &RegistrationColoredICP,
+    m.def("registration_icp", (RegistrationResult (*)(
+            const PointCloud &, const RegistrationTarget &, double,
+            const Eigen::Matrix4d &, const TransformationEstimation &,
+            const ICPConvergenceCriteria &))&RegistrationICP,
+            "Function for ICP registration with a prepared target",
+            "source"_a, "target"_a, "max_correspondence_distance"_a,
+            "init"_a = Eigen::Matrix4d::Identity(), "estimation_method"_a =
+            TransformationEstimationPointToPoint(false), "criteria"_a =
+            ICPConvergenceCriteria());
+    m.def("registration_multi_scale_icp", (RegistrationResult (*)(
+            const PointCloud &, const MultiScaleICPTarget &,
+            const std::vector<double> &, const Eigen::Matrix4d &,
+            const TransformationEstimation &,
+            const std::vector<ICPConvergenceCriteria> &))
+            &RegistrationMultiScaleICP,
+            "Function for multi-scale ICP registration with a prepared target",
+            "source"_a, "target"_a, "max_correspondence_distances"_a,
+            "init"_a = Eigen::Matrix4d::Identity(), "estimation_method"_a =
+            TransformationEstimationPointToPoint(false), "criteria"_a =
+            std::vector<ICPConvergenceCriteria>());
+    m.def("registration_multi_scale_icp", (RegistrationResult (*)(
+            const PointCloud &, const PointCloud &,
+            const std::vector<double> &, const std::vector<double> &,
+            const Eigen::Matrix4d &, const TransformationEstimation &,
+            const std::vector<ICPConvergenceCriteria> &))
+            &RegistrationMultiScaleICP,
+            "Function for multi-scale ICP registration",
+            "source"_a, "target"_a, "voxel_sizes"_a,
+            "max_correspondence_distances"_a,
+            "init"_a = Eigen::Matrix4d::Identity(), "estimation_method"_a =
+            TransformationEstimationPointToPoint(false), "criteria"_a =
+            std::vector<ICPConvergenceCriteria>());
+    m.def("registration_colored_icp", (RegistrationResult (*)(
+            const PointCloud &, const PointCloud &, double,
+            const Eigen::Matrix4d &, const ICPConvergenceCriteria &, double))
+            &RegistrationColoredICP,
             "Function for Colored ICP registration",
             "source"_a, "target"_a, "max_correspondence_distance"_a,
             "init"_a = Eigen::Matrix4d::Identity(),
             "criteria"_a = ICPConvergenceCriteria(),
             "lambda_geometric"_a = 0.968);
+    m.def("registration_colored_icp", (RegistrationResult (*)(
+            const PointCloud &, const RegistrationTarget &, double,
+            const Eigen::Matrix4d &, const ICPConvergenceCriteria &, double))
+            &RegistrationColoredICP,
+            "Function for Colored ICP registration with a prepared target",
+            "source"_a, "target"_a, "max_correspondence_distance"_a,
+            "init"_a = Eigen::Matrix4d::Identity(),
+            "criteria"_a = ICPConvergenceCriteria(),
+            "lambda_geometric"_a = 0.968);
     m.def("registration_ransac_based_on_correspondence",
             &RegistrationRANSACBasedOnCorrespondence,
             "Function for global RANSAC registration based on a set of correspondences",
@@ -316,15 +439,23 @@ void pybind_registration_methods(py::module &m)
             TransformationEstimationPointToPoint(false), "ransac_n"_a = 4,
             "checkers"_a = std::vector<std::reference_wrapper<const
             CorrespondenceChecker>>(), "criteria"_a =
-            RANSACConvergenceCriteria(100000, 100));
+            RANSACConvergenceCriteria(100000, 100), "validation"_a =
+            RANSACValidationOption());
     m.def("registration_fast_based_on_feature_matching",
             &FastGlobalRegistration,
             "Function for fast global registration based on feature matching",
             "source"_a, "target"_a, "source_feature"_a, "target_feature"_a,
             "option"_a = FastGlobalRegistrationOption());
-    m.def("get_information_matrix_from_point_clouds",
-            &GetInformationMatrixFromPointClouds,
+    m.def("get_information_matrix_from_point_clouds", (Eigen::Matrix6d (*)(
+            const PointCloud &, const PointCloud &, double,
+            const Eigen::Matrix4d &))&GetInformationMatrixFromPointClouds,
             "Function for computing information matrix from RegistrationResult",
             "source"_a, "target"_a, "max_correspondence_distance"_a,
             "transformation_result"_a);
+    m.def("get_information_matrix_from_point_clouds", (Eigen::Matrix6d (*)(
+            const PointCloud &, const RegistrationTarget &, double,
+            const Eigen::Matrix4d &))&GetInformationMatrixFromPointClouds,
+            "Function for computing information matrix with a prepared target",
+            "source"_a, "target"_a, "max_correspondence_distance"_a,
+            "transformation_result"_a);
 }
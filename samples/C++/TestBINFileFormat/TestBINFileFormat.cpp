@@ -0,0 +1,238 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <Open3D/Core/Core.h>
+#include <Open3D/Core/Registration/PoseGraph.h>
+#include <Open3D/IO/IO.h>
+
+using namespace open3d;
+
+PoseGraph CreateRandomPoseGraph(int32_t node_num, int32_t edge_num)
+{
+    PoseGraph pose_graph;
+    for (int32_t i = 0; i < node_num; i++) {
+        pose_graph.nodes_.push_back(PoseGraphNode(Eigen::Matrix4d::Random()));
+    }
+    for (int32_t i = 0; i < edge_num; i++) {
+        pose_graph.edges_.push_back(PoseGraphEdge(i % node_num,
+                (i * 7 + 1) % node_num, Eigen::Matrix4d::Random(),
+                Eigen::Matrix6d::Random(), i % 3 == 0, (i % 10) / 10.0));
+    }
+    return pose_graph;
+}
+
+bool IsSamePoseGraph(const PoseGraph &a, const PoseGraph &b)
+{
+    if (a.nodes_.size() != b.nodes_.size() ||
+            a.edges_.size() != b.edges_.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.nodes_.size(); i++) {
+        if (a.nodes_[i].pose_ != b.nodes_[i].pose_) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.edges_.size(); i++) {
+        const PoseGraphEdge &x = a.edges_[i], &y = b.edges_[i];
+        if (x.source_node_id_ != y.source_node_id_ ||
+                x.target_node_id_ != y.target_node_id_ ||
+                x.transformation_ != y.transformation_ ||
+                x.information_ != y.information_ ||
+                x.uncertain_ != y.uncertain_ ||
+                x.confidence_ != y.confidence_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Function to drop the last bytes of a file, as an interrupted append would
+bool CutFile(const std::string &filename, size_t bytes)
+{
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+    std::vector<char> buffer;
+    char block[4096];
+    size_t read_size;
+    while ((read_size = fread(block, 1, sizeof(block), file)) > 0) {
+        buffer.insert(buffer.end(), block, block + read_size);
+    }
+    fclose(file);
+    if (buffer.size() < bytes) {
+        return false;
+    }
+    file = fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        return false;
+    }
+    size_t size = buffer.size() - bytes;
+    bool success = fwrite(buffer.data(), 1, size, file) == size;
+    fclose(file);
+    return success;
+}
+
+bool TestPoseGraph()
+{
+    const std::string filename = "test_pose_graph.bin";
+    PoseGraph pose_graph = CreateRandomPoseGraph(100, 300);
+    PoseGraph pose_graph_read;
+    if (!WritePoseGraph(filename, pose_graph) ||
+            !ReadPoseGraph(filename, pose_graph_read) ||
+            !IsSamePoseGraph(pose_graph, pose_graph_read) ||
+            filesystem::FileExists(filename + ".tmp")) {
+        PrintWarning("PoseGraph round trip failed.\n");
+        return false;
+    }
+
+    // Append the graph in two parts. Nodes and edges are read back in the
+    // order of the chunks, which is the order of the whole graph.
+    filesystem::RemoveFile(filename);
+    PoseGraph part[2];
+    for (int32_t k = 0; k < 2; k++) {
+        part[k].nodes_.assign(pose_graph.nodes_.begin() + k * 50,
+                pose_graph.nodes_.begin() + (k + 1) * 50);
+        part[k].edges_.assign(pose_graph.edges_.begin() + k * 150,
+                pose_graph.edges_.begin() + (k + 1) * 150);
+        if (!AppendPoseGraphToBIN(filename, part[k])) {
+            PrintWarning("PoseGraph append failed.\n");
+            return false;
+        }
+    }
+    if (!ReadPoseGraph(filename, pose_graph_read) ||
+            !IsSamePoseGraph(pose_graph, pose_graph_read)) {
+        PrintWarning("PoseGraph append round trip failed.\n");
+        return false;
+    }
+
+    // An interrupted append leaves an incomplete record. The complete records
+    // stay readable, and the next append cuts back the incomplete one.
+    PoseGraph pose_graph_cut;
+    if (!CutFile(filename, 7) ||
+            !ReadPoseGraph(filename, pose_graph_cut) ||
+            pose_graph_cut.nodes_.size() != 100 ||
+            pose_graph_cut.edges_.size() != 299) {
+        PrintWarning("Truncated PoseGraph read failed.\n");
+        return false;
+    }
+    pose_graph_cut.nodes_.insert(pose_graph_cut.nodes_.end(),
+            part[1].nodes_.begin(), part[1].nodes_.end());
+    pose_graph_cut.edges_.insert(pose_graph_cut.edges_.end(),
+            part[1].edges_.begin(), part[1].edges_.end());
+    if (!AppendPoseGraphToBIN(filename, part[1]) ||
+            !ReadPoseGraph(filename, pose_graph_read) ||
+            !IsSamePoseGraph(pose_graph_cut, pose_graph_read)) {
+        PrintWarning("PoseGraph append after truncation failed.\n");
+        return false;
+    }
+    PrintInfo("PoseGraph: %d nodes and %d edges after repair\n",
+            (int32_t)pose_graph_read.nodes_.size(),
+            (int32_t)pose_graph_read.edges_.size());
+    return true;
+}
+
+bool TestTrajectory()
+{
+    const std::string filename = "test_trajectory.bin";
+    PinholeCameraTrajectory trajectory;
+    trajectory.intrinsic_ = PinholeCameraIntrinsic::GetPrimeSenseDefault();
+    for (int32_t i = 0; i < 10; i++) {
+        trajectory.extrinsic_.push_back(Eigen::Matrix4d::Random());
+    }
+    PinholeCameraTrajectory trajectory_read;
+    if (!WritePinholeCameraTrajectory(filename, trajectory) ||
+            !ReadPinholeCameraTrajectory(filename, trajectory_read) ||
+            trajectory_read.extrinsic_ != trajectory.extrinsic_ ||
+            trajectory_read.intrinsic_.width_ != trajectory.intrinsic_.width_ ||
+            trajectory_read.intrinsic_.intrinsic_matrix_ !=
+            trajectory.intrinsic_.intrinsic_matrix_) {
+        PrintWarning("Trajectory round trip failed.\n");
+        return false;
+    }
+
+    // Cut into the last record, then append the trajectory once more
+    if (!CutFile(filename, 5) ||
+            !AppendPinholeCameraTrajectoryToBIN(filename, trajectory) ||
+            !ReadPinholeCameraTrajectory(filename, trajectory_read) ||
+            trajectory_read.extrinsic_.size() != 19) {
+        PrintWarning("Trajectory append after truncation failed.\n");
+        return false;
+    }
+    for (size_t i = 0; i < 19; i++) {
+        if (trajectory_read.extrinsic_[i] !=
+                trajectory.extrinsic_[i < 9 ? i : i - 9]) {
+            PrintWarning("Trajectory append after truncation failed.\n");
+            return false;
+        }
+    }
+    PrintInfo("Trajectory: %d poses after repair\n",
+            (int32_t)trajectory_read.extrinsic_.size());
+    return true;
+}
+
+bool TestInvalidFiles()
+{
+    // A file of another format or a missing file is rejected
+    PoseGraph pose_graph;
+    PinholeCameraTrajectory trajectory;
+    bool success = !ReadPoseGraphFromBIN("test_trajectory.bin", pose_graph) &&
+            !ReadPinholeCameraTrajectoryFromBIN("test_pose_graph.bin",
+            trajectory) &&
+            !ReadPoseGraphFromBIN("test_missing.bin", pose_graph) &&
+            CreateScalableTSDFVolumeFromBIN("test_pose_graph.bin") == NULL &&
+            CreateUniformTSDFVolumeFromBIN("test_missing.bin") == NULL;
+    if (!success) {
+        PrintWarning("Invalid files are not rejected.\n");
+    }
+    return success;
+}
+
+int32_t main(int32_t argc, char **argv)
+{
+    SetVerbosityLevel(VerbosityLevel::VerboseAlways);
+
+    if (argc != 1) {
+        PrintInfo("Usage:\n");
+        PrintInfo("    > TestBINFileFormat\n");
+        PrintInfo("    The program will :\n");
+        PrintInfo("    1) Write and read a random PoseGraph as test_pose_graph.bin\n");
+        PrintInfo("    2) Append it in two parts, cut the file and append again\n");
+        PrintInfo("    3) Do the same with a trajectory in test_trajectory.bin\n");
+        PrintInfo("    4) Check that files of the wrong format are rejected\n");
+        return 0;
+    }
+
+    bool success = TestPoseGraph();
+    success = TestTrajectory() && success;
+    success = TestInvalidFiles() && success;
+    PrintInfo(success ? "Passed.\n" : "Failed.\n");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <Eigen/Dense>
+
+#include <Open3D/Core/Core.h>
+#include <Open3D/Core/Registration/PoseGraph.h>
+#include <Open3D/Core/Registration/GlobalOptimization.h>
+
+using namespace open3d;
+
+/// Function to generate a trajectory along a circle, with odometry edges and
+/// loop closures measured with noise. A tenth of the loop closures are wrong.
+PoseGraph CreateNoisyPoseGraph(int32_t node_num,
+        std::vector<Eigen::Matrix4d> &ground_truth)
+{
+    std::mt19937 generator(0);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    auto perturb = [&](const Eigen::Matrix4d &transformation, double sigma) {
+        Eigen::Vector6d delta;
+        for (int32_t k = 0; k < 6; k++) {
+            delta(k) = noise(generator) * sigma;
+        }
+        return Eigen::Matrix4d(TransformVector6dToMatrix4d(delta) *
+                transformation);
+    };
+
+    ground_truth.clear();
+    for (int32_t i = 0; i < node_num; i++) {
+        Eigen::Vector6d pose;
+        pose << 0.3 * std::sin(i * 0.05), 0.01 * i, 0.2 * std::cos(i * 0.03),
+                2.0 * std::cos(i * 0.02), 2.0 * std::sin(i * 0.02), 0.01 * i;
+        ground_truth.push_back(TransformVector6dToMatrix4d(pose));
+    }
+    Eigen::Matrix6d information = Eigen::Matrix6d::Identity() * 1000.0;
+    PoseGraph pose_graph;
+    Eigen::Matrix4d pose = ground_truth[0];
+    pose_graph.nodes_.push_back(PoseGraphNode(pose));
+    for (int32_t i = 0; i + 1 < node_num; i++) {
+        Eigen::Matrix4d odometry = perturb(ground_truth[i + 1].inverse() *
+                ground_truth[i], 0.003);
+        pose_graph.edges_.push_back(PoseGraphEdge(i, i + 1, odometry,
+                information, false));
+        pose = pose * odometry.inverse();
+        pose_graph.nodes_.push_back(PoseGraphNode(pose));
+    }
+    std::uniform_int_distribution<int32_t> node(0, node_num - 1);
+    for (int32_t k = 0; k < node_num / 2; k++) {
+        int32_t source = node(generator), target = node(generator);
+        if (std::abs(source - target) < 2) continue;
+        Eigen::Matrix4d loop = perturb(ground_truth[target].inverse() *
+                ground_truth[source], k % 10 == 0 ? 0.5 : 0.003);
+        pose_graph.edges_.push_back(PoseGraphEdge(source, target, loop,
+                information, true));
+    }
+    return pose_graph;
+}
+
+/// Function to return the mean translation error of the nodes after aligning
+/// the first node with the ground truth
+double ComputeTrajectoryError(const PoseGraph &pose_graph,
+        const std::vector<Eigen::Matrix4d> &ground_truth)
+{
+    Eigen::Matrix4d alignment = ground_truth[0] *
+            pose_graph.nodes_[0].pose_.inverse();
+    double error = 0.0;
+    for (size_t i = 0; i < ground_truth.size(); i++) {
+        Eigen::Matrix4d pose = alignment * pose_graph.nodes_[i].pose_;
+        error += (pose.block<3, 1>(0, 3) -
+                ground_truth[i].block<3, 1>(0, 3)).norm();
+    }
+    return error / ground_truth.size();
+}
+
+double ComputeMaxDifference(const PoseGraph &a, const PoseGraph &b)
+{
+    double difference = 0.0;
+    for (size_t i = 0; i < a.nodes_.size(); i++) {
+        difference = std::max(difference,
+                (a.nodes_[i].pose_ - b.nodes_[i].pose_).cwiseAbs().maxCoeff());
+    }
+    return difference;
+}
+
+int32_t main(int32_t argc, char **argv)
+{
+    SetVerbosityLevel(VerbosityLevel::VerboseInfo);
+
+    if (argc != 1) {
+        PrintInfo("Usage:\n");
+        PrintInfo("    > TestGlobalOptimization\n");
+        PrintInfo("    The program will :\n");
+        PrintInfo("    1) Generate a noisy PoseGraph with wrong loop closures\n");
+        PrintInfo("    2) Optimize it with every linear solver, Gauss-Newton and Levenberg-Marquardt\n");
+        PrintInfo("    3) Check that the solvers agree and that the reference node is fixed\n");
+        PrintInfo("    4) Optimize it hierarchically and incrementally\n");
+        return 0;
+    }
+
+    std::vector<Eigen::Matrix4d> ground_truth;
+    const PoseGraph pose_graph = CreateNoisyPoseGraph(200, ground_truth);
+    const double initial_error = ComputeTrajectoryError(pose_graph,
+            ground_truth);
+    PrintInfo("Initial error: %f\n", initial_error);
+    GlobalOptimizationConvergenceCriteria criteria;
+    bool success = true;
+
+    // Every linear solver must give the same optimum
+    const GlobalOptimizationOption::LinearSolverType solvers[3] = {
+            GlobalOptimizationOption::LinearSolverType::Dense,
+            GlobalOptimizationOption::LinearSolverType::SparseCholesky,
+            GlobalOptimizationOption::LinearSolverType::ConjugateGradient};
+    const char *solver_names[3] = {"Dense", "SparseCholesky",
+            "ConjugateGradient"};
+    for (int32_t lm = 0; lm < 2; lm++) {
+        PoseGraph reference;
+        for (int32_t s = 0; s < 3; s++) {
+            PoseGraph optimized = pose_graph;
+            GlobalOptimizationOption option(0.075, 0.25, -1, solvers[s]);
+            if (lm) {
+                GlobalOptimization(optimized,
+                        GlobalOptimizationLevenbergMarquardt(), criteria,
+                        option);
+            } else {
+                GlobalOptimization(optimized, GlobalOptimizationGaussNewton(),
+                        criteria, option);
+            }
+            double error = ComputeTrajectoryError(optimized, ground_truth);
+            double difference = s == 0 ? 0.0 :
+                    ComputeMaxDifference(reference, optimized);
+            PrintInfo("%s, %s: error %f, difference to Dense %e\n",
+                    lm ? "Levenberg-Marquardt" : "Gauss-Newton",
+                    solver_names[s], error, difference);
+            success = success && error < initial_error * 0.5 &&
+                    difference < 1e-4;
+            if (s == 0) {
+                reference = optimized;
+            }
+        }
+    }
+
+    // The reference node is the gauge and must not move
+    for (int32_t reference_node : {0, 57, 199}) {
+        PoseGraph optimized = pose_graph;
+        GlobalOptimizationOption option(0.075, 0.25, reference_node);
+        GlobalOptimization(optimized, GlobalOptimizationGaussNewton(),
+                criteria, option);
+        double difference = (optimized.nodes_[reference_node].pose_ -
+                pose_graph.nodes_[reference_node].pose_).cwiseAbs().maxCoeff();
+        double error = ComputeTrajectoryError(optimized, ground_truth);
+        PrintInfo("Reference node %d: error %f, moved by %e\n",
+                reference_node, error, difference);
+        success = success && error < initial_error * 0.5 &&
+                difference < 1e-9;
+    }
+
+    {
+        PoseGraph optimized = pose_graph;
+        GlobalOptimization(optimized, GlobalOptimizationHierarchical(50),
+                criteria, GlobalOptimizationOption(0.075, 0.25, 0));
+        double difference = (optimized.nodes_[0].pose_ -
+                pose_graph.nodes_[0].pose_).cwiseAbs().maxCoeff();
+        double error = ComputeTrajectoryError(optimized, ground_truth);
+        PrintInfo("Hierarchical: error %f, reference node moved by %e\n",
+                error, difference);
+        success = success && error < initial_error * 0.5 &&
+                difference < 1e-9;
+    }
+
+    {
+        // Add the nodes and edges in order, updating after every node
+        IncrementalGlobalOptimization incremental(criteria,
+                GlobalOptimizationOption());
+        for (size_t i = 0; i < pose_graph.nodes_.size(); i++) {
+            incremental.AddNode(pose_graph.nodes_[i]);
+            for (const auto &edge : pose_graph.edges_) {
+                int32_t newest = std::max(edge.source_node_id_,
+                        edge.target_node_id_);
+                if (newest == (int32_t)i && !incremental.AddEdge(edge)) {
+                    success = false;
+                }
+            }
+            incremental.Update();
+        }
+        const PoseGraph &optimized = incremental.GetPoseGraph();
+        double error = ComputeTrajectoryError(optimized, ground_truth);
+        PrintInfo("Incremental: %d edges, error %f\n",
+                (int32_t)optimized.edges_.size(), error);
+        success = success &&
+                optimized.edges_.size() == pose_graph.edges_.size() &&
+                error < initial_error * 0.5 &&
+                optimized.nodes_[0].pose_ == pose_graph.nodes_[0].pose_;
+    }
+
+    PrintInfo(success ? "Passed.\n" : "Failed.\n");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+
+#include <Open3D/Core/Core.h>
+#include <Open3D/Core/Odometry/Odometry.h>
+#include <Open3D/IO/IO.h>
+
+using namespace open3d;
+
+int32_t main(int32_t argc, char **argv)
+{
+    SetVerbosityLevel(VerbosityLevel::VerboseInfo);
+
+    if (argc != 2) {
+        PrintInfo("Usage:\n");
+        PrintInfo("    > TestOdometryFrame [rgbd.match]\n");
+        PrintInfo("    The program will :\n");
+        PrintInfo("    1) Compute odometry between consecutive RGBD images\n");
+        PrintInfo("    2) Compute it again from OdometryFrames, reusing every frame for two pairs\n");
+        PrintInfo("    3) Check that the results are the same\n");
+        return 0;
+    }
+
+    std::string dir_name = filesystem::GetFileParentDirectory(argv[1]);
+    FILE *file = fopen(argv[1], "r");
+    if (file == NULL) {
+        PrintError("Unable to open file %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<std::shared_ptr<RGBDImage>> images;
+    char buffer[DEFAULT_IO_BUFFER_SIZE];
+    while (fgets(buffer, DEFAULT_IO_BUFFER_SIZE, file)) {
+        std::vector<std::string> st;
+        SplitString(st, buffer, "\t\r\n ");
+        if (st.size() >= 2) {
+            Image depth, color;
+            ReadImage(dir_name + st[0], depth);
+            ReadImage(dir_name + st[1], color);
+            images.push_back(CreateRGBDImageFromColorAndDepth(color, depth,
+                    1000.0, 4.0, true));
+        }
+    }
+    fclose(file);
+    if (images.size() < 2) {
+        PrintError("Less than two RGBD images in %s\n", argv[1]);
+        return 1;
+    }
+
+    auto intrinsic = PinholeCameraIntrinsic::GetPrimeSenseDefault();
+    OdometryOption option;
+    RGBDOdometryJacobianFromHybridTerm jacobian;
+    bool success = true;
+    auto source_frame = std::make_shared<OdometryFrame>(*images[0],
+            intrinsic, option);
+    for (size_t i = 0; i + 1 < images.size(); i++) {
+        auto target_frame = std::make_shared<OdometryFrame>(*images[i + 1],
+                intrinsic, option);
+        bool success_image, success_frame;
+        Eigen::Matrix4d trans_image, trans_frame;
+        Eigen::Matrix6d info_image, info_frame;
+        std::tie(success_image, trans_image, info_image) =
+                ComputeRGBDOdometry(*images[i], *images[i + 1], intrinsic,
+                Eigen::Matrix4d::Identity(), jacobian, option);
+        std::tie(success_frame, trans_frame, info_frame) =
+                ComputeRGBDOdometry(*source_frame, *target_frame,
+                Eigen::Matrix4d::Identity(), jacobian, option);
+        double difference = (trans_image - trans_frame).cwiseAbs().maxCoeff();
+        double info_difference = (info_image - info_frame).cwiseAbs().
+                maxCoeff() / std::max(1.0, info_image.cwiseAbs().maxCoeff());
+        PrintInfo("Pair %d: images %d, frames %d, max difference %e, information %e\n",
+                (int32_t)i, success_image, success_frame, difference,
+                info_difference);
+        success = success && success_image && success_frame &&
+                difference < 1e-9 && info_difference < 1e-9;
+        source_frame = target_frame;
+    }
+    PrintInfo(success ? "Passed.\n" : "Failed.\n");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cmath>
+#include <Open3D/Core/Core.h>
+#include <Open3D/Core/Odometry/Odometry.h>
+#include <Open3D/IO/IO.h>
+
+using namespace open3d;
+
+/// Jacobian that only overrides the row function. The fused accumulation
+/// must call it instead of the batch kernel of its base class.
+template <class RGBDOdometryJacobianBase>
+class CountingJacobian : public RGBDOdometryJacobianBase
+{
+public:
+    void ComputeJacobianAndResidual(
+            size_t row, std::vector<Eigen::Vector6d> &J_r,
+            std::vector<double> &r,
+            const RGBDImage &source, const RGBDImage &target,
+            const Image &source_xyz,
+            const RGBDImage &target_dx, const RGBDImage &target_dy,
+            const Eigen::Matrix3d &intrinsic,
+            const Eigen::Matrix4d &extrinsic,
+            const CorrespondenceSetPixelWise &corresps) const override {
+        calls_++;
+        RGBDOdometryJacobianBase::ComputeJacobianAndResidual(row, J_r, r,
+                source, target, source_xyz, target_dx, target_dy, intrinsic,
+                extrinsic, corresps);
+    }
+
+public:
+    mutable std::atomic<int64_t> calls_{0};
+};
+
+template <class RGBDOdometryJacobianBase>
+bool CompareJacobians(const RGBDImage &source, const RGBDImage &target,
+        const PinholeCameraIntrinsic &intrinsic,
+        const RGBDOdometryJacobianBase &batch_jacobian,
+        const CountingJacobian<RGBDOdometryJacobianBase> &pixel_jacobian,
+        const std::string &name)
+{
+    OdometryOption option;
+    bool success_batch, success_pixel;
+    Eigen::Matrix4d trans_batch, trans_pixel;
+    Eigen::Matrix6d info_batch, info_pixel;
+    std::tie(success_batch, trans_batch, info_batch) = ComputeRGBDOdometry(
+            source, target, intrinsic, Eigen::Matrix4d::Identity(),
+            batch_jacobian, option);
+    std::tie(success_pixel, trans_pixel, info_pixel) = ComputeRGBDOdometry(
+            source, target, intrinsic, Eigen::Matrix4d::Identity(),
+            pixel_jacobian, option);
+    double difference = (trans_batch - trans_pixel).cwiseAbs().maxCoeff();
+    PrintInfo("%s: batch %d, per-pixel %d, max difference %e, %lld row calls\n",
+            name.c_str(), success_batch, success_pixel, difference,
+            (long long)pixel_jacobian.calls_);
+    return success_batch && success_pixel && difference < 1e-4 &&
+            pixel_jacobian.calls_ > 0;
+}
+
+int32_t main(int32_t argc, char **argv)
+{
+    SetVerbosityLevel(VerbosityLevel::VerboseAlways);
+
+    if (argc != 5) {
+        PrintInfo("Usage:\n");
+        PrintInfo("    > TestRGBDOdometryJacobian [color_source] [depth_source] [color_target] [depth_target]\n");
+        PrintInfo("    The program will :\n");
+        PrintInfo("    1) Compute odometry with the batch kernels of the color and hybrid terms\n");
+        PrintInfo("    2) Compute odometry with subclasses that only override the row function\n");
+        PrintInfo("    3) Check that the subclasses are called and that the poses agree\n");
+        return 0;
+    }
+
+    auto color_source = CreateImageFromFile(argv[1]);
+    auto depth_source = CreateImageFromFile(argv[2]);
+    auto color_target = CreateImageFromFile(argv[3]);
+    auto depth_target = CreateImageFromFile(argv[4]);
+    auto source = CreateRGBDImageFromRedwoodFormat(*color_source,
+            *depth_source, true);
+    auto target = CreateRGBDImageFromRedwoodFormat(*color_target,
+            *depth_target, true);
+    auto intrinsic = PinholeCameraIntrinsic::GetPrimeSenseDefault();
+
+    bool success = true;
+    {
+        RGBDOdometryJacobianFromHybridTerm batch_jacobian;
+        CountingJacobian<RGBDOdometryJacobianFromHybridTerm> pixel_jacobian;
+        success = CompareJacobians(*source, *target, intrinsic,
+                batch_jacobian, pixel_jacobian, "Hybrid term") && success;
+    }
+    {
+        RGBDOdometryJacobianFromColorTerm batch_jacobian;
+        CountingJacobian<RGBDOdometryJacobianFromColorTerm> pixel_jacobian;
+        success = CompareJacobians(*source, *target, intrinsic,
+                batch_jacobian, pixel_jacobian, "Color term") && success;
+    }
+    PrintInfo(success ? "Passed.\n" : "Failed.\n");
+    return success ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+// ----------------------------------------------------------------------------
+// -                        Open3D: www.open-3d.org                            -
+// ----------------------------------------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2018, Intel Visual Computing Lab
+// Copyright (c) 2018, Open3D community
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+// ----------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <Eigen/Dense>
+
+#include <Open3D/Core/Core.h>
+#include <Open3D/IO/IO.h>
+
+using namespace open3d;
+
+/// Function to compare the voxels of two volumes unit by unit
+bool IsSameVoxels(const ScalableTSDFVolume &a, const ScalableTSDFVolume &b)
+{
+    if (a.volume_units_.NumberOfBlocks() != b.volume_units_.NumberOfBlocks() ||
+            a.volume_units_.BlockBytes() != b.volume_units_.BlockBytes()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.volume_units_.NumberOfBlocks(); i++) {
+        int32_t block_id = b.volume_units_.Find(
+                a.volume_units_.GetBlockIndex((int32_t)i));
+        if (block_id < 0 || memcmp(a.volume_units_.GetBlockData((int32_t)i),
+                b.volume_units_.GetBlockData(block_id),
+                a.volume_units_.BlockBytes()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double ComputeSurfaceArea(const TriangleMesh &mesh)
+{
+    double area = 0.0;
+    for (const auto &triangle : mesh.triangles_) {
+        const Eigen::Vector3d &v0 = mesh.vertices_[triangle(0)];
+        area += (mesh.vertices_[triangle(1)] - v0).cross(
+                mesh.vertices_[triangle(2)] - v0).norm() * 0.5;
+    }
+    return area;
+}
+
+bool TestVoxelFormat(ScalableTSDFVolume::VoxelFormat voxel_format,
+        const std::vector<std::shared_ptr<RGBDImage>> &frames,
+        const PinholeCameraTrajectory &trajectory, double &area)
+{
+    const double voxel_length = 4.0 / 512.0;
+    const double sdf_trunc = 0.04;
+    bool success = true;
+
+    ScalableTSDFVolume volume(voxel_length, sdf_trunc, true, 16, 4,
+            voxel_format);
+    for (size_t i = 0; i < frames.size(); i++) {
+        volume.Integrate(*frames[i], trajectory.intrinsic_,
+                trajectory.extrinsic_[i]);
+    }
+    auto mesh = volume.ExtractTriangleMesh();
+    area = ComputeSurfaceArea(*mesh);
+    PrintInfo("    %d volume units, %d triangles, surface area %f\n",
+            (int32_t)volume.NumberOfVolumeUnits(),
+            (int32_t)mesh->triangles_.size(), area);
+    if (mesh->triangles_.empty()) {
+        PrintWarning("    Empty mesh.\n");
+        success = false;
+    }
+
+    // Loading on a separate thread does not change the integration
+    ScalableTSDFVolume volume_sequence(voxel_length, sdf_trunc, true, 16, 4,
+            voxel_format);
+    int32_t integrated_num = volume_sequence.IntegrateSequence(
+            trajectory.intrinsic_, (int32_t)frames.size(),
+            [&](int32_t i, RGBDImage &image, Eigen::Matrix4d &extrinsic) {
+        image = *frames[i];
+        extrinsic = trajectory.extrinsic_[i];
+        return true;
+    });
+    if (integrated_num != (int32_t)frames.size() ||
+            !IsSameVoxels(volume, volume_sequence)) {
+        PrintWarning("    IntegrateSequence differs from Integrate.\n");
+        success = false;
+    }
+
+    // A failing loader ends the sequence and its exception is rethrown
+    ScalableTSDFVolume volume_failure(voxel_length, sdf_trunc, true, 16, 4,
+            voxel_format);
+    bool rethrown = false;
+    try {
+        volume_failure.IntegrateSequence(trajectory.intrinsic_,
+                (int32_t)frames.size(), [&](int32_t i, RGBDImage &image,
+                Eigen::Matrix4d &extrinsic) {
+            if (i == 2) {
+                throw std::runtime_error("unable to read frame 2");
+            }
+            image = *frames[i];
+            extrinsic = trajectory.extrinsic_[i];
+            return true;
+        });
+    } catch (const std::runtime_error &) {
+        rethrown = true;
+    }
+    if (!rethrown) {
+        PrintWarning("    The loader exception is not rethrown.\n");
+        success = false;
+    }
+
+    // Streaming moves the distant units to disk without changing them
+    ScalableTSDFVolume volume_streaming(voxel_length, sdf_trunc, true, 16, 4,
+            voxel_format);
+    if (!volume_streaming.EnableStreaming("test_volume_units.bin", 0.5)) {
+        PrintWarning("    Unable to enable streaming.\n");
+        return false;
+    }
+    for (size_t i = 0; i < frames.size(); i++) {
+        volume_streaming.Integrate(*frames[i], trajectory.intrinsic_,
+                trajectory.extrinsic_[i]);
+    }
+    auto mesh_streaming = volume_streaming.ExtractTriangleMesh();
+    PrintInfo("    Streaming: %d of %d volume units in memory\n",
+            (int32_t)volume_streaming.volume_units_.NumberOfBlocks(),
+            (int32_t)volume_streaming.NumberOfVolumeUnits());
+    ScalableTSDFVolume volume_loaded(volume_streaming);
+    if (!IsSameVoxels(volume, volume_loaded) ||
+            mesh_streaming->triangles_.size() != mesh->triangles_.size()) {
+        PrintWarning("    Streaming changes the volume.\n");
+        success = false;
+    }
+    volume_streaming.DisableStreaming();
+
+    // Checkpoint and resume
+    auto volume_read = std::shared_ptr<ScalableTSDFVolume>();
+    if (!WriteScalableTSDFVolume("test_scalable_tsdf.bin", volume) ||
+            (volume_read = CreateScalableTSDFVolumeFromFile(
+            "test_scalable_tsdf.bin")) == NULL ||
+            volume_read->voxel_format_ != voxel_format ||
+            !IsSameVoxels(volume, *volume_read)) {
+        PrintWarning("    ScalableTSDFVolume round trip failed.\n");
+        success = false;
+    }
+    return success;
+}
+
+bool TestUniformTSDFVolume(const std::vector<std::shared_ptr<RGBDImage>> &frames,
+        const PinholeCameraTrajectory &trajectory)
+{
+    UniformTSDFVolume volume(4.0, 128, 0.04, true);
+    for (size_t i = 0; i < frames.size(); i++) {
+        volume.Integrate(*frames[i], trajectory.intrinsic_,
+                trajectory.extrinsic_[i]);
+    }
+    auto volume_read = std::shared_ptr<UniformTSDFVolume>();
+    if (!WriteUniformTSDFVolume("test_uniform_tsdf.bin", volume) ||
+            (volume_read = CreateUniformTSDFVolumeFromFile(
+            "test_uniform_tsdf.bin")) == NULL ||
+            volume_read->resolution_ != volume.resolution_ ||
+            volume_read->origin_ != volume.origin_ ||
+            volume_read->tsdf_ != volume.tsdf_ ||
+            volume_read->weight_ != volume.weight_ ||
+            volume_read->color_ != volume.color_) {
+        PrintWarning("UniformTSDFVolume round trip failed.\n");
+        return false;
+    }
+    return true;
+}
+
+int32_t main(int32_t argc, char **argv)
+{
+    SetVerbosityLevel(VerbosityLevel::VerboseInfo);
+
+    if (argc != 3) {
+        PrintInfo("Usage:\n");
+        PrintInfo("    > TestScalableTSDFVolume [rgbd.match] [trajectory.log]\n");
+        PrintInfo("    The program will :\n");
+        PrintInfo("    1) Integrate the RGBD frames with every voxel format\n");
+        PrintInfo("    2) Integrate them again with IntegrateSequence and with streaming\n");
+        PrintInfo("    3) Check that the voxels are the same\n");
+        PrintInfo("    4) Write and read the volumes as test_scalable_tsdf.bin and test_uniform_tsdf.bin\n");
+        return 0;
+    }
+
+    auto trajectory = CreatePinholeCameraTrajectoryFromFile(argv[2]);
+    std::string dir_name = filesystem::GetFileParentDirectory(argv[1]);
+    FILE *file = fopen(argv[1], "r");
+    if (file == NULL) {
+        PrintError("Unable to open file %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<std::shared_ptr<RGBDImage>> frames;
+    char buffer[DEFAULT_IO_BUFFER_SIZE];
+    while (fgets(buffer, DEFAULT_IO_BUFFER_SIZE, file) &&
+            frames.size() < trajectory->extrinsic_.size()) {
+        std::vector<std::string> st;
+        SplitString(st, buffer, "\t\r\n ");
+        if (st.size() >= 2) {
+            Image depth, color;
+            ReadImage(dir_name + st[0], depth);
+            ReadImage(dir_name + st[1], color);
+            frames.push_back(CreateRGBDImageFromColorAndDepth(color, depth,
+                    1000.0, 4.0, false));
+        }
+    }
+    fclose(file);
+    if (frames.empty()) {
+        PrintError("No RGBD frames in %s\n", argv[1]);
+        return 1;
+    }
+
+    const ScalableTSDFVolume::VoxelFormat voxel_formats[3] = {
+            ScalableTSDFVolume::VoxelFormat::Float,
+            ScalableTSDFVolume::VoxelFormat::Compact16,
+            ScalableTSDFVolume::VoxelFormat::Compact8};
+    const char *voxel_format_names[3] = {"Float", "Compact16", "Compact8"};
+    bool success = true;
+    double area_float = 0.0;
+    for (int32_t k = 0; k < 3; k++) {
+        PrintInfo("%s voxels:\n", voxel_format_names[k]);
+        double area;
+        success = TestVoxelFormat(voxel_formats[k], frames, *trajectory,
+                area) && success;
+        // The compact formats quantize the tsdf, not the surface
+        if (k == 0) {
+            area_float = area;
+        } else if (std::abs(area - area_float) > area_float * 0.01) {
+            PrintWarning("    The surface differs from the Float voxels.\n");
+            success = false;
+        }
+    }
+    success = TestUniformTSDFVolume(frames, *trajectory) && success;
+    PrintInfo(success ? "Passed.\n" : "Failed.\n");
+    return success ? 0 : 1;
+}